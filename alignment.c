@@ -0,0 +1,433 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "src/alignment.h"
+#include "src/simd_edit_distance.h"
+#include "src/worker_pool.h"
+
+/*
+* Subproblems of at most BASE_CELLS cells are aligned from their full DP
+* matrix, kept in the worker's scratch.
+*/
+#define BASE_CELLS 4096
+
+/*
+* Rows with fewer cells than ROW_SIMD_CELLS are computed by a plain loop;
+* below that, starting up the wavefront costs more than it saves.
+*/
+#define ROW_SIMD_CELLS (1 << 12)
+
+/*
+* Subproblems with more cells than TASK_CELLS are split on the calling
+* thread, every worker helping with their rows. The ones at or below it
+* become tasks that a single worker aligns from start to finish.
+*/
+#define TASK_CELLS (1 << 22)
+
+/*
+* A subproblem: str1[a_off, a_off + m) against str2[b_off, b_off + n).
+*/
+typedef struct {
+	size_t a_off;
+	size_t m;
+	size_t b_off;
+	size_t n;
+	size_t num_ops;
+} AlignTask;
+
+typedef struct {
+	const char *str1;
+	const char *str2;
+	size_t len1;
+	size_t len2;
+
+	/*
+	* Every array is shared by all subproblems, each at its own offsets.
+	* Subproblems cover disjoint ranges of both strings, ordered along the
+	* alignment, so a subproblem at (a_off, b_off) writes its operations
+	* from ops[a_off + b_off] and its reversed strings at the same offsets
+	* as the originals. Task t keeps its rows at forward[b_off + t] and
+	* reverse[b_off + t], n + 1 values each.
+	*/
+	char *ops;
+	char *rev1;
+	char *rev2;
+	long *forward;
+	long *reverse;
+
+	AlignTask *tasks;
+	size_t num_tasks;
+	size_t task_capacity;
+	atomic_size_t next_task;
+	atomic_int failed;
+} AlignState;
+
+/*
+* row[j] = distance between a[0, m) and b[0, j) for every j in [0, n],
+* keeping a single row.
+*/
+static void scalar_row(const char *a, size_t m, const char *b, size_t n, long *row){
+	for(size_t j = 0; j <= n; j++){
+		row[j] = j;
+	}
+	for(size_t i = 1; i <= m; i++){
+		long diagonal = row[0];
+		row[0] = i;
+		for(size_t j = 1; j <= n; j++){
+			long above = row[j];
+			long cost = diagonal;
+			if(a[i-1] != b[j-1]){
+				cost = (above < cost) ? above : cost;
+				cost = (row[j-1] < cost) ? row[j-1] : cost;
+				cost++;
+			}
+			diagonal = above;
+			row[j] = cost;
+		}
+	}
+}
+
+static int last_row(const char *a, size_t m, const char *b, size_t n, long num_threads, long *row){
+	if((double)m * n < ROW_SIMD_CELLS){
+		scalar_row(a, m, b, n, row);
+		return 0;
+	}
+	WavefrontOptions options = {WAVEFRONT_SCHEDULE_DATAFLOW};
+	options.last_row = row;
+	return (simd_edit_distance_rect(a, m, b, n, num_threads, &options) < 0) ? -1 : 0;
+}
+
+/*
+* Hirschberg's split: str1's half of the subproblem ends at row *mid, and
+* an optimal alignment crosses that row at column *split. Returns -1 if a
+* row could not be computed.
+*/
+static int split_task(AlignState *state, const AlignTask *task, size_t slot, long num_threads,
+	size_t *mid, size_t *split){
+	const char *a = state->str1 + task->a_off;
+	const char *b = state->str2 + task->b_off;
+	size_t m = task->m;
+	size_t n = task->n;
+	size_t half = m / 2;
+	long *forward = state->forward + task->b_off + slot;
+	long *reverse = state->reverse + task->b_off + slot;
+
+	if(last_row(a, half, b, n, num_threads, forward) != 0){
+		return -1;
+	}
+
+	/*
+	* The lower half backwards: reverse[n - k] is the distance between
+	* a[half, m) and b[k, n).
+	*/
+	char *rev_a = state->rev1 + task->a_off + half;
+	char *rev_b = state->rev2 + task->b_off;
+	for(size_t i = 0; i < m - half; i++){
+		rev_a[i] = a[m - 1 - i];
+	}
+	for(size_t j = 0; j < n; j++){
+		rev_b[j] = b[n - 1 - j];
+	}
+	if(last_row(rev_a, m - half, rev_b, n, num_threads, reverse) != 0){
+		return -1;
+	}
+
+	size_t best = 0;
+	long best_cost = forward[0] + reverse[n];
+	for(size_t k = 1; k <= n; k++){
+		long cost = forward[k] + reverse[n - k];
+		if(cost < best_cost){
+			best_cost = cost;
+			best = k;
+		}
+	}
+	*mid = half;
+	*split = best;
+	return 0;
+}
+
+static size_t fill_ops(char *out, char op, size_t count){
+	memset(out, op, count);
+	return count;
+}
+
+/*
+* A single character c against all of s: match it at its first occurrence
+* (or substitute it for s's first character) and spend gap on the rest.
+*/
+static size_t align_single(char c, const char *s, size_t len, char gap, char *out){
+	const char *match = memchr(s, c, len);
+	if(match == NULL){
+		out[0] = 'X';
+		return 1 + fill_ops(out + 1, gap, len - 1);
+	}
+	size_t at = match - s;
+	size_t count = fill_ops(out, gap, at);
+	out[count++] = '=';
+	return count + fill_ops(out + count, gap, len - 1 - at);
+}
+
+/*
+* Aligns a small subproblem from its full matrix (at most BASE_CELLS
+* cells, in matrix). Writes the operations to out and returns their
+* number.
+*/
+static size_t align_base(const char *a, size_t m, const char *b, size_t n, int *matrix, char *out){
+	size_t width = n + 1;
+	for(size_t j = 0; j <= n; j++){
+		matrix[j] = j;
+	}
+	for(size_t i = 1; i <= m; i++){
+		int *row = &matrix[i * width];
+		const int *above = row - width;
+		row[0] = i;
+		for(size_t j = 1; j <= n; j++){
+			int cost = above[j-1];
+			if(a[i-1] != b[j-1]){
+				cost = (above[j] < cost) ? above[j] : cost;
+				cost = (row[j-1] < cost) ? row[j-1] : cost;
+				cost++;
+			}
+			row[j] = cost;
+		}
+	}
+
+	/*
+	* Trace back from the last cell, preferring the diagonal, then write
+	* the operations front to back.
+	*/
+	size_t count = 0;
+	size_t i = m, j = n;
+	while(i > 0 || j > 0){
+		int cost = matrix[i * width + j];
+		if(i > 0 && j > 0 && a[i-1] == b[j-1] && cost == matrix[(i-1) * width + j - 1]){
+			out[count++] = '=';
+			i--; j--;
+		}
+		else if(i > 0 && j > 0 && cost == matrix[(i-1) * width + j - 1] + 1){
+			out[count++] = 'X';
+			i--; j--;
+		}
+		else if(i > 0 && cost == matrix[(i-1) * width + j] + 1){
+			out[count++] = 'D';
+			i--;
+		}
+		else{
+			out[count++] = 'I';
+			j--;
+		}
+	}
+	for(size_t k = 0; k < count / 2; k++){
+		char temp = out[k];
+		out[k] = out[count - 1 - k];
+		out[count - 1 - k] = temp;
+	}
+	return count;
+}
+
+/*
+* Aligns a subproblem on the calling thread, writing its operations to
+* out. slot selects the task's row buffers. Returns the number of
+* operations, or -1 if a row could not be computed.
+*/
+static long align_task(AlignState *state, const AlignTask *task, size_t slot, int *matrix, char *out){
+	const char *a = state->str1 + task->a_off;
+	const char *b = state->str2 + task->b_off;
+	size_t m = task->m;
+	size_t n = task->n;
+
+	if(m == 0){
+		return fill_ops(out, 'I', n);
+	}
+	if(n == 0){
+		return fill_ops(out, 'D', m);
+	}
+	if(m == 1){
+		return align_single(a[0], b, n, 'I', out);
+	}
+	if(n == 1){
+		return align_single(b[0], a, m, 'D', out);
+	}
+	if((m + 1) * (n + 1) <= BASE_CELLS){
+		return align_base(a, m, b, n, matrix, out);
+	}
+
+	size_t mid, split;
+	if(split_task(state, task, slot, 1, &mid, &split) != 0){
+		return -1;
+	}
+	AlignTask upper = {task->a_off, mid, task->b_off, split, 0};
+	AlignTask lower = {task->a_off + mid, m - mid, task->b_off + split, n - split, 0};
+	long count = align_task(state, &upper, slot, matrix, out);
+	if(count < 0){
+		return -1;
+	}
+	long rest = align_task(state, &lower, slot, matrix, out + count);
+	return (rest < 0) ? -1 : count + rest;
+}
+
+/*
+* Splits the subproblem with every worker computing its rows until the
+* pieces are small enough to become tasks. Returns -1 on failure.
+*/
+static int plan_tasks(AlignState *state, const AlignTask *task, long num_threads){
+	if((double)task->m * task->n <= TASK_CELLS || task->m <= 1 || task->n <= 1){
+		if(state->num_tasks == state->task_capacity){
+			size_t capacity = 2 * state->task_capacity + 16;
+			AlignTask *tasks = realloc(state->tasks, capacity * sizeof(AlignTask));
+			if(tasks == NULL){
+				return -1;
+			}
+			state->tasks = tasks;
+			state->task_capacity = capacity;
+		}
+		state->tasks[state->num_tasks++] = *task;
+		return 0;
+	}
+
+	size_t mid, split;
+	if(split_task(state, task, 0, num_threads, &mid, &split) != 0){
+		return -1;
+	}
+	AlignTask upper = {task->a_off, mid, task->b_off, split, 0};
+	AlignTask lower = {task->a_off + mid, task->m - mid, task->b_off + split, task->n - split, 0};
+	if(plan_tasks(state, &upper, num_threads) != 0){
+		return -1;
+	}
+	return plan_tasks(state, &lower, num_threads);
+}
+
+/*
+* Worker task: takes the next unaligned task until there are none left.
+*/
+static void align_worker(void *args, int thread_id, void *scratch){
+	(void)thread_id;
+	AlignState *state = (AlignState*)args;
+	for(;;){
+		size_t t = atomic_fetch_add(&state->next_task, 1);
+		if(t >= state->num_tasks){
+			return;
+		}
+		AlignTask *task = &state->tasks[t];
+		long count = align_task(state, task, t, (int*)scratch, state->ops + task->a_off + task->b_off);
+		if(count < 0){
+			atomic_store(&state->failed, 1);
+			return;
+		}
+		task->num_ops = count;
+	}
+}
+
+/*
+* Joins the tasks' operations into one string and run-length encodes it.
+*/
+static long collect_runs(AlignState *state, Alignment *alignment){
+	size_t num_ops = 0;
+	for(size_t t = 0; t < state->num_tasks; t++){
+		const AlignTask *task = &state->tasks[t];
+		memmove(state->ops + num_ops, state->ops + task->a_off + task->b_off, task->num_ops);
+		num_ops += task->num_ops;
+	}
+
+	size_t num_runs = 0;
+	for(size_t k = 0; k < num_ops; k++){
+		num_runs += (k == 0 || state->ops[k] != state->ops[k-1]);
+	}
+	alignment->runs = malloc(num_runs * sizeof(EditRun) + 1);
+	if(alignment->runs == NULL){
+		return -1;
+	}
+
+	size_t run = 0;
+	long distance = 0;
+	for(size_t k = 0; k < num_ops; k++){
+		if(k == 0 || state->ops[k] != state->ops[k-1]){
+			alignment->runs[run++] = (EditRun){state->ops[k], 0};
+		}
+		alignment->runs[run - 1].length++;
+		distance += (state->ops[k] != '=');
+	}
+	alignment->num_runs = num_runs;
+	alignment->distance = distance;
+	return distance;
+}
+
+long edit_distance_align(const char *str1, size_t len1, const char *str2, size_t len2,
+	long num_threads, Alignment *alignment){
+	alignment->distance = 0;
+	alignment->runs = NULL;
+	alignment->num_runs = 0;
+	if(num_threads < 1){
+		num_threads = 1;
+	}
+
+	AlignState state = {0};
+	state.str1 = str1;
+	state.str2 = str2;
+	state.len1 = len1;
+	state.len2 = len2;
+	state.ops = malloc(len1 + len2 + 1);
+	state.rev1 = malloc(len1 + 1);
+	state.rev2 = malloc(len2 + 1);
+	state.forward = malloc((len2 + 1) * sizeof(long));
+	state.reverse = malloc((len2 + 1) * sizeof(long));
+	atomic_init(&state.next_task, 0);
+	atomic_init(&state.failed, 0);
+
+	long result = -1;
+	AlignTask whole = {0, len1, 0, len2, 0};
+	if(state.ops != NULL && state.rev1 != NULL && state.rev2 != NULL && state.forward != NULL
+		&& state.reverse != NULL && plan_tasks(&state, &whole, num_threads) == 0){
+		/*
+		* From here on every task needs its own rows (see AlignState).
+		*/
+		size_t row_count = len2 + state.num_tasks + 1;
+		long *forward = realloc(state.forward, row_count * sizeof(long));
+		state.forward = (forward != NULL) ? forward : state.forward;
+		long *reverse = realloc(state.reverse, row_count * sizeof(long));
+		state.reverse = (reverse != NULL) ? reverse : state.reverse;
+
+		long workers = ((size_t)num_threads < state.num_tasks) ? num_threads : (long)state.num_tasks;
+		WorkerPool *pool = (forward != NULL && reverse != NULL) ? worker_pool_create(workers) : NULL;
+		if(pool != NULL && worker_pool_run(pool, align_worker, &state, BASE_CELLS * sizeof(int)) == 0
+			&& !atomic_load(&state.failed)){
+			result = collect_runs(&state, alignment);
+		}
+		worker_pool_destroy(pool);
+	}
+	if(result < 0){
+		printf("Failed to allocate memory in edit_distance_align().");
+	}
+
+	free(state.ops);
+	free(state.rev1);
+	free(state.rev2);
+	free(state.forward);
+	free(state.reverse);
+	free(state.tasks);
+	return result;
+}
+
+void alignment_free(Alignment *alignment){
+	free(alignment->runs);
+	alignment->runs = NULL;
+	alignment->num_runs = 0;
+}
+
+size_t alignment_cigar(const Alignment *alignment, char *buffer, size_t size){
+	size_t length = 0;
+	for(size_t r = 0; r < alignment->num_runs; r++){
+		char run[32];
+		int written = snprintf(run, sizeof(run), "%zu%c", alignment->runs[r].length, alignment->runs[r].op);
+		for(int k = 0; k < written; k++, length++){
+			if(length + 1 < size){
+				buffer[length] = run[k];
+			}
+		}
+	}
+	if(size > 0){
+		buffer[(length < size) ? length : size - 1] = '\0';
+	}
+	return length;
+}
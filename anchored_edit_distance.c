@@ -0,0 +1,335 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include "src/anchored_edit_distance.h"
+#include "src/common_affix.h"
+#include "src/batch_edit_distance.h"
+#include "src/simd_edit_distance.h"
+#include "src/boundary.h"
+
+#define HASH_BASE 0x100000001b3ULL
+#define HASH_MIX 0x9E3779B97F4A7C15ULL
+
+/*
+* One distinct piece of str1 in the hash table, with how often it occurs
+* in either string and where it was last seen in str2.
+*/
+typedef struct {
+	uint64_t hash;
+	size_t pos1;	// SIZE_MAX marks an empty slot
+	size_t pos2;
+	size_t count1;
+	size_t count2;
+} PieceSlot;
+
+typedef struct {
+	size_t start1;
+	size_t start2;
+	size_t length;
+} Anchor;
+
+static uint64_t hash_piece(const char *str, size_t length){
+	uint64_t hash = 0;
+	for(size_t i = 0; i < length; i++){
+		hash = hash * HASH_BASE + (unsigned char)str[i];
+	}
+	return hash;
+}
+
+/*
+* The slot holding piece, or the empty slot where it would go.
+*/
+static PieceSlot *find_slot(PieceSlot *table, int bits, uint64_t hash, const char *piece,
+	const char *str1, size_t length){
+	size_t mask = ((size_t)1 << bits) - 1;
+	size_t s = (size_t)((hash * HASH_MIX) >> (64 - bits));
+	while(table[s].pos1 != SIZE_MAX){
+		if(table[s].hash == hash && memcmp(str1 + table[s].pos1, piece, length) == 0){
+			return &table[s];
+		}
+		s = (s + 1) & mask;
+	}
+	return &table[s];
+}
+
+static int compare_anchors(const void *a, const void *b){
+	size_t start_a = ((const Anchor*)a)->start1;
+	size_t start_b = ((const Anchor*)b)->start1;
+	return (start_a > start_b) - (start_a < start_b);
+}
+
+/*
+* Collects the pieces str1[p * length, (p + 1) * length) that occur
+* exactly once in each string, sorted by their position in str1.
+* Returns how many there are, or -1 if memory could not be allocated.
+*/
+static long find_anchors(const char *str1, size_t len1, const char *str2, size_t len2,
+	size_t length, Anchor **anchors){
+	*anchors = NULL;
+	size_t pieces = len1 / length;
+	if(pieces == 0 || len2 < length){
+		return 0;
+	}
+	int bits = 1;
+	while(((size_t)1 << bits) < 2 * pieces){
+		bits++;
+	}
+	size_t slots = (size_t)1 << bits;
+	PieceSlot *table = malloc(slots * sizeof(PieceSlot));
+	if(table == NULL){
+		return -1;
+	}
+	for(size_t s = 0; s < slots; s++){
+		table[s].pos1 = SIZE_MAX;
+	}
+	for(size_t p = 0; p < pieces; p++){
+		const char *piece = str1 + p * length;
+		uint64_t hash = hash_piece(piece, length);
+		PieceSlot *slot = find_slot(table, bits, hash, piece, str1, length);
+		if(slot->pos1 == SIZE_MAX){
+			slot->hash = hash;
+			slot->pos1 = p * length;
+			slot->count1 = 0;
+			slot->count2 = 0;
+		}
+		slot->count1++;
+	}
+
+	/*
+	* Every window of str2, by rolling hash: drop the character leaving
+	* the window (weighted HASH_BASE^(length - 1)), add the one entering.
+	*/
+	uint64_t top = 1;
+	for(size_t i = 1; i < length; i++){
+		top *= HASH_BASE;
+	}
+	uint64_t hash = hash_piece(str2, length);
+	for(size_t j = 0; ; j++){
+		PieceSlot *slot = find_slot(table, bits, hash, str2 + j, str1, length);
+		if(slot->pos1 != SIZE_MAX){
+			slot->count2++;
+			slot->pos2 = j;
+		}
+		if(j + length >= len2){
+			break;
+		}
+		hash = (hash - (unsigned char)str2[j] * top) * HASH_BASE + (unsigned char)str2[j + length];
+	}
+
+	size_t count = 0;
+	for(size_t s = 0; s < slots; s++){
+		count += (table[s].pos1 != SIZE_MAX && table[s].count1 == 1 && table[s].count2 == 1);
+	}
+	if(count == 0){
+		free(table);
+		return 0;
+	}
+	Anchor *found = malloc(count * sizeof(Anchor));
+	if(found == NULL){
+		free(table);
+		return -1;
+	}
+	count = 0;
+	for(size_t s = 0; s < slots; s++){
+		if(table[s].pos1 != SIZE_MAX && table[s].count1 == 1 && table[s].count2 == 1){
+			found[count].start1 = table[s].pos1;
+			found[count].start2 = table[s].pos2;
+			found[count].length = length;
+			count++;
+		}
+	}
+	free(table);
+	qsort(found, count, sizeof(Anchor), compare_anchors);
+	*anchors = found;
+	return (long)count;
+}
+
+/*
+* Keeps the longest run of anchors whose str2 positions increase along
+* with their str1 positions (patience sorting), then drops any that would
+* overlap the previous one in str2. Returns the new count, or -1 if memory
+* could not be allocated.
+*/
+static long chain_anchors(Anchor *anchors, size_t count){
+	if(count == 0){
+		return 0;
+	}
+	size_t *tails = malloc(count * sizeof(size_t));
+	size_t *previous = malloc(count * sizeof(size_t));
+	Anchor *chain = malloc(count * sizeof(Anchor));
+	if(tails == NULL || previous == NULL || chain == NULL){
+		free(tails);
+		free(previous);
+		free(chain);
+		return -1;
+	}
+	size_t length = 0;
+	for(size_t i = 0; i < count; i++){
+		size_t low = 0;
+		size_t high = length;
+		while(low < high){
+			size_t middle = low + (high - low) / 2;
+			if(anchors[tails[middle]].start2 < anchors[i].start2){
+				low = middle + 1;
+			}
+			else{
+				high = middle;
+			}
+		}
+		previous[i] = (low > 0) ? tails[low - 1] : SIZE_MAX;
+		tails[low] = i;
+		length += (low == length);
+	}
+	size_t k = length;
+	for(size_t i = tails[length - 1]; i != SIZE_MAX; i = previous[i]){
+		chain[--k] = anchors[i];
+	}
+
+	size_t kept = 0;
+	for(size_t c = 0; c < length; c++){
+		if(kept == 0 || chain[c].start2 >= anchors[kept - 1].start2 + anchors[kept - 1].length){
+			anchors[kept++] = chain[c];
+		}
+	}
+	free(tails);
+	free(previous);
+	free(chain);
+	return (long)kept;
+}
+
+/*
+* Grows every anchor over the exact match it sits in, up to its
+* neighbours, so the gaps start and end at a difference.
+*/
+static void extend_anchors(const char *str1, size_t len1, const char *str2, size_t len2,
+	Anchor *anchors, size_t count){
+	for(size_t a = 0; a < count; a++){
+		Anchor *anchor = &anchors[a];
+		size_t limit1 = (a > 0) ? anchors[a - 1].start1 + anchors[a - 1].length : 0;
+		size_t limit2 = (a > 0) ? anchors[a - 1].start2 + anchors[a - 1].length : 0;
+		size_t room = anchor->start1 - limit1;
+		room = (anchor->start2 - limit2 < room) ? anchor->start2 - limit2 : room;
+		size_t left = common_suffix_length(str1 + anchor->start1 - room,
+			str2 + anchor->start2 - room, room);
+		anchor->start1 -= left;
+		anchor->start2 -= left;
+		anchor->length += left;
+
+		size_t end1 = anchor->start1 + anchor->length;
+		size_t end2 = anchor->start2 + anchor->length;
+		limit1 = (a + 1 < count) ? anchors[a + 1].start1 : len1;
+		limit2 = (a + 1 < count) ? anchors[a + 1].start2 : len2;
+		room = (limit1 - end1 < limit2 - end2) ? limit1 - end1 : limit2 - end2;
+		anchor->length += common_prefix_length(str1 + end1, str2 + end2, room);
+	}
+}
+
+static long gap_solve(const EditPair *gap, long num_threads, void *solver_args){
+	EditDistanceEngine engine = *(EditDistanceEngine*)solver_args;
+	return engine(gap->str1, gap->len1, gap->str2, gap->len2, num_threads, NULL);
+}
+
+/*
+* Sum of the distances of the gaps around the anchors, or -1 if memory
+* could not be allocated.
+*/
+static long solve_gaps(const char *str1, size_t len1, const char *str2, size_t len2,
+	const Anchor *anchors, size_t count, EditDistanceEngine engine, long num_threads){
+	size_t num_gaps = count + 1;
+	EditPair *gaps = malloc(num_gaps * sizeof(EditPair));
+	long *results = malloc(num_gaps * sizeof(long));
+	if(gaps == NULL || results == NULL){
+		free(gaps);
+		free(results);
+		return -1;
+	}
+	for(size_t g = 0; g < num_gaps; g++){
+		size_t start1 = (g > 0) ? anchors[g - 1].start1 + anchors[g - 1].length : 0;
+		size_t start2 = (g > 0) ? anchors[g - 1].start2 + anchors[g - 1].length : 0;
+		size_t end1 = (g < count) ? anchors[g].start1 : len1;
+		size_t end2 = (g < count) ? anchors[g].start2 : len2;
+		gaps[g].str1 = str1 + start1;
+		gaps[g].len1 = end1 - start1;
+		gaps[g].str2 = str2 + start2;
+		gaps[g].len2 = end2 - start2;
+	}
+
+	/*
+	* Small gaps run one per worker, big ones one at a time with all
+	* threads.
+	*/
+	int status = edit_pairs_solve(gaps, num_gaps, results, num_threads, gap_solve, &engine);
+
+	long sum = 0;
+	for(size_t g = 0; g < num_gaps && status == 0; g++){
+		sum += results[g];
+	}
+	free(gaps);
+	free(results);
+	return (status == 0) ? sum : -1;
+}
+
+long anchored_edit_distance(const char *str1, size_t len1, const char *str2, size_t len2,
+	long num_threads, const AnchorOptions *options){
+	AnchorMode mode = (options != NULL) ? options->mode : ANCHOR_MODE_EXACT;
+	size_t length = (options != NULL && options->anchor_length > 0) ? options->anchor_length
+		: ANCHOR_DEFAULT_LENGTH;
+	EditDistanceEngine engine = (options != NULL && options->engine != NULL) ? options->engine
+		: simd_edit_distance_rect;
+	if(num_threads < 1){
+		num_threads = 1;
+	}
+
+	AnchorStats stats = {0};
+	stats.bound = -1;
+	strip_common_affixes(&str1, &len1, &str2, &len2, &stats.prefix, &stats.suffix);
+
+	Anchor *anchors = NULL;
+	long count = 0;
+	if(len1 > 0 && len2 > 0){
+		count = find_anchors(str1, len1, str2, len2, length, &anchors);
+		if(count > 0){
+			count = chain_anchors(anchors, count);
+		}
+	}
+	if(count < 0){
+		printf("Failed to allocate memory in anchored_edit_distance().");
+		free(anchors);
+		return -1;
+	}
+	extend_anchors(str1, len1, str2, len2, anchors, count);
+	stats.anchors = count;
+	for(long a = 0; a < count; a++){
+		stats.anchored_chars += anchors[a].length;
+	}
+
+	long result;
+	if(count == 0){
+		result = engine(str1, len1, str2, len2, num_threads, NULL);
+	}
+	else{
+		stats.subproblems = count + 1;
+		stats.bound = solve_gaps(str1, len1, str2, len2, anchors, count, engine, num_threads);
+		result = stats.bound;
+		size_t longer = (len1 > len2) ? len1 : len2;
+		if(mode == ANCHOR_MODE_EXACT && result >= 0){
+			/*
+			* The band only pays off while it is narrower than the matrix.
+			*/
+			int banded = (result <= BOUNDED_MAX_DISTANCE && (size_t)result < longer);
+			WavefrontOptions bounded = {WAVEFRONT_SCHEDULE_DATAFLOW, NULL, 1, banded ? (int)result : 0};
+			result = engine(str1, len1, str2, len2, num_threads, banded ? &bounded : NULL);
+		}
+	}
+	free(anchors);
+	if(result < 0){
+		printf("Failed to allocate memory in anchored_edit_distance().");
+		return -1;
+	}
+	if(options != NULL && options->stats != NULL){
+		*options->stats = stats;
+	}
+	return result;
+}
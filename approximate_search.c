@@ -0,0 +1,397 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "src/approximate_search.h"
+#include "src/myers.h"
+#include "src/avx2_search.h"
+#include "src/cpu_features.h"
+#include "src/worker_pool.h"
+
+/*
+* A pattern of one 64-bit word runs SEARCH_LANES independent columns over
+* different stretches of the text in one loop. The columns do not depend
+* on each other, so their instructions overlap in the pipeline instead of
+* waiting on a single dependency chain, and with AVX2 they share one
+* vector, a lane each (hence four, see avx2_search.h). Each lane gets at least MIN_LANE_CHARS characters
+* beyond its warm-up.
+*/
+#define SEARCH_LANES 4
+#define MIN_LANE_CHARS 4096
+
+/*
+* Smallest piece of text worth a thread of its own.
+*/
+#define MIN_THREAD_CHARS (1 << 20)
+
+typedef struct {
+	size_t length;
+	size_t words;
+	int last_bit;
+	int k;
+	uint64_t *peq;
+} SearchPattern;
+
+/*
+* The vertical deltas of one DP column (words 64-bit words each) and its
+* last cell.
+*/
+typedef struct {
+	uint64_t *pv;
+	uint64_t *mv;
+	long score;
+} SearchColumn;
+
+typedef struct {
+	SearchHit *hits;
+	size_t count;
+	size_t capacity;
+	int failed;
+} HitList;
+
+struct ApproximateSearch {
+	SearchPattern pattern;
+	SearchColumn column;
+	size_t position;	// characters fed so far
+};
+
+static int pattern_init(SearchPattern *pattern, const char *str, size_t len, int k){
+	pattern->length = len;
+	pattern->words = (len + 63) / 64;
+	pattern->last_bit = (int)((len - 1) % 64);
+	pattern->k = (k < 0) ? 0 : k;
+	pattern->peq = calloc(256 * pattern->words, sizeof(uint64_t));
+	if(pattern->peq == NULL){
+		return -1;
+	}
+	for(size_t i = 0; i < len; i++){
+		pattern->peq[(unsigned char)str[i] * pattern->words + i / 64] |= 1ULL << (i % 64);
+	}
+	return 0;
+}
+
+/*
+* Column 0: D[i][0] = i, so every vertical delta is +1.
+*/
+static void column_reset(const SearchPattern *pattern, SearchColumn *column){
+	for(size_t w = 0; w < pattern->words; w++){
+		column->pv[w] = ~0ULL;
+		column->mv[w] = 0;
+	}
+	column->score = pattern->length;
+}
+
+static void hit_push(HitList *list, size_t end, long distance){
+	if(list->count == list->capacity){
+		size_t capacity = (list->capacity == 0) ? 64 : 2 * list->capacity;
+		SearchHit *hits = realloc(list->hits, capacity * sizeof(SearchHit));
+		if(hits == NULL){
+			list->failed = 1;
+			return;
+		}
+		list->hits = hits;
+		list->capacity = capacity;
+	}
+	list->hits[list->count++] = (SearchHit){end, (int)distance};
+}
+
+static void hit_append(HitList *list, HitList *other){
+	for(size_t h = 0; h < other->count; h++){
+		hit_push(list, other->hits[h].end, other->hits[h].distance);
+	}
+	list->failed |= other->failed;
+	free(other->hits);
+}
+
+/*
+* Advances column over text[from, to). The row above the pattern is all
+* zeros (a match may start anywhere), so no delta enters at the top.
+* Records a hit for every character at or after report_from where the
+* last row is within k.
+*/
+static void scan_stream(const SearchPattern *pattern, SearchColumn *column, const char *text,
+	size_t from, size_t to, size_t report_from, HitList *hits){
+	size_t words = pattern->words;
+	int last_bit = pattern->last_bit;
+	long k = pattern->k;
+	long score = column->score;
+
+	if(words == 1){
+		uint64_t pv = column->pv[0];
+		uint64_t mv = column->mv[0];
+		for(size_t j = from; j < to; j++){
+			uint64_t eq = pattern->peq[(unsigned char)text[j]];
+			score += myers_advance_block(&pv, &mv, eq, 0, last_bit);
+			if(score <= k && j >= report_from){
+				hit_push(hits, j + 1, score);
+			}
+		}
+		column->pv[0] = pv;
+		column->mv[0] = mv;
+	}
+	else{
+		for(size_t j = from; j < to; j++){
+			const uint64_t *eq = &pattern->peq[(unsigned char)text[j] * words];
+			int hin = 0;
+			for(size_t w = 0; w + 1 < words; w++){
+				hin = myers_advance_block(&column->pv[w], &column->mv[w], eq[w], hin, 63);
+			}
+			score += myers_advance_block(&column->pv[words - 1], &column->mv[words - 1],
+				eq[words - 1], hin, last_bit);
+			if(score <= k && j >= report_from){
+				hit_push(hits, j + 1, score);
+			}
+		}
+	}
+	column->score = score;
+}
+
+/*
+* Single-word patterns: advances SEARCH_LANES columns in lockstep, lane l
+* over text[start[l], start[l] + count).
+*/
+static void scan_lanes(const SearchPattern *pattern, uint64_t *lane_pv, uint64_t *lane_mv,
+	long *lane_score, const char *text, const size_t *start, size_t count,
+	const size_t *report_from, HitList *hits){
+	const uint64_t *peq = pattern->peq;
+	int last_bit = pattern->last_bit;
+	long k = pattern->k;
+	uint64_t pv[SEARCH_LANES], mv[SEARCH_LANES];
+	long score[SEARCH_LANES];
+	const unsigned char *lane_text[SEARCH_LANES];
+	for(int l = 0; l < SEARCH_LANES; l++){
+		pv[l] = lane_pv[l];
+		mv[l] = lane_mv[l];
+		score[l] = lane_score[l];
+		lane_text[l] = (const unsigned char*)text + start[l];
+	}
+
+	if(cpu_simd_level() >= SIMD_LEVEL_AVX2){
+		/*
+		* The kernel stops at every character where a lane is within k;
+		* the hits are taken here.
+		*/
+		for(size_t t = 0; ; t++){
+			t = avx2_search_lanes(peq, last_bit, k, pv, mv, score, lane_text, t, count);
+			if(t == count){
+				break;
+			}
+			for(int l = 0; l < SEARCH_LANES; l++){
+				if(score[l] <= k && start[l] + t >= report_from[l]){
+					hit_push(&hits[l], start[l] + t + 1, score[l]);
+				}
+			}
+		}
+	}
+	else{
+		for(size_t t = 0; t < count; t++){
+			for(int l = 0; l < SEARCH_LANES; l++){
+				score[l] += myers_advance_block(&pv[l], &mv[l], peq[lane_text[l][t]], 0, last_bit);
+			}
+			for(int l = 0; l < SEARCH_LANES; l++){
+				if(score[l] <= k && start[l] + t >= report_from[l]){
+					hit_push(&hits[l], start[l] + t + 1, score[l]);
+				}
+			}
+		}
+	}
+
+	for(int l = 0; l < SEARCH_LANES; l++){
+		lane_pv[l] = pv[l];
+		lane_mv[l] = mv[l];
+		lane_score[l] = score[l];
+	}
+}
+
+/*
+* Advances column over text[from, to), recording the hits at or after
+* report_from in hits. Long stretches under a single-word pattern are cut
+* into SEARCH_LANES segments: the first continues column, the others
+* start from column 0 length + k characters before their segment (see
+* approximate_search()), and column ends up as the last lane's.
+*/
+static void scan_range(const SearchPattern *pattern, SearchColumn *column, const char *text,
+	size_t from, size_t to, size_t report_from, HitList *hits){
+	size_t warm_up = pattern->length + pattern->k;
+	size_t len = to - from;
+	if(pattern->words != 1 || len < SEARCH_LANES * (warm_up + MIN_LANE_CHARS)){
+		scan_stream(pattern, column, text, from, to, report_from, hits);
+		return;
+	}
+
+	size_t segment = len / SEARCH_LANES;
+	uint64_t pv[SEARCH_LANES], mv[SEARCH_LANES];
+	long score[SEARCH_LANES];
+	size_t start[SEARCH_LANES], lane_report[SEARCH_LANES];
+	HitList lane_hits[SEARCH_LANES];
+	memset(lane_hits, 0, sizeof(lane_hits));
+	for(int l = 0; l < SEARCH_LANES; l++){
+		size_t segment_start = from + l * segment;
+		start[l] = (l == 0) ? from : segment_start - warm_up;
+		lane_report[l] = (segment_start > report_from) ? segment_start : report_from;
+		pv[l] = (l == 0) ? column->pv[0] : ~0ULL;
+		mv[l] = (l == 0) ? column->mv[0] : 0;
+		score[l] = (l == 0) ? column->score : (long)pattern->length;
+	}
+
+	/*
+	* Lane 0 is exactly segment characters long; the others carry on
+	* alone through their warm-up's worth (and the last lane through the
+	* remainder).
+	*/
+	scan_lanes(pattern, pv, mv, score, text, start, segment, lane_report, lane_hits);
+	for(int l = 1; l < SEARCH_LANES; l++){
+		size_t end = (l == SEARCH_LANES - 1) ? to : from + (l + 1) * segment;
+		SearchColumn lane = {&pv[l], &mv[l], score[l]};
+		scan_stream(pattern, &lane, text, start[l] + segment, end, lane_report[l], &lane_hits[l]);
+		score[l] = lane.score;
+	}
+
+	for(int l = 0; l < SEARCH_LANES; l++){
+		hit_append(hits, &lane_hits[l]);
+	}
+	column->pv[0] = pv[SEARCH_LANES - 1];
+	column->mv[0] = mv[SEARCH_LANES - 1];
+	column->score = score[SEARCH_LANES - 1];
+}
+
+ApproximateSearch *approximate_search_create(const char *pattern, size_t len, int k){
+	if(len == 0){
+		printf("Empty pattern in approximate_search_create().");
+		return NULL;
+	}
+	ApproximateSearch *search = calloc(1, sizeof(ApproximateSearch));
+	if(search == NULL || pattern_init(&search->pattern, pattern, len, k) != 0
+		|| (search->column.pv = malloc(2 * search->pattern.words * sizeof(uint64_t))) == NULL){
+		printf("Failed to allocate memory in approximate_search_create().");
+		approximate_search_free(search);
+		return NULL;
+	}
+	search->column.mv = search->column.pv + search->pattern.words;
+	column_reset(&search->pattern, &search->column);
+	return search;
+}
+
+long approximate_search_feed(ApproximateSearch *search, const char *text, size_t len,
+	SearchHitCallback callback, void *user){
+	HitList hits = {0};
+	scan_range(&search->pattern, &search->column, text, 0, len, 0, &hits);
+	if(hits.failed){
+		printf("Failed to allocate memory in approximate_search_feed().");
+		free(hits.hits);
+		return -1;
+	}
+	for(size_t h = 0; h < hits.count; h++){
+		hits.hits[h].end += search->position;
+		callback(&hits.hits[h], user);
+	}
+	search->position += len;
+	free(hits.hits);
+	return (long)hits.count;
+}
+
+void approximate_search_free(ApproximateSearch *search){
+	if(search == NULL){
+		return;
+	}
+	free(search->pattern.peq);
+	free(search->column.pv);
+	free(search);
+}
+
+typedef struct {
+	const SearchPattern *pattern;
+	const char *text;
+	size_t text_len;
+	size_t num_pieces;
+	size_t piece_size;
+	HitList *pieces;
+	atomic_size_t next_piece;
+} SearchArguments;
+
+/*
+* Scans whole pieces until none are left. scratch holds the column.
+*/
+static void search_worker(void *task_args, int thread_id, void *scratch){
+	(void)thread_id;
+	SearchArguments *args = (SearchArguments*)task_args;
+	const SearchPattern *pattern = args->pattern;
+	size_t warm_up = pattern->length + pattern->k;
+	SearchColumn column = {(uint64_t*)scratch, (uint64_t*)scratch + pattern->words, 0};
+	for(;;){
+		size_t p = atomic_fetch_add(&args->next_piece, 1);
+		if(p >= args->num_pieces){
+			return;
+		}
+		size_t start = p * args->piece_size;
+		size_t end = (p == args->num_pieces - 1) ? args->text_len : start + args->piece_size;
+		column_reset(pattern, &column);
+		scan_range(pattern, &column, args->text, (start > warm_up) ? start - warm_up : 0, end, start,
+			&args->pieces[p]);
+	}
+}
+
+long approximate_search(const char *pattern, size_t len, const char *text, size_t text_len,
+	int k, long num_threads, SearchHitCallback callback, void *user){
+	if(len == 0){
+		printf("Empty pattern in approximate_search().");
+		return -1;
+	}
+	SearchPattern search_pattern;
+	if(pattern_init(&search_pattern, pattern, len, k) != 0){
+		printf("Failed to allocate memory in approximate_search().");
+		return -1;
+	}
+
+	size_t num_pieces = (num_threads > 1) ? (size_t)num_threads : 1;
+	if(num_pieces > text_len / MIN_THREAD_CHARS){
+		num_pieces = (text_len / MIN_THREAD_CHARS > 0) ? text_len / MIN_THREAD_CHARS : 1;
+	}
+	SearchArguments args;
+	args.pattern = &search_pattern;
+	args.text = text;
+	args.text_len = text_len;
+	args.num_pieces = num_pieces;
+	args.piece_size = text_len / num_pieces;
+	args.pieces = calloc(num_pieces, sizeof(HitList));
+	atomic_init(&args.next_piece, 0);
+	size_t scratch_size = 2 * search_pattern.words * sizeof(uint64_t);
+
+	int status = (args.pieces == NULL) ? -1 : 0;
+	if(status == 0 && num_pieces == 1){
+		void *scratch = malloc(scratch_size);
+		status = (scratch == NULL) ? -1 : 0;
+		if(status == 0){
+			search_worker(&args, 0, scratch);
+		}
+		free(scratch);
+	}
+	else if(status == 0){
+		WorkerPool *pool = worker_pool_create((long)num_pieces);
+		status = (pool != NULL) ? worker_pool_run(pool, search_worker, &args, scratch_size) : -1;
+		worker_pool_destroy(pool);
+	}
+
+	/*
+	* Pieces are reported in text order.
+	*/
+	long count = 0;
+	for(size_t p = 0; status == 0 && p < num_pieces; p++){
+		status = args.pieces[p].failed ? -1 : 0;
+	}
+	for(size_t p = 0; args.pieces != NULL && p < num_pieces; p++){
+		for(size_t h = 0; status == 0 && h < args.pieces[p].count; h++){
+			callback(&args.pieces[p].hits[h], user);
+		}
+		count += args.pieces[p].count;
+		free(args.pieces[p].hits);
+	}
+	free(args.pieces);
+	free(search_pattern.peq);
+	if(status != 0){
+		printf("Failed to allocate memory in approximate_search().");
+		return -1;
+	}
+	return count;
+}
@@ -0,0 +1,40 @@
+#include <stdint.h>
+#include <immintrin.h>
+#include "src/avx2_affix.h"
+
+size_t avx2_common_prefix(const char *str1, const char *str2, size_t len){
+	size_t i = 0;
+	for(; i + 32 <= len; i += 32){
+		__m256i a = _mm256_loadu_si256((const __m256i*)&str1[i]);
+		__m256i b = _mm256_loadu_si256((const __m256i*)&str2[i]);
+		uint32_t equal = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b));
+		if(equal != 0xFFFFFFFFu){
+			return i + __builtin_ctz(~equal);
+		}
+	}
+	while(i < len && str1[i] == str2[i]){
+		i++;
+	}
+	return i;
+}
+
+size_t avx2_common_suffix(const char *str1, const char *str2, size_t len){
+	/*
+	* Walks back from the end, so the first mismatch is the highest clear
+	* bit of each mask.
+	*/
+	size_t n = 0;
+	for(; n + 32 <= len; n += 32){
+		size_t i = len - n - 32;
+		__m256i a = _mm256_loadu_si256((const __m256i*)&str1[i]);
+		__m256i b = _mm256_loadu_si256((const __m256i*)&str2[i]);
+		uint32_t equal = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b));
+		if(equal != 0xFFFFFFFFu){
+			return n + __builtin_clz(~equal);
+		}
+	}
+	while(n < len && str1[len - n - 1] == str2[len - n - 1]){
+		n++;
+	}
+	return n;
+}
@@ -0,0 +1,142 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <immintrin.h>
+#include "src/avx2_batch_edit_distance.h"
+
+/*
+* Transposes the pairs' strings so that position p of every lane is
+* contiguous: t1[p * lanes + l] = pairs[l].str1[p]. Positions past the end
+* of a lane's string (and unused lanes) hold 0; whatever those cells
+* compute is never read back, since DP cells only feed cells below and to
+* the right of them.
+*/
+static void transpose_strings(const EditPair *pairs, int count, int lanes,
+	size_t max_len1, size_t max_len2, unsigned char *t1, unsigned char *t2){
+	memset(t1, 0, max_len1 * lanes);
+	memset(t2, 0, max_len2 * lanes);
+	for(int l = 0; l < count; l++){
+		for(size_t p = 0; p < pairs[l].len1; p++){
+			t1[p * lanes + l] = (unsigned char)pairs[l].str1[p];
+		}
+		for(size_t p = 0; p < pairs[l].len2; p++){
+			t2[p * lanes + l] = (unsigned char)pairs[l].str2[p];
+		}
+	}
+}
+
+static void max_lengths(const EditPair *pairs, int count, size_t *max_len1, size_t *max_len2){
+	*max_len1 = 0;
+	*max_len2 = 0;
+	for(int l = 0; l < count; l++){
+		if(pairs[l].len1 > *max_len1){
+			*max_len1 = pairs[l].len1;
+		}
+		if(pairs[l].len2 > *max_len2){
+			*max_len2 = pairs[l].len2;
+		}
+	}
+}
+
+size_t avx2_batch_scratch_size(size_t max_len1, size_t max_len2, int lanes){
+	// Two DP rows of one vector per column, then the transposed strings
+	return 2 * (max_len2 + 1) * sizeof(__m256i) + (max_len1 + max_len2) * lanes;
+}
+
+void avx2_batch_lanes_16(const EditPair *pairs, int count, int *results, void *scratch){
+	const int lanes = AVX2_BATCH_LANES_16;
+	size_t max_len1, max_len2;
+	max_lengths(pairs, count, &max_len1, &max_len2);
+
+	__m256i *prev_row = (__m256i*)scratch;
+	__m256i *cur_row = prev_row + (max_len2 + 1);
+	unsigned char *t1 = (unsigned char*)(cur_row + (max_len2 + 1));
+	unsigned char *t2 = t1 + max_len1 * lanes;
+	transpose_strings(pairs, count, lanes, max_len1, max_len2, t1, t2);
+
+	const __m256i v_one = _mm256_set1_epi16(1);
+	for(size_t j = 0; j <= max_len2; j++){
+		prev_row[j] = _mm256_set1_epi16((short)j);
+	}
+
+	for(size_t i = 1; i <= max_len1; i++){
+		__m128i v_c1 = _mm_loadu_si128((const __m128i*)&t1[(i - 1) * lanes]);
+		__m256i v_left = _mm256_set1_epi16((short)i);
+		__m256i v_diag = prev_row[0];
+		cur_row[0] = v_left;
+
+		for(size_t j = 1; j <= max_len2; j++){
+			__m128i v_c2 = _mm_loadu_si128((const __m128i*)&t2[(j - 1) * lanes]);
+			// 0 where the characters match, 1 where they differ
+			__m256i v_cost = _mm256_add_epi16(_mm256_cvtepi8_epi16(_mm_cmpeq_epi8(v_c1, v_c2)), v_one);
+			__m256i v_up = prev_row[j];
+			__m256i v_res = _mm256_add_epi16(_mm256_min_epi16(v_up, v_left), v_one);
+			v_res = _mm256_min_epi16(v_res, _mm256_add_epi16(v_diag, v_cost));
+			cur_row[j] = v_res;
+			v_diag = v_up;
+			v_left = v_res;
+		}
+
+		/*
+		* Pick up the lanes whose str1 ends on this row.
+		*/
+		for(int l = 0; l < count; l++){
+			if(pairs[l].len1 == i){
+				results[l] = ((const int16_t*)&cur_row[pairs[l].len2])[l];
+			}
+		}
+
+		__m256i *temp = prev_row;
+		prev_row = cur_row;
+		cur_row = temp;
+	}
+}
+
+void avx2_batch_lanes_32(const EditPair *pairs, int count, int *results, void *scratch){
+	const int lanes = AVX2_BATCH_LANES_32;
+	size_t max_len1, max_len2;
+	max_lengths(pairs, count, &max_len1, &max_len2);
+
+	__m256i *prev_row = (__m256i*)scratch;
+	__m256i *cur_row = prev_row + (max_len2 + 1);
+	unsigned char *t1 = (unsigned char*)(cur_row + (max_len2 + 1));
+	unsigned char *t2 = t1 + max_len1 * lanes;
+	transpose_strings(pairs, count, lanes, max_len1, max_len2, t1, t2);
+
+	const __m256i v_one = _mm256_set1_epi32(1);
+	for(size_t j = 0; j <= max_len2; j++){
+		prev_row[j] = _mm256_set1_epi32((int)j);
+	}
+
+	for(size_t i = 1; i <= max_len1; i++){
+		long long c1;
+		memcpy(&c1, &t1[(i - 1) * lanes], 8);
+		__m128i v_c1 = _mm_cvtsi64_si128(c1);
+		__m256i v_left = _mm256_set1_epi32((int)i);
+		__m256i v_diag = prev_row[0];
+		cur_row[0] = v_left;
+
+		for(size_t j = 1; j <= max_len2; j++){
+			long long c2;
+			memcpy(&c2, &t2[(j - 1) * lanes], 8);
+			__m128i v_eq = _mm_cmpeq_epi8(v_c1, _mm_cvtsi64_si128(c2));
+			__m256i v_cost = _mm256_add_epi32(_mm256_cvtepi8_epi32(v_eq), v_one);
+			__m256i v_up = prev_row[j];
+			__m256i v_res = _mm256_add_epi32(_mm256_min_epi32(v_up, v_left), v_one);
+			v_res = _mm256_min_epi32(v_res, _mm256_add_epi32(v_diag, v_cost));
+			cur_row[j] = v_res;
+			v_diag = v_up;
+			v_left = v_res;
+		}
+
+		for(int l = 0; l < count; l++){
+			if(pairs[l].len1 == i){
+				results[l] = ((const int32_t*)&cur_row[pairs[l].len2])[l];
+			}
+		}
+
+		__m256i *temp = prev_row;
+		prev_row = cur_row;
+		cur_row = temp;
+	}
+}
@@ -1,24 +1,39 @@
 #define _POSIX_C_SOURCE 200809L
 #include <stdlib.h>
 #include <stdio.h>
-#include <math.h>
-#include <pthread.h>
 #include <immintrin.h>
 #include <string.h>
+#include <stdint.h>
 #include "src/avx2_edit_distance.h"
-#include "src/threadarguments.h"
+#include "src/wavefront.h"
+#include "src/tile_config.h"
+#include "src/sharded_wavefront.h"
 
 /*
-* n size for each individual block while tiling. 
+* n size for each individual block while tiling. With only three
+* diagonals per tile in scratch the working set grows linearly with it, so
+* tiles can be larger than the 512 the full diagonal-major buffer allowed.
 */
-#define BLOCK_SIZE 512
+#define BLOCK_SIZE 1024
 
 /*
-* Helper macro for diagonal-major indexing on a linearized array.
-* Accounts for a width+1 buffer as used in only the avx2 process_tile() 
-* function.
+* Largest tile side accepted at runtime (WavefrontOptions, tuned shapes);
+* sizes the per-thread scratch.
 */
-#define idx(k, i) ((k) * (height + 1) + (i))
+#define MAX_TILE_SIZE 2048
+
+/*
+* Padding behind every per-tile array, so the vector loops can always run
+* in whole vectors (the extra lanes compute garbage that is never read
+* back). One loop iteration covers at most 32 cells.
+*/
+#define LANE_PADDING 32
+
+/*
+* Number of elements in one per-tile array: one anti-diagonal, or one of
+* the tile's substrings.
+*/
+#define LANE_ARRAY (MAX_TILE_SIZE + 1 + LANE_PADDING)
 
 /*
 * Helper minimum function for type __m256i (returns whichever of a, b, and c is smaller).
@@ -37,82 +52,64 @@ static inline int min_scalar(int a, int b, int c){
 }
 
 /*
-* Helper function to process a single tile AND update the global rows 
-* and cols.
+* Copies the tile's substrings into padded scratch. str2 is stored
+* reversed (s2_reversed[m] = str2[width - 1 - m]), so along anti-diagonal
+* k both strings run forwards: cell (i, j) compares s1[i - 1] with
+* s2_reversed[width - k + i].
 */
-static int process_tile(int row_offset, int col_offset, 
-	int *global_rows_read, int *global_rows_write, int *global_cols, 
-	int height, int width, const char *str1, const char *str2, 
-	int *buffer, size_t total_len){
-
-	/*
-    * Prefill with global rows and cols to allow simpler math
-    */
-    for(int i = 1; i <= height; i++){
-		if(row_offset + i <= total_len){
-			buffer[idx(i, i)] = global_cols[row_offset + i];
-		}
-		else{
-			// padding value: not meant to be used
-			buffer[idx(i, i)] = total_len;
-		}
-        
-    }
-    for(int j = 1; j <= width; j++){
-		if(col_offset + j <= total_len){
-			buffer[idx(j, 0)] = global_rows_read[col_offset + j];
-		}
-		else{
-			// padding value: not meant to be used
-			buffer[idx(j, 0)] = total_len;
-		}
-    }
-
-	// Initialize the corner separately
-	if(col_offset == 0){
-		// Grab the value from the left
-		buffer[idx(0,0)] = row_offset;
+static inline void copy_tile_strings(char *s1, char *s2_reversed, const char *str1,
+	const char *str2, int height, int width){
+	memcpy(s1, str1, height);
+	for(int m = 0; m < width; m++){
+		s2_reversed[m] = str2[width - 1 - m];
 	}
-	else if(row_offset == 0){
-        // Grab the value from the top
-		buffer[idx(0,0)] = col_offset;
-	}
-	else{
-		// Internal tile: grab the value from the top, as normal.
-	    buffer[idx(0,0)] = global_rows_read[col_offset];
-    }
+}
+
+/*
+* Helper function to process a single tile AND update the global rows
+* and cols. Cells are stored diagonal-major, but only the three
+* anti-diagonals a wave touches are kept: wave k reads waves k-1 and k-2
+* and overwrites the slot of wave k-3. Entry i of a diagonal is the cell in
+* row i. scratch holds the three diagonals followed by the padded
+* substrings.
+*/
+static int process_tile(const int *top, const int *left, int *bottom,
+	int *right, int corner, int height, int width, const char *str1,
+	const char *str2, void *scratch){
+
+	int *waves[3];
+	waves[0] = (int*)scratch;
+	waves[1] = waves[0] + LANE_ARRAY;
+	waves[2] = waves[1] + LANE_ARRAY;
+	char *s1 = (char*)(waves[2] + LANE_ARRAY);
+	char *s2_reversed = s1 + LANE_ARRAY;
+	copy_tile_strings(s1, s2_reversed, str1, str2, height, width);
+
+	// Waves 0 and 1 hold only boundary cells
+	waves[0][0] = corner;
+	waves[1][0] = top[1];
+	waves[1][1] = left[1];
 
 	const __m256i v_one = _mm256_set1_epi32(1);
-	const __m256i v_reverse_idx = _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7);
     /*
     * Calculate all the values inside the tile
     * k is the wavefront number (1-based)
     * Can skip k=1 because it is already initialized
     * i is the row (1-based)
     * j is the column (1-based)
-    * We have (j = k - i) <=> (k = j + k) <=> (i = k - j) 
-    */ 
+    * We have (j = k - i) <=> (k = j + k) <=> (i = k - j)
+    */
     int max_wave = height + width;
 	for(int k = 2; k <= max_wave; k++){
 		int min_i = (k - width > 1) ? (k - width) : 1;
         int max_i = (k - 1 < height) ? (k - 1) : height;
+		int *wave = waves[k % 3];
+		const int *prev_wave = waves[(k - 1) % 3];
+		const int *prev_wave2 = waves[(k - 2) % 3];
+		const char *s2_wave = &s2_reversed[width - k];
 
 		// Unrolled (2x) vector loop for performance
-		int i;
-		for(i = min_i; i <= max_i - 15; i += 16){
-			int j = k - i;
-
-			/*
-			* Safety check for both vectors--ensure we are not reading 
-			* before the start of str2
-			*/
-			if(col_offset + j - 16 < 0){
-				break;
-			}
-
-			int *prev_wave = &buffer[idx(k-1, 0)];
-			int *prev_wave2 = &buffer[idx(k-2, 0)];
-
+		for(int i = min_i; i <= max_i; i += 16){
 			// Load neighbors for vector 1
 			__m256i v_left1 = _mm256_loadu_si256((__m256i*)&prev_wave[i]);
 			__m256i v_top1 = _mm256_loadu_si256((__m256i*)&prev_wave[i-1]);
@@ -129,22 +126,15 @@ static int process_tile(int row_offset, int col_offset,
 			* vector 2 at (i+8, j-8);
 			*/
 			long long s1c1, s2c1, s1c2, s2c2;
-			memcpy(&s1c1, &str1[row_offset + i - 1], 8);
-			__m128i v_s1_8_1 = _mm_cvtsi64_si128(s1c1);
-			__m256i v_s1_32_1 = _mm256_cvtepi8_epi32(v_s1_8_1);
-			memcpy(&s2c1, &str2[col_offset + j - 8], 8);
-			__m128i v_s2_8_1 = _mm_cvtsi64_si128(s2c1);
-			__m256i v_s2_32_1_fwd = _mm256_cvtepi8_epi32(v_s2_8_1);
-			__m256i v_s2_32_1 = _mm256_permutevar8x32_epi32(v_s2_32_1_fwd, v_reverse_idx);
-
-			memcpy(&s1c2, &str1[row_offset + i - 1 + 8], 8);
-			__m128i v_s1_8_2 = _mm_cvtsi64_si128(s1c2);
-			__m256i v_s1_32_2 = _mm256_cvtepi8_epi32(v_s1_8_2);
-			memcpy(&s2c2, &str2[col_offset + j - 8 - 8], 8);
-			__m128i v_s2_8_2 = _mm_cvtsi64_si128(s2c2);
-			__m256i v_s2_32_2_fwd = _mm256_cvtepi8_epi32(v_s2_8_2);
-			__m256i v_s2_32_2 = _mm256_permutevar8x32_epi32(v_s2_32_2_fwd, v_reverse_idx);
-			
+			memcpy(&s1c1, &s1[i - 1], 8);
+			memcpy(&s2c1, &s2_wave[i], 8);
+			memcpy(&s1c2, &s1[i - 1 + 8], 8);
+			memcpy(&s2c2, &s2_wave[i + 8], 8);
+			__m256i v_s1_32_1 = _mm256_cvtepi8_epi32(_mm_cvtsi64_si128(s1c1));
+			__m256i v_s2_32_1 = _mm256_cvtepi8_epi32(_mm_cvtsi64_si128(s2c1));
+			__m256i v_s1_32_2 = _mm256_cvtepi8_epi32(_mm_cvtsi64_si128(s1c2));
+			__m256i v_s2_32_2 = _mm256_cvtepi8_epi32(_mm_cvtsi64_si128(s2c2));
+
 			/*
 			* Find costs
 			*/
@@ -169,210 +159,291 @@ static int process_tile(int row_offset, int col_offset,
 			__m256i v_res2 = min_vector(v_ins2, v_del2, v_sub2);
 
 			// Store
-			_mm256_storeu_si256((__m256i*)&buffer[idx(k, i)], v_res1);
-			_mm256_storeu_si256((__m256i*)&buffer[idx(k, i+8)], v_res2);
+			_mm256_storeu_si256((__m256i*)&wave[i], v_res1);
+			_mm256_storeu_si256((__m256i*)&wave[i+8], v_res2);
+		}
+
+		// Boundary cells of this wave (after the loop, which may run past max_i)
+		if(k <= width){
+			wave[0] = top[k];
 		}
+		if(k <= height){
+			wave[k] = left[k];
+		}
+
 		/*
-		* Scalar cleanup loop (catches case where we have 1-15 pixels
-		* remaining OR edge case in first tile)
+		* Export the cells on the tile's last row and column as soon as
+		* they are final. bottom[j] and right[i] may alias top[j] and
+		* left[i], but those were consumed by wave j (resp. i) already.
 		*/
-		for(; i <= max_i; i++){
-			int j = k - i;
-			size_t global_row_idx = row_offset + i;
-			size_t global_col_idx = col_offset + j;
-
-			int ins = buffer[idx(k-1, i)] + 1;
-			int del = buffer[idx(k-1, i-1)] + 1;
-			int cost = (str1[global_row_idx - 1]) == str2[global_col_idx - 1] ? 0 : 1;
-			int sub = buffer[idx(k-1-1, i-1)] + cost;
-			buffer[idx(k, i)] = min_scalar(ins, del, sub);
+		if(k - height >= 1 && k - height <= width){
+			bottom[k - height] = wave[height];
+		}
+		if(k - width >= 1 && k - width <= height){
+			right[k - width] = wave[k - width];
 		}
 	}
 
-	/*
-	* Update the global row (write version) so the tile below this 
-	* one can read its correct values.
-	*/
-	for(int j = 1; j <= width; j++){
-		global_rows_write[col_offset + j] = buffer[idx(height+j, height)];
-	}
-
-    /*
-    * Update the global column (write version) so the tile to the 
-    * right of this one can read its correct values
-    */
-    for(int i = 1; i <= height; i++){
-        global_cols[row_offset + i] = buffer[idx(i+width, i)];
-    }
-
-	return buffer[idx(height+width, height)];
+	return waves[max_wave % 3][height];
 }
 
 /*
-* The start_routine function for pthread_create().
+* Same computation as process_tile(), but scores are kept relative to the
+* tile's corner value in 16-bit lanes, so one __m256i holds 16 cells.
+* Neighboring DP cells differ by at most 1, so every cell of a
+* MAX_TILE_SIZE x MAX_TILE_SIZE tile is within 2 * MAX_TILE_SIZE of the
+* corner.
+* Values are converted back to absolute ints only when the boundaries are
+* written out.
 */
-static void* thread_worker(void* args){
-	/*
-	* In this program, args is guaranteed to originally be of 
-	* type ThreadArguments. So, casting is safe.
-	*/
-	ThreadArguments* data = (ThreadArguments*)args;
+static int process_tile_16(const int *top, const int *left, int *bottom,
+	int *right, int corner, int height, int width, const char *str1,
+	const char *str2, void *scratch){
 
-	/*
-	* Create a diagonal-major storage for this thread.
-	* Max diagonals = approx 2 * BLOCK_SIZE. Each diagonal needs
-	* BLOCK_SIZE elements.
-	
-	* For BLOCK_SIZE = 512, this is 2 * 513 * 513 * sizeof(int) 
-	* = approx 0.5 MB on the heap. For 16 threads, this is ~8 MB.
-	* For a system with 16 threads, this should not exhaust the heap.
-	* Systems like these tend to have at minimum 16 GB.
-	*/
-	int *thread_buffer = malloc(2 * (BLOCK_SIZE + 1) * (BLOCK_SIZE + 1) * sizeof(int));
-    if(thread_buffer == NULL){
-        printf("Unable to allocate memory for a thread's buffer in avx2_edit_distance(). Exiting thread...");
-        return NULL;
-    }
-
-	// Calculate diagonal bounds
-	int n = data->num_blocks;
-	int wave = data->current_wave;
-	int row_min = (wave < n) ? 0 : (wave - n + 1);
-	int row_max = (wave < n) ? wave : (n - 1);
+	int16_t *waves[3];
+	waves[0] = (int16_t*)scratch;
+	waves[1] = waves[0] + LANE_ARRAY;
+	waves[2] = waves[1] + LANE_ARRAY;
+	char *s1 = (char*)(waves[2] + LANE_ARRAY);
+	char *s2_reversed = s1 + LANE_ARRAY;
+	copy_tile_strings(s1, s2_reversed, str1, str2, height, width);
 
-	/*
-	* Iterate through every tile in this wave
-	*/
-	int tile_number = 0;
-	for(int r = row_min; r <= row_max; r++){
-		// Find the column for this row in the diagonal
-		int c = wave - r;
+	waves[0][0] = 0;
+	waves[1][0] = (int16_t)(top[1] - corner);
+	waves[1][1] = (int16_t)(left[1] - corner);
 
-		/*
-		* Only process this tile at (r, c) if it is "assigned" to 
-		* this thread.
-		* Ensures nearly equal spreading of work (eliminating
-		* performance bottlenecks in which one thread has more 
-		* work than the others).
-		*/
-		if(tile_number % data->num_threads == data->thread_id){
-			size_t row_offset = r * BLOCK_SIZE;
-			size_t col_offset = c * BLOCK_SIZE;
+	const __m256i v_one = _mm256_set1_epi16(1);
 
-			/*
-			* Read from (r-1) % 3, write to r % 3 (add 3 to deal with 
-			* the negative)
-			*/ 
-			int read_idx = (r-1+3) % 3;
-			int write_idx = r % 3;
+	int max_wave = height + width;
+	for(int k = 2; k <= max_wave; k++){
+		int min_i = (k - width > 1) ? (k - width) : 1;
+		int max_i = (k - 1 < height) ? (k - 1) : height;
+		int16_t *wave = waves[k % 3];
+		const int16_t *prev_wave = waves[(k - 1) % 3];
+		const int16_t *prev_wave2 = waves[(k - 2) % 3];
+		const char *s2_wave = &s2_reversed[width - k];
+
+		// Unrolled (2x) vector loop, 16 cells per vector
+		for(int i = min_i; i <= max_i; i += 32){
+			__m256i v_left1 = _mm256_loadu_si256((__m256i*)&prev_wave[i]);
+			__m256i v_top1 = _mm256_loadu_si256((__m256i*)&prev_wave[i-1]);
+			__m256i v_diag1 = _mm256_loadu_si256((__m256i*)&prev_wave2[i-1]);
+
+			__m256i v_left2 = _mm256_loadu_si256((__m256i*)&prev_wave[i+16]);
+			__m256i v_top2 = _mm256_loadu_si256((__m256i*)&prev_wave[i-1+16]);
+			__m256i v_diag2 = _mm256_loadu_si256((__m256i*)&prev_wave2[i-1+16]);
 
 			/*
-			* Handle edge case where there are not enough elements 
-			* left to create a full size tile.
+			* Compare the characters as bytes, then widen the mask.
+			* vector 1 at (i, j)
+			* vector 2 at (i+16, j-16)
 			*/
-			int height = (row_offset + BLOCK_SIZE > data->len) 
-			? (data->len - row_offset) : BLOCK_SIZE;
-			int width = (col_offset + BLOCK_SIZE > data->len)
-			? (data->len - col_offset) : BLOCK_SIZE;
-
-			process_tile(row_offset, col_offset,
-				data->global_rows[read_idx], data->global_rows[write_idx],
-				data->global_cols, height, width, data->str1, 
-				data->str2, thread_buffer, data->len);
+			__m128i v_eq1 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)&s1[i - 1]),
+				_mm_loadu_si128((const __m128i*)&s2_wave[i]));
+			__m128i v_eq2 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)&s1[i - 1 + 16]),
+				_mm_loadu_si128((const __m128i*)&s2_wave[i + 16]));
+			__m256i v_cost1 = _mm256_add_epi16(_mm256_cvtepi8_epi16(v_eq1), v_one);
+			__m256i v_cost2 = _mm256_add_epi16(_mm256_cvtepi8_epi16(v_eq2), v_one);
+
+			__m256i v_res1 = _mm256_min_epi16(_mm256_add_epi16(v_left1, v_one), _mm256_add_epi16(v_top1, v_one));
+			v_res1 = _mm256_min_epi16(v_res1, _mm256_add_epi16(v_diag1, v_cost1));
+			__m256i v_res2 = _mm256_min_epi16(_mm256_add_epi16(v_left2, v_one), _mm256_add_epi16(v_top2, v_one));
+			v_res2 = _mm256_min_epi16(v_res2, _mm256_add_epi16(v_diag2, v_cost2));
+
+			_mm256_storeu_si256((__m256i*)&wave[i], v_res1);
+			_mm256_storeu_si256((__m256i*)&wave[i+16], v_res2);
+		}
+
+		if(k <= width){
+			wave[0] = (int16_t)(top[k] - corner);
+		}
+		if(k <= height){
+			wave[k] = (int16_t)(left[k] - corner);
+		}
+
+		if(k - height >= 1 && k - height <= width){
+			bottom[k - height] = corner + wave[height];
+		}
+		if(k - width >= 1 && k - width <= height){
+			right[k - width] = corner + wave[k - width];
 		}
-		tile_number++;
 	}
 
-	// Cleanup
-	free(thread_buffer);
-	return NULL;
+	return corner + waves[max_wave % 3][height];
 }
 
-int avx2_edit_distance(const char *str1, const char *str2, size_t len, long num_threads){
-    if(len < 1){
-        return 0;
-    }
-	// Threads limited to 16, should be safe to allocate on stack
-	pthread_t threads[num_threads];
+/*
+* Difference-encoded 8-bit kernel (32 cells per vector). Instead of scores
+* it keeps, for every cell of the current anti-diagonal, the horizontal
+* delta dh = D(i, j) - D(i, j-1) and the vertical delta dv = D(i, j) -
+* D(i-1, j). Both are always in {-1, 0, 1}, so 8 bits are enough for any
+* tile size. Relative to the diagonal neighbor D(i-1, j-1):
+*   z = min(cost, dh(i-1, j) + 1, dv(i, j-1) + 1)
+*   dv(i, j) = z - dh(i-1, j),  dh(i, j) = z - dv(i, j-1)
+* so only the previous anti-diagonal is needed. scratch holds two dh and two
+* dv diagonals (swapped after every wave), padded copies of the tile's
+* substrings (str2 reversed, so both run forwards along a diagonal) and the
+* deltas along the bottom row and right column, which are summed back into
+* absolute values at the end.
+*/
+static int process_tile_8(const int *top, const int *left, int *bottom,
+	int *right, int corner, int height, int width, const char *str1,
+	const char *str2, void *scratch){
 
-    /*
-    * sizeof(ThreadArguments) = 80. 80 bytes * 16 max threads should 
-    * be safe to allocate on stack
-    */ 
-	ThreadArguments args[num_threads];
+	int8_t *prev_dh = (int8_t*)scratch;
+	int8_t *prev_dv = prev_dh + LANE_ARRAY;
+	int8_t *cur_dh = prev_dv + LANE_ARRAY;
+	int8_t *cur_dv = cur_dh + LANE_ARRAY;
+	int8_t *bottom_dh = cur_dv + LANE_ARRAY;
+	int8_t *right_dv = bottom_dh + LANE_ARRAY;
+	char *s1 = (char*)(right_dv + LANE_ARRAY);
+	char *s2_reversed = s1 + LANE_ARRAY;
 
-	/*
-	* Allocate the global boundaries arrays (holds the numbers future 
-	* process_tile calls will need).
-	* Triple buffering to guarantee disjoint memory access
-	*/
-	int *row_bounds[3];
-	for(int i = 0; i < 3; i++){
-		row_bounds[i] = malloc((len + 1) * sizeof(int));
-	}
-	int *col_bounds = malloc((len + 1) * sizeof(int));
-	if(col_bounds == NULL || row_bounds[0] == NULL ||
-		row_bounds[1] == NULL || row_bounds[2] == NULL){
-		free(row_bounds[0]);
-		free(row_bounds[1]);
-		free(row_bounds[2]);
-		free(col_bounds);
-		return -1;
-	}
+	copy_tile_strings(s1, s2_reversed, str1, str2, height, width);
 
 	/*
-	* Initialize the boundaries (row 0 and col 0)
+	* bottom and right may alias top and left, so read what the final
+	* pass needs before anything is written.
 	*/
-	for(size_t i = 0; i <= len; i++){
-		row_bounds[0][i] = i;
-		row_bounds[1][i] = i;
-		row_bounds[2][i] = i;
-		col_bounds[i] = i;
-	}
+	int top_last = top[width];
+	int left_last = left[height];
+
+	// Anti-diagonal 1: cells (0, 1) and (1, 0)
+	prev_dh[0] = (int8_t)(top[1] - corner);
+	prev_dv[1] = (int8_t)(left[1] - corner);
+
+	const __m256i v_one = _mm256_set1_epi8(1);
+
+	int max_wave = height + width;
+	for(int k = 2; k <= max_wave; k++){
+		int min_i = (k - width > 1) ? (k - width) : 1;
+		int max_i = (k - 1 < height) ? (k - 1) : height;
+		const char *s2_wave = &s2_reversed[width - k];
 
-	/*
-	* Loop through the diagonal waves
-	*/
-	int num_blocks = (len + BLOCK_SIZE - 1) / BLOCK_SIZE;
-	int num_waves = 2 * num_blocks - 1;
-	for(size_t wave = 0; wave < num_waves; wave++){
 		/*
-		* Creating threads to work on the individual tiles 
-		* within a wave
+		* Cells past max_i land in the padding or in entries of this
+		* diagonal that are rewritten below before they are read.
 		*/
-		for(int t = 0; t < num_threads; t++){
-			args[t].thread_id = t;
-			args[t].num_threads = num_threads;
-			args[t].current_wave = wave;
-			args[t].num_blocks = num_blocks;
-
-			for(int k = 0; k < 3; k++){
-				args[t].global_rows[k] = row_bounds[k];
-			}
-			args[t].global_cols = col_bounds;
-			args[t].len = len;
-			args[t].str1 = str1;
-			args[t].str2 = str2;
-
-			// Launch the thread with its appropriate arguments
-			pthread_create(&threads[t], NULL, thread_worker, &args[t]);
+		for(int i = min_i; i <= max_i; i += 32){
+			__m256i v_dh_up = _mm256_loadu_si256((__m256i*)&prev_dh[i-1]);
+			__m256i v_dv_left = _mm256_loadu_si256((__m256i*)&prev_dv[i]);
+
+			__m256i v_s1 = _mm256_loadu_si256((const __m256i*)&s1[i - 1]);
+			__m256i v_s2 = _mm256_loadu_si256((const __m256i*)&s2_wave[i]);
+			__m256i v_cost = _mm256_add_epi8(_mm256_cmpeq_epi8(v_s1, v_s2), v_one);
+
+			__m256i v_z = _mm256_min_epi8(_mm256_add_epi8(v_dh_up, v_one), _mm256_add_epi8(v_dv_left, v_one));
+			v_z = _mm256_min_epi8(v_z, v_cost);
+
+			_mm256_storeu_si256((__m256i*)&cur_dv[i], _mm256_sub_epi8(v_z, v_dh_up));
+			_mm256_storeu_si256((__m256i*)&cur_dh[i], _mm256_sub_epi8(v_z, v_dv_left));
 		}
 
-		/*
-		* Ensure synchronization. This wave should be finished before
-		* moving to the next.
-		*/
-		for(int t = 0; t < num_threads; t++){
-			pthread_join(threads[t], NULL);
+		// Boundary cells of this anti-diagonal
+		if(k <= width){
+			cur_dh[0] = (int8_t)(top[k] - top[k-1]);
+		}
+		if(k <= height){
+			cur_dv[k] = (int8_t)(left[k] - left[k-1]);
 		}
+
+		// Record the deltas crossing the tile's last row and column
+		if(k - height >= 1 && k - height <= width){
+			bottom_dh[k - height] = cur_dh[height];
+		}
+		if(k - width >= 1 && k - width <= height){
+			right_dv[k - width] = cur_dv[k - width];
+		}
+
+		int8_t *swap = prev_dh;
+		prev_dh = cur_dh;
+		cur_dh = swap;
+		swap = prev_dv;
+		prev_dv = cur_dv;
+		cur_dv = swap;
+	}
+
+	int value = left_last;
+	for(int j = 1; j <= width; j++){
+		value += bottom_dh[j];
+		bottom[j] = value;
 	}
+	int bottom_score = value;
 
-	// Cleanup
-	int result = row_bounds[(num_blocks - 1) % 3][len];
-	
-	for(int i = 0; i < 3; i++){
-		free(row_bounds[i]);
+	value = top_last;
+	for(int i = 1; i <= height; i++){
+		value += right_dv[i];
+		right[i] = value;
 	}
-	free(col_bounds);
-	return result;
+
+	return bottom_score;
+}
+
+/*
+* Runs the kernel of the given lane width over a len1 x len2 matrix.
+*/
+static long run_lanes(const char *str1, size_t len1, const char *str2, size_t len2,
+	long num_threads, Avx2Lanes lanes, const WavefrontOptions *options){
+	TileKernel kernel;
+	size_t scratch_size;
+	const char *name;
+	switch(lanes){
+		case AVX2_LANES_32:
+			/*
+			* Three diagonals plus the two substrings: about 28 KB per
+			* thread for MAX_TILE_SIZE = 2048, so a tile stays in L1/L2.
+			*/
+			kernel = process_tile;
+			name = "avx2-32";
+			scratch_size = 3 * LANE_ARRAY * sizeof(int) + 2 * LANE_ARRAY;
+			break;
+		case AVX2_LANES_16:
+			kernel = process_tile_16;
+			name = "avx2-16";
+			scratch_size = 3 * LANE_ARRAY * sizeof(int16_t) + 2 * LANE_ARRAY;
+			break;
+		case AVX2_LANES_8:
+			kernel = process_tile_8;
+			name = "avx2";
+			scratch_size = 8 * LANE_ARRAY;
+			break;
+		default:
+			printf("Unsupported AVX2 lane width %d.\n", (int)lanes);
+			return -1;
+	}
+	WavefrontOptions tuned;
+	options = tile_config_options(name, options, BLOCK_SIZE, &tuned);
+	return wavefront_edit_distance_rect(str1, len1, str2, len2, num_threads, MAX_TILE_SIZE,
+		kernel, scratch_size, options);
+}
+
+long avx2_edit_distance_sharded(const char *str1, size_t len1, const char *str2, size_t len2,
+	long num_shards, const WavefrontOptions *options, ShardTransportCreate create_transport){
+	WavefrontOptions tuned;
+	options = tile_config_options("avx2", options, BLOCK_SIZE, &tuned);
+	return sharded_edit_distance_rect(str1, len1, str2, len2, num_shards, MAX_TILE_SIZE,
+		process_tile_8, 8 * LANE_ARRAY, options, create_transport);
+}
+
+long avx2_edit_distance_lanes(const char *str1, const char *str2, size_t len, long num_threads,
+	Avx2Lanes lanes, const WavefrontOptions *options){
+	return run_lanes(str1, len, str2, len, num_threads, lanes, options);
+}
+
+long avx2_edit_distance_rect(const char *str1, size_t len1, const char *str2, size_t len2,
+	long num_threads, const WavefrontOptions *options){
+	return run_lanes(str1, len1, str2, len2, num_threads, AVX2_LANES_8, options);
+}
+
+long avx2_edit_distance_opts(const char *str1, const char *str2, size_t len, long num_threads, const WavefrontOptions *options){
+	return avx2_edit_distance_lanes(str1, str2, len, num_threads, AVX2_LANES_8, options);
+}
+
+long avx2_edit_distance(const char *str1, const char *str2, size_t len, long num_threads){
+	return avx2_edit_distance_opts(str1, str2, len, num_threads, NULL);
+}
+
+int avx2_edit_distance_bounded(const char *str1, const char *str2, size_t len, long num_threads, int k){
+	WavefrontOptions options = {WAVEFRONT_SCHEDULE_DATAFLOW, NULL, 1, k};
+	return avx2_edit_distance_opts(str1, str2, len, num_threads, &options);
 }
\ No newline at end of file
@@ -0,0 +1,48 @@
+#include <stdint.h>
+#include <immintrin.h>
+#include "src/avx2_search.h"
+
+size_t avx2_search_lanes(const uint64_t *peq, int last_bit, long k, uint64_t *pv, uint64_t *mv,
+	long *score, const unsigned char *const *lane_text, size_t from, size_t count){
+	const unsigned char *text0 = lane_text[0];
+	const unsigned char *text1 = lane_text[1];
+	const unsigned char *text2 = lane_text[2];
+	const unsigned char *text3 = lane_text[3];
+	__m256i v_pv = _mm256_loadu_si256((const __m256i*)pv);
+	__m256i v_mv = _mm256_loadu_si256((const __m256i*)mv);
+	__m256i v_score = _mm256_loadu_si256((const __m256i*)score);
+	__m256i ones = _mm256_set1_epi64x(-1);
+	__m256i one = _mm256_set1_epi64x(1);
+	__m256i limit = _mm256_set1_epi64x(k);
+	__m128i high_bit = _mm_cvtsi32_si128(last_bit);
+
+	size_t t = from;
+	for(; t < count; t++){
+		/*
+		* No gather: the four match masks come from scalar loads.
+		*/
+		__m256i eq = _mm256_set_epi64x((long long)peq[text3[t]], (long long)peq[text2[t]],
+			(long long)peq[text1[t]], (long long)peq[text0[t]]);
+
+		// The steps of myers_advance_block() with hin = 0
+		__m256i xv = _mm256_or_si256(eq, v_mv);
+		__m256i xh = _mm256_or_si256(_mm256_xor_si256(_mm256_add_epi64(_mm256_and_si256(eq, v_pv),
+			v_pv), v_pv), eq);
+		__m256i ph = _mm256_or_si256(v_mv, _mm256_xor_si256(_mm256_or_si256(xh, v_pv), ones));
+		__m256i mh = _mm256_and_si256(v_pv, xh);
+		v_score = _mm256_add_epi64(v_score, _mm256_and_si256(_mm256_srl_epi64(ph, high_bit), one));
+		v_score = _mm256_sub_epi64(v_score, _mm256_and_si256(_mm256_srl_epi64(mh, high_bit), one));
+		ph = _mm256_slli_epi64(ph, 1);
+		mh = _mm256_slli_epi64(mh, 1);
+		v_pv = _mm256_or_si256(mh, _mm256_xor_si256(_mm256_or_si256(xv, ph), ones));
+		v_mv = _mm256_and_si256(ph, xv);
+
+		if(_mm256_movemask_epi8(_mm256_cmpgt_epi64(v_score, limit)) != -1){
+			break;
+		}
+	}
+	_mm256_storeu_si256((__m256i*)pv, v_pv);
+	_mm256_storeu_si256((__m256i*)mv, v_mv);
+	_mm256_storeu_si256((__m256i*)score, v_score);
+	return t;
+}
@@ -0,0 +1,334 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include "src/batch_edit_distance.h"
+#include "src/avx2_batch_edit_distance.h"
+#include "src/naive_edit_distance.h"
+#include "src/cpu_features.h"
+#include "src/worker_pool.h"
+#include "src/perf_counters.h"
+#include "src/common_affix.h"
+
+/*
+* A non-trivial pair, oriented so that len1 >= len2, and where its result
+* goes.
+*/
+typedef struct {
+	EditPair pair;
+	size_t index;
+} BatchEntry;
+
+/*
+* Consecutive sorted entries that run together, one per SIMD lane.
+*/
+typedef struct {
+	size_t start;
+	int count;
+	int lanes;
+} BatchGroup;
+
+typedef struct {
+	const BatchEntry *entries;
+	const BatchGroup *groups;
+	size_t num_groups;
+	int use_avx2;
+	int *results;
+	atomic_size_t next_group;
+} BatchArguments;
+
+static int entry_before(const BatchEntry *a, const BatchEntry *b){
+	if(a->pair.len1 != b->pair.len1){
+		return a->pair.len1 < b->pair.len1;
+	}
+	return a->pair.len2 < b->pair.len2;
+}
+
+/*
+* Bottom-up merge sort of n entries by (len1, len2), using temp (n more
+* entries) rather than qsort(), which may allocate.
+*/
+static void sort_entries(BatchEntry *entries, BatchEntry *temp, size_t n){
+	BatchEntry *from = entries;
+	BatchEntry *to = temp;
+	for(size_t width = 1; width < n; width *= 2){
+		for(size_t start = 0; start < n; start += 2 * width){
+			size_t mid = (start + width < n) ? start + width : n;
+			size_t end = (start + 2 * width < n) ? start + 2 * width : n;
+			size_t i = start, j = mid, k = start;
+			while(i < mid && j < end){
+				to[k++] = entry_before(&from[j], &from[i]) ? from[j++] : from[i++];
+			}
+			while(i < mid){
+				to[k++] = from[i++];
+			}
+			while(j < end){
+				to[k++] = from[j++];
+			}
+		}
+		BatchEntry *swap = from;
+		from = to;
+		to = swap;
+	}
+	if(from != entries){
+		memcpy(entries, from, n * sizeof(BatchEntry));
+	}
+}
+
+static int lanes_for(const EditPair *pair){
+	return (pair->len1 <= AVX2_BATCH_MAX_LENGTH_16) ? AVX2_BATCH_LANES_16 : AVX2_BATCH_LANES_32;
+}
+
+/*
+* Worker task: takes groups off a shared counter until none are left, so
+* threads that draw short groups simply run more of them.
+*/
+static void batch_worker(void *task_args, int thread_id, void *scratch){
+	BatchArguments *args = (BatchArguments*)task_args;
+	EditPair lane_pairs[AVX2_BATCH_LANES_16];
+	int lane_results[AVX2_BATCH_LANES_16];
+	PerfThread perf;
+	perf_thread_begin(&perf, thread_id);
+
+	for(;;){
+		size_t g = atomic_fetch_add(&args->next_group, 1);
+		if(g >= args->num_groups){
+			break;
+		}
+		const BatchGroup *group = &args->groups[g];
+		const BatchEntry *entries = &args->entries[group->start];
+
+		for(int l = 0; l < group->count; l++){
+			lane_pairs[l] = entries[l].pair;
+		}
+		perf_tile_begin(&perf);
+		if(!args->use_avx2){
+			for(int l = 0; l < group->count; l++){
+				lane_results[l] = naive_edit_distance_rect(lane_pairs[l].str1, lane_pairs[l].len1,
+					lane_pairs[l].str2, lane_pairs[l].len2);
+			}
+		}
+		else if(group->lanes == AVX2_BATCH_LANES_16){
+			avx2_batch_lanes_16(lane_pairs, group->count, lane_results, scratch);
+		}
+		else{
+			avx2_batch_lanes_32(lane_pairs, group->count, lane_results, scratch);
+		}
+
+		perf_tile_end(&perf);
+
+		for(int l = 0; l < group->count; l++){
+			args->results[entries[l].index] = lane_results[l];
+		}
+	}
+	perf_thread_end(&perf);
+}
+
+int edit_distance_batch(const EditPair *pairs, size_t n, int *results, long num_threads){
+	return edit_distance_batch_ctx(NULL, pairs, n, results, num_threads);
+}
+
+int edit_distance_batch_ctx(EdContext *context, const EditPair *pairs, size_t n, int *results,
+	long num_threads){
+	if(n == 0){
+		return 0;
+	}
+
+	/*
+	* results are ints; a pair whose distance could exceed them belongs
+	* with the single-pair engines.
+	*/
+	for(size_t i = 0; i < n; i++){
+		if(pairs[i].len1 + pairs[i].len2 > (size_t)INT_MAX){
+			printf("Pair %zu is too long for edit_distance_batch().", i);
+			return -1;
+		}
+	}
+	if(context != NULL){
+		ed_context_reset(context);
+	}
+
+	BatchEntry *entries = ed_context_alloc_or_malloc(context, n * sizeof(BatchEntry));
+	BatchEntry *temp = ed_context_alloc_or_malloc(context, n * sizeof(BatchEntry));
+	BatchGroup *groups = ed_context_alloc_or_malloc(context, n * sizeof(BatchGroup));
+	if(entries == NULL || temp == NULL || groups == NULL){
+		printf("Failed to allocate memory in edit_distance_batch().");
+		ed_context_free_if_heap(context, entries);
+		ed_context_free_if_heap(context, temp);
+		ed_context_free_if_heap(context, groups);
+		return -1;
+	}
+
+	/*
+	* Every pair loses its common prefix and suffix first (see
+	* common_affix.h), so near-identical pairs shrink to their differing
+	* middle before they are sized. Pairs with an empty side are then
+	* answered right away. The rest are oriented with the longer string
+	* first (edit distance is symmetric) and sorted by length, so the pairs
+	* sharing a group, whose cost is that of its largest pair, have similar
+	* sizes.
+	*/
+	size_t m = 0;
+	for(size_t i = 0; i < n; i++){
+		EditPair pair = pairs[i];
+		strip_common_affixes(&pair.str1, &pair.len1, &pair.str2, &pair.len2, NULL, NULL);
+		if(pair.len1 == 0 || pair.len2 == 0){
+			results[i] = (int)(pair.len1 + pair.len2);
+			continue;
+		}
+		if(pair.len1 >= pair.len2){
+			entries[m].pair = pair;
+		}
+		else{
+			entries[m].pair.str1 = pair.str2;
+			entries[m].pair.len1 = pair.len2;
+			entries[m].pair.str2 = pair.str1;
+			entries[m].pair.len2 = pair.len1;
+		}
+		entries[m].index = i;
+		m++;
+	}
+	sort_entries(entries, temp, m);
+
+	/*
+	* Cut the sorted pairs into groups of one pair per lane. A group never
+	* mixes 16-bit and 32-bit pairs; the largest pair of each group sets
+	* the scratch it needs.
+	*/
+	size_t num_groups = 0;
+	size_t scratch_size = 0;
+	for(size_t start = 0; start < m; ){
+		int lanes = lanes_for(&entries[start].pair);
+		int count = 0;
+		size_t max_len2 = 0;
+		while(count < lanes && start + count < m && lanes_for(&entries[start + count].pair) == lanes){
+			if(entries[start + count].pair.len2 > max_len2){
+				max_len2 = entries[start + count].pair.len2;
+			}
+			count++;
+		}
+		size_t max_len1 = entries[start + count - 1].pair.len1;
+		size_t needed = avx2_batch_scratch_size(max_len1, max_len2, lanes);
+		if(needed > scratch_size){
+			scratch_size = needed;
+		}
+		groups[num_groups].start = start;
+		groups[num_groups].count = count;
+		groups[num_groups].lanes = lanes;
+		num_groups++;
+		start += count;
+	}
+
+	int status = 0;
+	if(num_groups > 0){
+		if(num_threads > (long)num_groups){
+			num_threads = num_groups;
+		}
+		BatchArguments args;
+		args.entries = entries;
+		args.groups = groups;
+		args.num_groups = num_groups;
+		args.use_avx2 = (cpu_simd_level() >= SIMD_LEVEL_AVX2);
+		args.results = results;
+		atomic_init(&args.next_group, 0);
+
+		WorkerPool *pool = (context != NULL) ? ed_context_pool(context, num_threads)
+			: worker_pool_create(num_threads);
+		if(pool == NULL){
+			status = -1;
+		}
+		else{
+			worker_pool_set_affinity(pool, NULL);
+			status = worker_pool_run(pool, batch_worker, &args, args.use_avx2 ? scratch_size : 0);
+			if(status != 0){
+				printf("Unable to allocate memory for a thread's buffer in edit_distance_batch().");
+			}
+			if(context == NULL){
+				worker_pool_destroy(pool);
+			}
+		}
+	}
+
+	ed_context_free_if_heap(context, entries);
+	ed_context_free_if_heap(context, temp);
+	ed_context_free_if_heap(context, groups);
+	return status;
+}
+
+int edit_pair_is_large(const EditPair *pair){
+	return (double)pair->len1 * pair->len2 >= EDIT_PAIR_LARGE_CELLS;
+}
+
+typedef struct {
+	const EditPair *pairs;
+	size_t n;
+	long *results;
+	EditPairSolver solve;
+	void *solver_args;
+	atomic_size_t next;
+	atomic_int failed;
+} SolveArguments;
+
+/*
+* Takes the small pairs one at a time until none are left.
+*/
+static void solve_worker(void *task_args, int thread_id, void *scratch){
+	(void)thread_id;
+	(void)scratch;
+	SolveArguments *args = (SolveArguments*)task_args;
+	for(;;){
+		size_t i = atomic_fetch_add(&args->next, 1);
+		if(i >= args->n){
+			return;
+		}
+		if(edit_pair_is_large(&args->pairs[i])){
+			continue;
+		}
+		args->results[i] = args->solve(&args->pairs[i], 1, args->solver_args);
+		if(args->results[i] < 0){
+			atomic_store(&args->failed, 1);
+		}
+	}
+}
+
+int edit_pairs_solve(const EditPair *pairs, size_t n, long *results, long num_threads,
+	EditPairSolver solve, void *solver_args){
+	if(num_threads < 1){
+		num_threads = 1;
+	}
+	size_t num_small = 0;
+	for(size_t i = 0; i < n; i++){
+		num_small += !edit_pair_is_large(&pairs[i]);
+	}
+
+	SolveArguments args;
+	args.pairs = pairs;
+	args.n = n;
+	args.results = results;
+	args.solve = solve;
+	args.solver_args = solver_args;
+	atomic_init(&args.next, 0);
+	atomic_init(&args.failed, 0);
+
+	int status = 0;
+	long workers = ((size_t)num_threads < num_small) ? num_threads : (long)num_small;
+	if(workers == 1){
+		solve_worker(&args, 0, NULL);
+	}
+	else if(workers > 1){
+		WorkerPool *pool = worker_pool_create(workers);
+		status = (pool != NULL) ? worker_pool_run(pool, solve_worker, &args, 0) : -1;
+		worker_pool_destroy(pool);
+	}
+	for(size_t i = 0; i < n && status == 0; i++){
+		if(edit_pair_is_large(&pairs[i])){
+			results[i] = solve(&pairs[i], num_threads, solver_args);
+			status = (results[i] < 0) ? -1 : 0;
+		}
+	}
+	if(atomic_load(&args.failed)){
+		status = -1;
+	}
+	return status;
+}
@@ -0,0 +1,1238 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+#include "src/naive_edit_distance.h"
+#include "src/tiled_edit_distance.h"
+#include "src/parallelized_edit_distance.h"
+#include "src/avx2_edit_distance.h"
+#include "src/avx512_edit_distance.h"
+#include "src/sse41_edit_distance.h"
+#include "src/simd_edit_distance.h"
+#include "src/bitparallel_edit_distance.h"
+#include "src/batch_edit_distance.h"
+#include "src/cpu_features.h"
+#include "src/perf_counters.h"
+#include "src/trace.h"
+#include "src/tile_config.h"
+#include "src/tile_tuner.h"
+#include "src/ed_context.h"
+#include "src/alignment.h"
+#include "src/anchored_edit_distance.h"
+#include "src/common_affix.h"
+
+/*
+* Non-interactive benchmark: every selected engine is run on every length
+* and thread count, reps times after warmup untimed runs, and one row of
+* statistics is written per (length, engine, threads) as a table, CSV or
+* JSON. See usage() for the flags.
+*/
+
+#define MAX_LIST 64
+
+/*
+* With --check auto, results are compared against naive_edit_distance()
+* only up to this many DP cells (about a second of naive work).
+*/
+#define CHECK_AUTO_CELLS 400000000.0
+
+/*
+* Same thread limit as main.c
+*/
+#define MAX_THREADS 16
+
+/*
+* Side of the square input --tune times every tile shape on
+*/
+#define TUNE_LENGTH 8192
+
+typedef enum {
+	FORMAT_TABLE,
+	FORMAT_CSV,
+	FORMAT_JSON
+} BenchFormat;
+
+typedef enum {
+	CHECK_AUTO,
+	CHECK_ALWAYS,
+	CHECK_NEVER
+} BenchCheck;
+
+/*
+* One generated input: a single pair for the per-pair engines, num_pairs
+* pairs of the same lengths for the batch engine.
+*/
+typedef struct {
+	const char *str1;
+	size_t len1;
+	const char *str2;
+	size_t len2;
+	const EditPair *pairs;
+	size_t num_pairs;
+	int *results;
+	const WavefrontOptions *options;
+	EdContext *context;	// NULL unless --context
+	double cells;		// DP cells left after stripping, over all pairs
+} BenchInput;
+
+/*
+* Returns the distance (per-pair engines) or the status of the call
+* (batch engine), -1 on failure.
+*/
+typedef long (*BenchRun)(const BenchInput *input, long num_threads);
+
+typedef struct {
+	const char *name;
+	BenchRun run;
+	int threaded;		// takes a thread count
+	int square_only;	// only exposed for len1 == len2
+	int batch;		// runs input->pairs instead of str1/str2
+	SimdLevel level;	// minimum instruction set
+} BenchEngine;
+
+typedef struct {
+	size_t len1[MAX_LIST];
+	size_t len2[MAX_LIST];
+	int num_lengths;
+	long threads[MAX_LIST];
+	int num_threads;
+	const BenchEngine *engines[MAX_LIST];
+	int num_engines;
+	int reps;
+	int warmup;
+	int alphabet;
+	double mutation;
+	uint64_t seed;
+	size_t num_pairs;
+	BenchFormat format;
+	BenchCheck check;
+	WavefrontSchedule schedule;
+	int perf;		// one extra counted run per row (make PERF=1)
+	int perf_tiles;		// ... also counting every tile call
+	const char *trace_path;	// one extra traced run per row if set
+	size_t trace_events;
+	int tile_height;	// 0: the engine's tuned or default shape
+	int tile_width;
+	int tune;		// tune the engines' tile shapes instead
+	WavefrontAffinity affinity;
+	int context;		// reuse one EdContext for every run of a length
+	int huge_pages;
+	const char *checkpoint_path;	// time checkpointing instead if set
+	long checkpoint_every[MAX_LIST];
+	int num_checkpoint_every;
+} BenchConfig;
+
+/*
+* Statistics of one (length, engine, threads) row
+*/
+typedef struct {
+	const BenchEngine *engine;
+	size_t len1;
+	size_t len2;
+	size_t num_pairs;
+	long threads;
+	double min_ms;
+	double median_ms;
+	double p95_ms;
+	double gcups;
+	double efficiency;	// < 0 if there is no 1-thread run to compare to
+	const char *check;
+	long result;
+	const PerfReport *perf;	// NULL unless config->perf
+} BenchRow;
+
+static long run_naive(const BenchInput *in, long num_threads){
+	(void)num_threads;
+	return naive_edit_distance_rect(in->str1, in->len1, in->str2, in->len2);
+}
+
+static long run_tiled(const BenchInput *in, long num_threads){
+	(void)num_threads;
+	if(in->context != NULL){
+		return tiled_edit_distance_ctx(in->context, in->str1, in->len1, in->str2, in->len2,
+			in->options->tile_height, in->options->tile_width);
+	}
+	return tiled_edit_distance_shape(in->str1, in->len1, in->str2, in->len2,
+		in->options->tile_height, in->options->tile_width);
+}
+
+static long run_parallel(const BenchInput *in, long num_threads){
+	return parallelized_edit_distance_rect(in->str1, in->len1, in->str2, in->len2, num_threads, in->options);
+}
+
+static long run_avx2(const BenchInput *in, long num_threads){
+	return avx2_edit_distance_rect(in->str1, in->len1, in->str2, in->len2, num_threads, in->options);
+}
+
+static long run_avx2_16(const BenchInput *in, long num_threads){
+	return avx2_edit_distance_lanes(in->str1, in->str2, in->len1, num_threads, AVX2_LANES_16, in->options);
+}
+
+static long run_avx2_32(const BenchInput *in, long num_threads){
+	return avx2_edit_distance_lanes(in->str1, in->str2, in->len1, num_threads, AVX2_LANES_32, in->options);
+}
+
+static long run_avx512(const BenchInput *in, long num_threads){
+	return avx512_edit_distance_rect(in->str1, in->len1, in->str2, in->len2, num_threads, in->options);
+}
+
+static long run_sse41(const BenchInput *in, long num_threads){
+	return sse41_edit_distance_rect(in->str1, in->len1, in->str2, in->len2, num_threads, in->options);
+}
+
+static long run_simd(const BenchInput *in, long num_threads){
+	return simd_edit_distance_rect(in->str1, in->len1, in->str2, in->len2, num_threads, in->options);
+}
+
+static long run_bitparallel(const BenchInput *in, long num_threads){
+	return bitparallel_edit_distance_threads(in->str1, in->len1, in->str2, in->len2, num_threads, in->options);
+}
+
+static long run_batch(const BenchInput *in, long num_threads){
+	if(in->context != NULL){
+		return edit_distance_batch_ctx(in->context, in->pairs, in->num_pairs, in->results, num_threads);
+	}
+	return edit_distance_batch(in->pairs, in->num_pairs, in->results, num_threads);
+}
+
+/*
+* Full alignment (Hirschberg), timed end to end including the CIGAR runs
+*/
+static long run_align(const BenchInput *in, long num_threads){
+	Alignment alignment;
+	long result = edit_distance_align(in->str1, in->len1, in->str2, in->len2, num_threads, &alignment);
+	alignment_free(&alignment);
+	return result;
+}
+
+/*
+* Exact anchored stage in front of the SIMD engine; worth comparing with
+* simd at low --mutation rates
+*/
+static long run_anchored(const BenchInput *in, long num_threads){
+	return anchored_edit_distance(in->str1, in->len1, in->str2, in->len2, num_threads, NULL);
+}
+
+static const BenchEngine engines[] = {
+	{"naive", run_naive, 0, 0, 0, SIMD_LEVEL_SCALAR},
+	{"tiled", run_tiled, 0, 0, 0, SIMD_LEVEL_SCALAR},
+	{"parallel", run_parallel, 1, 0, 0, SIMD_LEVEL_SCALAR},
+	{"sse41", run_sse41, 1, 0, 0, SIMD_LEVEL_SSE41},
+	{"avx2", run_avx2, 1, 0, 0, SIMD_LEVEL_AVX2},
+	{"avx2-16", run_avx2_16, 1, 1, 0, SIMD_LEVEL_AVX2},
+	{"avx2-32", run_avx2_32, 1, 1, 0, SIMD_LEVEL_AVX2},
+	{"avx512", run_avx512, 1, 0, 0, SIMD_LEVEL_AVX512},
+	{"simd", run_simd, 1, 0, 0, SIMD_LEVEL_SCALAR},
+	{"bitparallel", run_bitparallel, 1, 0, 0, SIMD_LEVEL_SCALAR},
+	{"batch", run_batch, 1, 0, 1, SIMD_LEVEL_SCALAR},
+	{"align", run_align, 1, 0, 0, SIMD_LEVEL_SCALAR},
+	{"anchored", run_anchored, 1, 0, 0, SIMD_LEVEL_SCALAR}
+};
+#define NUM_ENGINES (sizeof(engines) / sizeof(engines[0]))
+
+static const char charset[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+static double returnCurrentTime() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1000 + (double)ts.tv_nsec / 1e6;
+}
+
+/*
+* xorshift64*: reproducible from --seed, independent of rand()
+*/
+static uint64_t next_random(uint64_t *state){
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * 2685821657736338717ULL;
+}
+
+static double next_uniform(uint64_t *state){
+	return (next_random(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static char random_char(uint64_t *state, int alphabet){
+	return charset[next_random(state) % alphabet];
+}
+
+/*
+* Fills str1 with len1 random characters and str2 with len2 characters
+* derived from it: every character of str1 is substituted, deleted, or
+* gets a random character inserted before it with probability
+* mutation / 3 each. The result is then cut or padded (randomly) to len2,
+* so mutation = 0 and len1 == len2 gives identical strings.
+*/
+static void generate_pair(char *str1, size_t len1, char *str2, size_t len2,
+	int alphabet, double mutation, uint64_t *state){
+	for(size_t i = 0; i < len1; i++){
+		str1[i] = random_char(state, alphabet);
+	}
+
+	size_t j = 0;
+	for(size_t i = 0; i < len1 && j < len2; i++){
+		double r = next_uniform(state);
+		if(r < mutation / 3){
+			char c = random_char(state, alphabet);
+			if(alphabet > 1){
+				while(c == str1[i]){
+					c = random_char(state, alphabet);
+				}
+			}
+			str2[j++] = c;
+		}
+		else if(r < 2 * mutation / 3){
+			continue;
+		}
+		else if(r < mutation){
+			str2[j++] = random_char(state, alphabet);
+			if(j < len2){
+				str2[j++] = str1[i];
+			}
+		}
+		else{
+			str2[j++] = str1[i];
+		}
+	}
+	while(j < len2){
+		str2[j++] = random_char(state, alphabet);
+	}
+}
+
+/*
+* Parses a size with an optional k/m/g suffix (powers of 1000).
+* Returns 0 on success.
+*/
+static int parse_size(const char *text, size_t *value){
+	char *end;
+	double v = strtod(text, &end);
+	if(end == text || v < 0){
+		return -1;
+	}
+	if(*end == 'k' || *end == 'K'){
+		v *= 1e3;
+		end++;
+	}
+	else if(*end == 'm' || *end == 'M'){
+		v *= 1e6;
+		end++;
+	}
+	else if(*end == 'g' || *end == 'G'){
+		v *= 1e9;
+		end++;
+	}
+	if(*end != '\0'){
+		return -1;
+	}
+	*value = (size_t)v;
+	return 0;
+}
+
+/*
+* --lengths is a comma separated list of entries, each one of
+*   N           a pair of two N character strings
+*   NxM         an N character string against an M character one
+*   A:B[:F]     N = A, A*F, A*F^2, ... up to B (F defaults to 2)
+*/
+static int parse_lengths(char *text, BenchConfig *config){
+	config->num_lengths = 0;
+	for(char *entry = strtok(text, ","); entry != NULL; entry = strtok(NULL, ",")){
+		char *x = strchr(entry, 'x');
+		char *colon = strchr(entry, ':');
+		size_t len1, len2;
+
+		if(colon != NULL){
+			*colon = '\0';
+			char *colon2 = strchr(colon + 1, ':');
+			size_t factor = 2;
+			size_t last;
+			if(colon2 != NULL){
+				*colon2 = '\0';
+				if(parse_size(colon2 + 1, &factor) != 0 || factor < 2){
+					return -1;
+				}
+			}
+			if(parse_size(entry, &len1) != 0 || parse_size(colon + 1, &last) != 0 || len1 == 0){
+				return -1;
+			}
+			for(; len1 <= last; len1 *= factor){
+				if(config->num_lengths == MAX_LIST){
+					return -1;
+				}
+				config->len1[config->num_lengths] = len1;
+				config->len2[config->num_lengths] = len1;
+				config->num_lengths++;
+			}
+			continue;
+		}
+
+		if(x != NULL){
+			*x = '\0';
+			if(parse_size(entry, &len1) != 0 || parse_size(x + 1, &len2) != 0){
+				return -1;
+			}
+		}
+		else{
+			if(parse_size(entry, &len1) != 0){
+				return -1;
+			}
+			len2 = len1;
+		}
+		if(config->num_lengths == MAX_LIST){
+			return -1;
+		}
+		config->len1[config->num_lengths] = len1;
+		config->len2[config->num_lengths] = len2;
+		config->num_lengths++;
+	}
+	return config->num_lengths > 0 ? 0 : -1;
+}
+
+static int compare_longs(const void *a, const void *b){
+	long x = *(const long*)a;
+	long y = *(const long*)b;
+	return (x > y) - (x < y);
+}
+
+/*
+* Thread counts are sorted, so the 1-thread run that parallel efficiency
+* is measured against comes first.
+*/
+static int parse_threads(char *text, BenchConfig *config){
+	config->num_threads = 0;
+	for(char *entry = strtok(text, ","); entry != NULL; entry = strtok(NULL, ",")){
+		char *end;
+		long threads = strtol(entry, &end, 10);
+		if(*end != '\0' || threads < 1 || config->num_threads == MAX_LIST){
+			return -1;
+		}
+		config->threads[config->num_threads++] = threads;
+	}
+	qsort(config->threads, config->num_threads, sizeof(long), compare_longs);
+	return config->num_threads > 0 ? 0 : -1;
+}
+
+static int parse_checkpoint_every(char *text, BenchConfig *config){
+	config->num_checkpoint_every = 0;
+	for(char *entry = strtok(text, ","); entry != NULL; entry = strtok(NULL, ",")){
+		char *end;
+		long every = strtol(entry, &end, 10);
+		if(*end != '\0' || every < 1 || config->num_checkpoint_every == MAX_LIST){
+			return -1;
+		}
+		config->checkpoint_every[config->num_checkpoint_every++] = every;
+	}
+	return config->num_checkpoint_every > 0 ? 0 : -1;
+}
+
+static int parse_engines(char *text, BenchConfig *config){
+	config->num_engines = 0;
+	for(char *entry = strtok(text, ","); entry != NULL; entry = strtok(NULL, ",")){
+		size_t e = 0;
+		while(e < NUM_ENGINES && strcmp(engines[e].name, entry) != 0){
+			e++;
+		}
+		if(e == NUM_ENGINES || config->num_engines == MAX_LIST){
+			fprintf(stderr, "Unknown engine: %s\n", entry);
+			return -1;
+		}
+		config->engines[config->num_engines++] = &engines[e];
+	}
+	return config->num_engines > 0 ? 0 : -1;
+}
+
+static void usage(const char *program){
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  --lengths LIST    comma separated N, NxM or A:B[:F] (sweep), k/m suffixes (default 10k)\n"
+		"  --threads LIST    comma separated thread counts (default 1,<processors>)\n"
+		"  --engines LIST    comma separated engines (default tiled,parallel,simd,bitparallel), or all\n"
+		"  --reps N          timed runs per row (default 5)\n"
+		"  --warmup N        untimed runs before them (default 1)\n"
+		"  --alphabet N      characters used, 1 to 26 (default 4)\n"
+		"  --mutation R      per-character edit rate of str2 against str1, 0 to 1 (default 0.1)\n"
+		"  --pairs N         pairs per run for the batch engine (default 10000)\n"
+		"  --seed N          random seed (default 1)\n"
+		"  --format F        table, csv or json (default table)\n"
+		"  --schedule S      tile schedule of the wavefront engines: dataflow or barrier (default dataflow)\n"
+		"  --check C         compare against naive_edit_distance(): auto (up to %.0e cells), always or never\n"
+		"  --perf            hardware counters from one extra run per row (needs make PERF=1)\n"
+		"  --perf-tiles      same, and also count inside every tile call\n"
+		"  --trace FILE      write a Chrome trace (JSON) of one extra run per row to FILE\n"
+		"  --trace-events N  events kept per thread, the oldest are overwritten (default 65536)\n"
+		"  --affinity A      workers of the wavefront engines: none or pinned (cores, NUMA first touch)\n"
+		"  --context         run the tiled, wavefront and batch engines with a reused ed_context\n"
+		"  --huge-pages      back that context with huge pages\n"
+		"  --tile HxW        tile shape of the tiled and wavefront engines (default: tuned, else built in)\n"
+		"  --tune            time every tile shape of the engines on a %dx%d input, save the fastest\n"
+		"                    to the tile cache and exit\n"
+		"  --checkpoint FILE time the wavefront engines with checkpoints written to FILE against\n"
+		"                    none (barrier schedule) and exit\n"
+		"  --checkpoint-every LIST  comma separated checkpoint intervals in waves (default 1,4,16,64)\n"
+		"Engines:",
+		program, CHECK_AUTO_CELLS, TUNE_LENGTH, TUNE_LENGTH);
+	for(size_t e = 0; e < NUM_ENGINES; e++){
+		fprintf(stderr, " %s", engines[e].name);
+	}
+	fprintf(stderr, "\n");
+}
+
+static int parse_args(int argc, char **argv, BenchConfig *config){
+	static const struct option long_options[] = {
+		{"lengths", required_argument, NULL, 'l'},
+		{"threads", required_argument, NULL, 't'},
+		{"engines", required_argument, NULL, 'e'},
+		{"reps", required_argument, NULL, 'r'},
+		{"warmup", required_argument, NULL, 'w'},
+		{"alphabet", required_argument, NULL, 'a'},
+		{"mutation", required_argument, NULL, 'm'},
+		{"pairs", required_argument, NULL, 'p'},
+		{"seed", required_argument, NULL, 's'},
+		{"format", required_argument, NULL, 'f'},
+		{"check", required_argument, NULL, 'c'},
+		{"schedule", required_argument, NULL, 'S'},
+		{"perf", no_argument, NULL, 'P'},
+		{"perf-tiles", no_argument, NULL, 'T'},
+		{"trace", required_argument, NULL, 'o'},
+		{"trace-events", required_argument, NULL, 'n'},
+		{"tile", required_argument, NULL, 'x'},
+		{"tune", no_argument, NULL, 'u'},
+		{"affinity", required_argument, NULL, 'A'},
+		{"context", no_argument, NULL, 'C'},
+		{"huge-pages", no_argument, NULL, 'H'},
+		{"checkpoint", required_argument, NULL, 'k'},
+		{"checkpoint-every", required_argument, NULL, 'K'},
+		{"help", no_argument, NULL, 'h'},
+		{NULL, 0, NULL, 0}
+	};
+
+	/*
+	* Defaults
+	*/
+	char default_lengths[] = "10k";
+	char default_engines[] = "tiled,parallel,simd,bitparallel";
+	char default_checkpoint_every[] = "1,4,16,64";
+	long num_processors = sysconf(_SC_NPROCESSORS_ONLN);
+	parse_lengths(default_lengths, config);
+	parse_engines(default_engines, config);
+	config->threads[0] = 1;
+	config->num_threads = 1;
+	if(num_processors > 1){
+		config->threads[1] = (num_processors > MAX_THREADS) ? MAX_THREADS : num_processors;
+		config->num_threads = 2;
+	}
+	config->reps = 5;
+	config->warmup = 1;
+	config->alphabet = 4;
+	config->mutation = 0.1;
+	config->seed = 1;
+	config->num_pairs = 10000;
+	config->format = FORMAT_TABLE;
+	config->check = CHECK_AUTO;
+	config->schedule = WAVEFRONT_SCHEDULE_DATAFLOW;
+	config->perf = 0;
+	config->perf_tiles = 0;
+	config->trace_path = NULL;
+	config->trace_events = 65536;
+	config->tile_height = 0;
+	config->tile_width = 0;
+	config->tune = 0;
+	config->affinity = WAVEFRONT_AFFINITY_NONE;
+	config->context = 0;
+	config->huge_pages = 0;
+	config->checkpoint_path = NULL;
+	parse_checkpoint_every(default_checkpoint_every, config);
+
+	int opt;
+	while((opt = getopt_long(argc, argv, "l:t:e:r:w:a:m:p:s:f:c:h", long_options, NULL)) != -1){
+		int ok = 1;
+		switch(opt){
+			case 'l':
+				ok = (parse_lengths(optarg, config) == 0);
+				break;
+			case 't':
+				ok = (parse_threads(optarg, config) == 0);
+				break;
+			case 'e':
+				if(strcmp(optarg, "all") == 0){
+					config->num_engines = NUM_ENGINES;
+					for(size_t e = 0; e < NUM_ENGINES; e++){
+						config->engines[e] = &engines[e];
+					}
+				}
+				else{
+					ok = (parse_engines(optarg, config) == 0);
+				}
+				break;
+			case 'r':
+				config->reps = atoi(optarg);
+				ok = (config->reps >= 1);
+				break;
+			case 'w':
+				config->warmup = atoi(optarg);
+				ok = (config->warmup >= 0);
+				break;
+			case 'a':
+				config->alphabet = atoi(optarg);
+				ok = (config->alphabet >= 1 && config->alphabet <= (int)(sizeof(charset) - 1));
+				break;
+			case 'm':
+				config->mutation = atof(optarg);
+				ok = (config->mutation >= 0 && config->mutation <= 1);
+				break;
+			case 'p':
+				ok = (parse_size(optarg, &config->num_pairs) == 0 && config->num_pairs > 0);
+				break;
+			case 's':
+				config->seed = strtoull(optarg, NULL, 10);
+				break;
+			case 'f':
+				if(strcmp(optarg, "table") == 0) { config->format = FORMAT_TABLE; }
+				else if(strcmp(optarg, "csv") == 0) { config->format = FORMAT_CSV; }
+				else if(strcmp(optarg, "json") == 0) { config->format = FORMAT_JSON; }
+				else { ok = 0; }
+				break;
+			case 'c':
+				if(strcmp(optarg, "auto") == 0) { config->check = CHECK_AUTO; }
+				else if(strcmp(optarg, "always") == 0) { config->check = CHECK_ALWAYS; }
+				else if(strcmp(optarg, "never") == 0) { config->check = CHECK_NEVER; }
+				else { ok = 0; }
+				break;
+			case 'S':
+				if(strcmp(optarg, "dataflow") == 0) { config->schedule = WAVEFRONT_SCHEDULE_DATAFLOW; }
+				else if(strcmp(optarg, "barrier") == 0) { config->schedule = WAVEFRONT_SCHEDULE_BARRIER; }
+				else { ok = 0; }
+				break;
+			case 'T':
+				config->perf_tiles = 1;
+				// fall through
+			case 'P':
+				config->perf = 1;
+#ifndef EDIT_DISTANCE_PERF
+				fprintf(stderr, "--perf needs a build with the counters in: make clean && make bench PERF=1\n");
+				return -1;
+#endif
+				break;
+			case 'o':
+				config->trace_path = optarg;
+				break;
+			case 'n':
+				ok = (parse_size(optarg, &config->trace_events) == 0 && config->trace_events > 0);
+				break;
+			case 'x':
+				ok = (sscanf(optarg, "%dx%d", &config->tile_height, &config->tile_width) == 2
+					&& config->tile_height > 0 && config->tile_width > 0);
+				break;
+			case 'u':
+				config->tune = 1;
+				break;
+			case 'H':
+				config->huge_pages = 1;
+				// fall through
+			case 'C':
+				config->context = 1;
+				break;
+			case 'k':
+				config->checkpoint_path = optarg;
+				break;
+			case 'K':
+				ok = (parse_checkpoint_every(optarg, config) == 0);
+				break;
+			case 'A':
+				if(strcmp(optarg, "none") == 0) { config->affinity = WAVEFRONT_AFFINITY_NONE; }
+				else if(strcmp(optarg, "pinned") == 0) { config->affinity = WAVEFRONT_AFFINITY_PINNED; }
+				else { ok = 0; }
+				break;
+			default:
+				ok = 0;
+				break;
+		}
+		if(!ok){
+			usage(argv[0]);
+			return -1;
+		}
+	}
+	if(optind < argc){
+		usage(argv[0]);
+		return -1;
+	}
+	// xorshift never leaves 0
+	if(config->seed == 0){
+		config->seed = 1;
+	}
+	return 0;
+}
+
+static int compare_doubles(const void *a, const void *b){
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+#ifdef EDIT_DISTANCE_PERF
+static void print_perf_text(const PerfReport *report, const PerfSample *sample){
+	for(int c = 0; c < PERF_NUM_COUNTERS; c++){
+		if(report->available & (1u << c)){
+			printf(" %s=%llu", perf_counter_name(c), (unsigned long long)sample->value[c]);
+		}
+		else{
+			printf(" %s=n/a", perf_counter_name(c));
+		}
+	}
+	if(sample->value[PERF_CYCLES] > 0){
+		printf(" ipc=%.2f", (double)sample->value[PERF_INSTRUCTIONS] / sample->value[PERF_CYCLES]);
+	}
+}
+
+static void print_perf_json(const PerfReport *report, const PerfSample *sample){
+	printf("{");
+	for(int c = 0; c < PERF_NUM_COUNTERS; c++){
+		printf("%s\"%s\": ", c ? ", " : "", perf_counter_name(c));
+		if(report->available & (1u << c)){
+			printf("%llu", (unsigned long long)sample->value[c]);
+		}
+		else{
+			printf("null");
+		}
+	}
+	printf("}");
+}
+
+/*
+* Table: one line for the run, one per thread and the tile totals.
+* Comparing the tile task clock with the thread's shows how much of the
+* run went to scheduling and waiting rather than to the kernel.
+*/
+static void print_perf_table(const PerfReport *report){
+	long calls = 0;
+	for(long t = 0; t < report->num_threads; t++){
+		calls += report->tile_calls[t];
+	}
+	// Engines without tiles (naive, tiled) have nothing to show per tile
+	int per_tile = report->per_tile && calls > 0;
+
+	printf("    total:");
+	print_perf_text(report, &report->total);
+	printf("\n");
+	for(long t = 0; t < report->num_threads; t++){
+		printf("    thread %ld:", t);
+		print_perf_text(report, &report->thread[t]);
+		if(per_tile && report->thread[t].value[PERF_TASK_CLOCK] > 0){
+			printf(" in_tiles=%.1f%%", 100.0 * report->tile[t].value[PERF_TASK_CLOCK]
+				/ report->thread[t].value[PERF_TASK_CLOCK]);
+		}
+		printf("\n");
+	}
+	if(per_tile){
+		PerfSample tiles = {{0}};
+		for(long t = 0; t < report->num_threads; t++){
+			for(int c = 0; c < PERF_NUM_COUNTERS; c++){
+				tiles.value[c] += report->tile[t].value[c];
+			}
+		}
+		printf("    tiles (%ld calls):", calls);
+		print_perf_text(report, &tiles);
+		printf("\n");
+	}
+}
+#endif
+
+static void print_header(const BenchConfig *config){
+	BenchFormat format = config->format;
+	if(format == FORMAT_TABLE){
+		printf("%-12s %10s %10s %7s %7s %10s %10s %10s %8s %12s %6s %6s\n",
+			"engine", "len1", "len2", "pairs", "threads", "min_ms", "median_ms", "p95_ms",
+			"gcups", "pairs_per_s", "eff", "check");
+	}
+	else if(format == FORMAT_CSV){
+		printf("engine,len1,len2,pairs,threads,reps,min_ms,median_ms,p95_ms,gcups,pairs_per_s,efficiency,check,result");
+#ifdef EDIT_DISTANCE_PERF
+		if(config->perf){
+			for(int c = 0; c < PERF_NUM_COUNTERS; c++){
+				printf(",%s", perf_counter_name(c));
+			}
+			if(config->perf_tiles){
+				printf(",tile_calls,tile_task_clock_ns,tile_cycles");
+			}
+		}
+#endif
+		printf("\n");
+	}
+	else{
+		printf("[");
+	}
+}
+
+static void print_row(const BenchConfig *config, const BenchRow *row, int first){
+	double pairs_per_s = row->num_pairs / (row->median_ms / 1000);
+	if(config->format == FORMAT_TABLE){
+		char efficiency[16] = "-";
+		if(row->efficiency >= 0){
+			snprintf(efficiency, sizeof(efficiency), "%.2f", row->efficiency);
+		}
+		printf("%-12s %10zu %10zu %7zu %7ld %10.3f %10.3f %10.3f %8.3f %12.0f %6s %6s\n",
+			row->engine->name, row->len1, row->len2, row->num_pairs, row->threads,
+			row->min_ms, row->median_ms, row->p95_ms, row->gcups, pairs_per_s,
+			efficiency, row->check);
+	}
+	else if(config->format == FORMAT_CSV){
+		printf("%s,%zu,%zu,%zu,%ld,%d,%.6f,%.6f,%.6f,%.6f,%.3f,",
+			row->engine->name, row->len1, row->len2, row->num_pairs, row->threads, config->reps,
+			row->min_ms, row->median_ms, row->p95_ms, row->gcups, pairs_per_s);
+		if(row->efficiency >= 0){
+			printf("%.4f", row->efficiency);
+		}
+		printf(",%s,%ld", row->check, row->result);
+#ifdef EDIT_DISTANCE_PERF
+		if(row->perf != NULL){
+			const PerfReport *report = row->perf;
+			for(int c = 0; c < PERF_NUM_COUNTERS; c++){
+				printf(",");
+				if(report->available & (1u << c)){
+					printf("%llu", (unsigned long long)report->total.value[c]);
+				}
+			}
+			if(config->perf_tiles){
+				long calls = 0;
+				unsigned long long clock = 0, cycles = 0;
+				for(long t = 0; t < report->num_threads; t++){
+					calls += report->tile_calls[t];
+					clock += report->tile[t].value[PERF_TASK_CLOCK];
+					cycles += report->tile[t].value[PERF_CYCLES];
+				}
+				printf(",%ld,%llu,", calls, clock);
+				if(report->available & (1u << PERF_CYCLES)){
+					printf("%llu", cycles);
+				}
+			}
+		}
+#endif
+		printf("\n");
+	}
+	else{
+		printf("%s\n  {\"engine\": \"%s\", \"len1\": %zu, \"len2\": %zu, \"pairs\": %zu, \"threads\": %ld, "
+			"\"reps\": %d, \"min_ms\": %.6f, \"median_ms\": %.6f, \"p95_ms\": %.6f, \"gcups\": %.6f, "
+			"\"pairs_per_s\": %.3f, \"efficiency\": ",
+			first ? "" : ",", row->engine->name, row->len1, row->len2, row->num_pairs, row->threads,
+			config->reps, row->min_ms, row->median_ms, row->p95_ms, row->gcups, pairs_per_s);
+		if(row->efficiency >= 0){
+			printf("%.4f", row->efficiency);
+		}
+		else{
+			printf("null");
+		}
+		printf(", \"check\": \"%s\", \"result\": %ld", row->check, row->result);
+#ifdef EDIT_DISTANCE_PERF
+		if(row->perf != NULL){
+			const PerfReport *report = row->perf;
+			printf(", \"perf\": {\"total\": ");
+			print_perf_json(report, &report->total);
+			printf(", \"threads\": [");
+			for(long t = 0; t < report->num_threads; t++){
+				printf("%s", t ? ", " : "");
+				print_perf_json(report, &report->thread[t]);
+			}
+			printf("]");
+			if(report->per_tile){
+				printf(", \"tiles\": [");
+				for(long t = 0; t < report->num_threads; t++){
+					printf("%s{\"calls\": %ld, \"counters\": ", t ? ", " : "", report->tile_calls[t]);
+					print_perf_json(report, &report->tile[t]);
+					printf("}");
+				}
+				printf("]");
+			}
+			printf("}");
+		}
+#endif
+		printf("}");
+	}
+#ifdef EDIT_DISTANCE_PERF
+	if(config->format == FORMAT_TABLE && row->perf != NULL){
+		print_perf_table(row->perf);
+	}
+#endif
+	fflush(stdout);
+}
+
+static void print_footer(BenchFormat format){
+	if(format == FORMAT_JSON){
+		printf("\n]\n");
+	}
+}
+
+/*
+* Cells of the matrix the engines actually compute: what is left once
+* the common prefix and suffix are dropped (see common_affix.h).
+*/
+static double stripped_cells(const char *str1, size_t len1, const char *str2, size_t len2){
+	strip_common_affixes(&str1, &len1, &str2, &len2, NULL, NULL);
+	return (double)len1 * len2;
+}
+
+/*
+* Times reps runs (after config->warmup untimed ones) and fills in the
+* timing columns of row. times must hold config->reps entries.
+* Returns the result of the last run.
+*/
+static long time_engine(const BenchConfig *config, const BenchEngine *engine, const BenchInput *input,
+	long threads, double *times, BenchRow *row){
+	long result = 0;
+	for(int w = 0; w < config->warmup; w++){
+		engine->run(input, threads);
+	}
+	for(int r = 0; r < config->reps; r++){
+		double start = returnCurrentTime();
+		result = engine->run(input, threads);
+		times[r] = returnCurrentTime() - start;
+	}
+	qsort(times, config->reps, sizeof(double), compare_doubles);
+
+	int reps = config->reps;
+	int p95 = (int)(0.95 * reps + 0.999999) - 1;
+	row->min_ms = times[0];
+	row->median_ms = (reps % 2) ? times[reps / 2] : (times[reps / 2 - 1] + times[reps / 2]) / 2;
+	row->p95_ms = times[p95 < 0 ? 0 : p95];
+	// Hirschberg asks for whole last rows, which are never stripped
+	double cells = (engine->run == run_align) ? (double)input->len1 * input->len2 : input->cells;
+	row->gcups = cells / (row->median_ms / 1000) / 1e9;
+	return result;
+}
+
+/*
+* Runs every engine on one length. Returns the number of failed checks,
+* or -1 if the input could not be allocated.
+*/
+static int bench_length(const BenchConfig *config, size_t len1, size_t len2, uint64_t *state,
+	Trace *trace, int *first_row){
+	int failures = 0;
+	int needs_batch = 0;
+	for(int e = 0; e < config->num_engines; e++){
+		needs_batch |= config->engines[e]->batch;
+	}
+	size_t num_pairs = needs_batch ? config->num_pairs : 0;
+
+	char *str1 = malloc(len1 + 1);
+	char *str2 = malloc(len2 + 1);
+	char *pair_strings = malloc(num_pairs * (len1 + len2) + 1);
+	EditPair *pairs = malloc(num_pairs * sizeof(EditPair) + 1);
+	int *results = malloc(num_pairs * sizeof(int) + 1);
+	int *expected_pairs = malloc(num_pairs * sizeof(int) + 1);
+	double *times = malloc(config->reps * sizeof(double));
+	PerfReport *report = malloc(sizeof(PerfReport));
+	if(report == NULL || str1 == NULL || str2 == NULL || pair_strings == NULL || pairs == NULL || results == NULL
+		|| expected_pairs == NULL || times == NULL){
+		printf("Unable to allocate the input for %zux%zu.\n", len1, len2);
+		free(str1); free(str2); free(pair_strings); free(pairs);
+		free(results); free(expected_pairs); free(times); free(report);
+		return -1;
+	}
+
+	generate_pair(str1, len1, str2, len2, config->alphabet, config->mutation, state);
+	str1[len1] = '\0';
+	str2[len2] = '\0';
+	for(size_t p = 0; p < num_pairs; p++){
+		char *s1 = pair_strings + p * (len1 + len2);
+		generate_pair(s1, len1, s1 + len1, len2, config->alphabet, config->mutation, state);
+		pairs[p] = (EditPair){s1, len1, s1 + len1, len2};
+	}
+
+	/*
+	* --context: one workspace for every run of this length, so only the
+	* first run of each engine pays for its memory and threads.
+	*/
+	EdContext *context = NULL;
+	if(config->context){
+		long max_threads = 1;
+		for(int t = 0; t < config->num_threads; t++){
+			max_threads = (config->threads[t] > max_threads) ? config->threads[t] : max_threads;
+		}
+		context = ed_context_create((len1 > len2) ? len1 : len2, max_threads,
+			config->huge_pages ? ED_CONTEXT_HUGE_PAGES : 0);
+		if(context == NULL){
+			free(str1); free(str2); free(pair_strings); free(pairs);
+			free(results); free(expected_pairs); free(times); free(report);
+			return -1;
+		}
+	}
+
+	WavefrontOptions options = {config->schedule, NULL, 0, 0, config->tile_height, config->tile_width,
+		config->affinity, context};
+	BenchInput single = {str1, len1, str2, len2, NULL, 1, NULL, &options, context,
+		stripped_cells(str1, len1, str2, len2)};
+	BenchInput batch = {NULL, len1, NULL, len2, pairs, num_pairs, results, &options, context, 0};
+	for(size_t p = 0; p < num_pairs; p++){
+		batch.cells += stripped_cells(pairs[p].str1, len1, pairs[p].str2, len2);
+	}
+
+	/*
+	* Expected results are computed once, when the first engine needs them
+	*/
+	int have_expected = 0, have_expected_pairs = 0;
+	long expected = 0;
+
+	for(int e = 0; e < config->num_engines; e++){
+		const BenchEngine *engine = config->engines[e];
+		const BenchInput *input = engine->batch ? &batch : &single;
+
+		if(cpu_simd_level() < engine->level){
+			fprintf(stderr, "Skipping %s: not supported by this CPU (%s).\n",
+				engine->name, simd_level_name(cpu_simd_level()));
+			continue;
+		}
+		if(engine->square_only && len1 != len2){
+			fprintf(stderr, "Skipping %s for %zux%zu: only takes strings of equal length.\n",
+				engine->name, len1, len2);
+			continue;
+		}
+
+		double cells = (double)input->num_pairs * len1 * len2;
+		int check = (config->check == CHECK_ALWAYS) ||
+			(config->check == CHECK_AUTO && cells <= CHECK_AUTO_CELLS);
+		if(check && !engine->batch && !have_expected){
+			expected = naive_edit_distance_rect(str1, len1, str2, len2);
+			have_expected = 1;
+		}
+		if(check && engine->batch && !have_expected_pairs){
+			for(size_t p = 0; p < num_pairs; p++){
+				expected_pairs[p] = naive_edit_distance_rect(pairs[p].str1, len1, pairs[p].str2, len2);
+			}
+			have_expected_pairs = 1;
+		}
+
+		double base_median = -1;
+		int runs = engine->threaded ? config->num_threads : 1;
+		for(int t = 0; t < runs; t++){
+			long threads = engine->threaded ? config->threads[t] : 1;
+			BenchRow row;
+			row.engine = engine;
+			row.len1 = len1;
+			row.len2 = len2;
+			row.num_pairs = input->num_pairs;
+			row.threads = threads;
+			row.result = time_engine(config, engine, input, threads, times, &row);
+			row.perf = NULL;
+#ifdef EDIT_DISTANCE_PERF
+			if(config->perf){
+				/*
+				* Counted separately so opening the counters and reading
+				* them per tile stays out of the timings. Engines without
+				* workers are counted on this thread.
+				*/
+				perf_report_begin(report, config->perf_tiles);
+				if(engine->threaded){
+					engine->run(input, threads);
+				}
+				else{
+					PerfThread perf;
+					perf_thread_begin(&perf, 0);
+					engine->run(input, threads);
+					perf_thread_end(&perf);
+				}
+				perf_report_end();
+				row.perf = report;
+			}
+#endif
+			if(trace != NULL){
+				char name[128];
+				snprintf(name, sizeof(name), "%s %zux%zu threads=%ld", engine->name, len1, len2, threads);
+				if(trace_begin_run(trace, name) == 0){
+					engine->run(input, threads);
+					trace_end_run();
+				}
+			}
+			if(threads == 1){
+				base_median = row.median_ms;
+			}
+			row.efficiency = (base_median > 0) ? base_median / (threads * row.median_ms) : -1;
+
+			row.check = "skip";
+			if(check){
+				int ok = 1;
+				if(engine->batch){
+					ok = (row.result == 0);
+					for(size_t p = 0; ok && p < num_pairs; p++){
+						ok = (results[p] == expected_pairs[p]);
+					}
+				}
+				else{
+					ok = (row.result == expected);
+				}
+				row.check = ok ? "ok" : "FAIL";
+				failures += !ok;
+			}
+
+			print_row(config, &row, *first_row);
+			*first_row = 0;
+		}
+	}
+
+	ed_context_destroy(context);
+	free(str1); free(str2); free(pair_strings); free(pairs);
+	free(results); free(expected_pairs); free(times); free(report);
+	return failures;
+}
+
+/*
+* --tune: tunes every selected engine the tuner knows and saves the
+* winners to the tile cache.
+*/
+static int tune_engines(const BenchConfig *config){
+	const char *path = tile_config_path();
+	int failures = 0;
+	printf("%-12s %10s %12s %10s %12s %8s %10s\n", "engine", "default", "GCUPS", "tuned", "GCUPS",
+		"speedup", "shapes");
+	for(int e = 0; e < config->num_engines; e++){
+		const char *name = config->engines[e]->name;
+		int known = 0;
+		for(int t = 0; tile_tune_engine(t) != NULL; t++){
+			known |= (strcmp(tile_tune_engine(t), name) == 0);
+		}
+		if(!known){
+			fprintf(stderr, "%s has no tile shape to tune, skipped.\n", name);
+			continue;
+		}
+
+		TileTuneResult result;
+		if(tile_tune(name, TUNE_LENGTH, config->reps, &result) != 0){
+			fprintf(stderr, "Tuning %s failed (or the CPU cannot run it).\n", name);
+			failures++;
+			continue;
+		}
+		char default_shape[32], tuned_shape[32];
+		snprintf(default_shape, sizeof(default_shape), "%dx%d", result.default_size, result.default_size);
+		snprintf(tuned_shape, sizeof(tuned_shape), "%dx%d", result.tile_height, result.tile_width);
+		printf("%-12s %10s %12.3f %10s %12.3f %7.2fx %10d\n", name, default_shape, result.default_gcups,
+			tuned_shape, result.gcups, result.gcups / result.default_gcups, result.candidates);
+		if(tile_config_save(name, result.tile_height, result.tile_width) != 0){
+			fprintf(stderr, "Unable to save the shape of %s to %s.\n", name,
+				(path[0] != '\0') ? path : "(tile cache disabled)");
+			failures++;
+		}
+	}
+	if(path[0] != '\0'){
+		fprintf(stderr, "Tile shapes saved to %s.\n", path);
+	}
+	return failures ? 1 : 0;
+}
+
+/*
+* --checkpoint: for every length, wavefront engine and thread count, times
+* the barrier schedule without checkpoints and then with one every N waves
+* for each N of --checkpoint-every, and reports the slowdown.
+*/
+static int checkpoint_overhead(const BenchConfig *config){
+	double *times = malloc(config->reps * sizeof(double));
+	if(times == NULL){
+		return 1;
+	}
+	uint64_t state = config->seed;
+	printf("%-12s %10s %10s %7s %7s %10s %9s %11s\n", "engine", "len1", "len2", "threads", "every",
+		"median_ms", "overhead", "checkpoints");
+	for(int l = 0; l < config->num_lengths; l++){
+		size_t len1 = config->len1[l];
+		size_t len2 = config->len2[l];
+		char *str1 = malloc(len1 + 1);
+		char *str2 = malloc(len2 + 1);
+		if(str1 == NULL || str2 == NULL){
+			printf("Unable to allocate the input for %zux%zu.\n", len1, len2);
+			free(str1); free(str2); free(times);
+			return 1;
+		}
+		generate_pair(str1, len1, str2, len2, config->alphabet, config->mutation, &state);
+
+		WavefrontStats stats;
+		WavefrontOptions options = {WAVEFRONT_SCHEDULE_BARRIER, &stats, 0, 0, config->tile_height,
+			config->tile_width, config->affinity};
+		BenchInput input = {str1, len1, str2, len2, NULL, 1, NULL, &options, NULL,
+			stripped_cells(str1, len1, str2, len2)};
+		for(int e = 0; e < config->num_engines; e++){
+			// Every threaded single-pair engine but align and anchored runs on the wavefront
+			const BenchEngine *engine = config->engines[e];
+			if(!engine->threaded || engine->batch || engine->run == run_align || engine->run == run_anchored
+				|| cpu_simd_level() < engine->level || (engine->square_only && len1 != len2)){
+				continue;
+			}
+			for(int t = 0; t < config->num_threads; t++){
+				long threads = config->threads[t];
+				BenchRow row;
+				options.checkpoint_path = NULL;
+				options.checkpoint_every = 0;
+				time_engine(config, engine, &input, threads, times, &row);
+				double base = row.median_ms;
+				printf("%-12s %10zu %10zu %7ld %7s %10.3f %9s %11s\n", engine->name, len1, len2,
+					threads, "-", base, "-", "-");
+				for(int k = 0; k < config->num_checkpoint_every; k++){
+					options.checkpoint_path = config->checkpoint_path;
+					options.checkpoint_every = config->checkpoint_every[k];
+					time_engine(config, engine, &input, threads, times, &row);
+					printf("%-12s %10zu %10zu %7ld %7ld %10.3f %8.1f%% %11ld\n", engine->name, len1, len2,
+						threads, config->checkpoint_every[k], row.median_ms,
+						100 * (row.median_ms - base) / base, stats.checkpoints);
+					fflush(stdout);
+				}
+			}
+		}
+		free(str1);
+		free(str2);
+	}
+	free(times);
+	return 0;
+}
+
+int main(int argc, char **argv){
+	BenchConfig config;
+	if(parse_args(argc, argv, &config) != 0){
+		return 2;
+	}
+	if(config.tune){
+		return tune_engines(&config);
+	}
+	if(config.checkpoint_path != NULL){
+		return checkpoint_overhead(&config);
+	}
+
+	Trace *trace = NULL;
+	if(config.trace_path != NULL){
+		trace = trace_create(config.threads[config.num_threads - 1], config.trace_events);
+		if(trace == NULL){
+			return 1;
+		}
+	}
+
+	uint64_t state = config.seed;
+	int failures = 0;
+	int first_row = 1;
+	print_header(&config);
+	for(int l = 0; l < config.num_lengths; l++){
+		int res = bench_length(&config, config.len1[l], config.len2[l], &state, trace, &first_row);
+		if(res < 0){
+			print_footer(config.format);
+			trace_destroy(trace);
+			return 1;
+		}
+		failures += res;
+	}
+	print_footer(config.format);
+
+	if(trace != NULL){
+		int status = trace_write_chrome(trace, config.trace_path);
+		trace_destroy(trace);
+		if(status != 0){
+			fprintf(stderr, "Unable to write the trace to %s.\n", config.trace_path);
+			return 1;
+		}
+		fprintf(stderr, "Trace written to %s.\n", config.trace_path);
+	}
+
+	if(failures){
+		fprintf(stderr, "%d run(s) did not match naive_edit_distance()!\n", failures);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,156 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include "src/bitparallel_edit_distance.h"
+#include "src/wavefront.h"
+#include "src/tile_config.h"
+#include "src/myers.h"
+
+/*
+* n size for each individual block while tiling. A tile covers
+* BLOCK_SIZE / 64 words of str1 and BLOCK_SIZE characters of str2.
+*/
+#define BLOCK_SIZE 1024
+/*
+* Largest tile side accepted at runtime (WavefrontOptions, tuned shapes);
+* sizes the per-thread scratch (match masks and deltas).
+*/
+#define MAX_TILE_SIZE 2048
+#define BLOCK_WORDS (MAX_TILE_SIZE / 64)
+
+/*
+* Inputs with fewer than PARALLEL_THRESHOLD^2 cells are run on a single
+* thread; below it the whole computation takes less time than waking up
+* the workers.
+*/
+#define PARALLEL_THRESHOLD 16384
+
+/*
+* Max number of threads used for long inputs (same limit as main.c).
+*/
+#define MAX_THREADS 16
+
+/*
+* Helper function to process a single tile AND update the global rows
+* and cols. The tile's rows are packed into bit-vectors, so every
+* character of str2 advances 64 cells per word operation.
+* scratch holds the match masks (256 x BLOCK_WORDS) followed by the
+* vertical delta vectors.
+*/
+static int process_tile(const int *top, const int *left, int *bottom,
+	int *right, int corner, int height, int width, const char *str1,
+	const char *str2, void *scratch){
+
+	uint64_t *peq = (uint64_t*)scratch;
+	uint64_t *pv = peq + 256 * BLOCK_WORDS;
+	uint64_t *mv = pv + BLOCK_WORDS;
+	int words = (height + 63) / 64;
+	int last_bit = (height - 1) % 64;
+
+	/*
+	* Match masks: bit i of peq[c * words + w] is set if
+	* str1[w * 64 + i] == c.
+	*/
+	memset(peq, 0, 256 * words * sizeof(uint64_t));
+	for(int i = 0; i < height; i++){
+		peq[(unsigned char)str1[i] * words + i / 64] |= 1ULL << (i % 64);
+	}
+
+	/*
+	* Vertical deltas from the left boundary column
+	*/
+	memset(pv, 0, words * sizeof(uint64_t));
+	memset(mv, 0, words * sizeof(uint64_t));
+	int prev = corner;
+	for(int i = 1; i <= height; i++){
+		int delta = left[i] - prev;
+		prev = left[i];
+		if(delta > 0){
+			pv[(i - 1) / 64] |= 1ULL << ((i - 1) % 64);
+		}
+		else if(delta < 0){
+			mv[(i - 1) / 64] |= 1ULL << ((i - 1) % 64);
+		}
+	}
+
+	/*
+	* Sweep the columns. The horizontal delta entering the top of the
+	* tile comes from the row above; the one leaving the bottom gives the
+	* tile's last row.
+	*/
+	int bottom_score = left[height];
+	int top_prev = corner;
+	for(int j = 1; j <= width; j++){
+		int hin = top[j] - top_prev;
+		top_prev = top[j];
+
+		const uint64_t *eq = &peq[(unsigned char)str2[j - 1] * words];
+		for(int w = 0; w < words - 1; w++){
+			hin = myers_advance_block(&pv[w], &mv[w], eq[w], hin, 63);
+		}
+		hin = myers_advance_block(&pv[words - 1], &mv[words - 1], eq[words - 1], hin, last_bit);
+
+		bottom_score += hin;
+		bottom[j] = bottom_score;
+	}
+
+	/*
+	* Rebuild the last column from its vertical deltas. top_prev now holds
+	* the cell above it (read before bottom overwrote anything).
+	*/
+	int value = top_prev;
+	for(int i = 1; i <= height; i++){
+		uint64_t bit = 1ULL << ((i - 1) % 64);
+		value += ((pv[(i - 1) / 64] & bit) != 0) - ((mv[(i - 1) / 64] & bit) != 0);
+		right[i] = value;
+	}
+
+	return bottom_score;
+}
+
+/*
+* Number of threads to use for a len1 x len2 matrix.
+*/
+static long choose_num_threads(size_t len1, size_t len2){
+	long num_threads = 1;
+	if((double)len1 * len2 >= (double)PARALLEL_THRESHOLD * PARALLEL_THRESHOLD){
+		long num_processors = sysconf(_SC_NPROCESSORS_ONLN);
+		if(num_processors > MAX_THREADS){
+			num_threads = MAX_THREADS;
+		}
+		else if(num_processors > 1){
+			num_threads = num_processors;
+		}
+	}
+	return num_threads;
+}
+
+long bitparallel_edit_distance_threads(const char *str1, size_t len1, const char *str2, size_t len2,
+	long num_threads, const WavefrontOptions *options){
+	size_t scratch_size = (256 + 2) * BLOCK_WORDS * sizeof(uint64_t);
+	WavefrontOptions tuned;
+	options = tile_config_options("bitparallel", options, BLOCK_SIZE, &tuned);
+	return wavefront_edit_distance_rect(str1, len1, str2, len2, num_threads,
+		MAX_TILE_SIZE, process_tile, scratch_size, options);
+}
+
+long bitparallel_edit_distance_rect(const char *str1, size_t len1, const char *str2, size_t len2,
+	const WavefrontOptions *options){
+	return bitparallel_edit_distance_threads(str1, len1, str2, len2, choose_num_threads(len1, len2), options);
+}
+
+long bitparallel_edit_distance(const char *str1, const char *str2, size_t len){
+	return bitparallel_edit_distance_rect(str1, len, str2, len, NULL);
+}
+
+int bitparallel_edit_distance_bounded(const char *str1, const char *str2, size_t len, int k){
+	/*
+	* Bounded mode keeps every boundary value capped at k + 1, so the
+	* deltas the kernel derives from them stay in {-1, 0, 1}.
+	*/
+	WavefrontOptions options = {WAVEFRONT_SCHEDULE_DATAFLOW, NULL, 1, k};
+	return bitparallel_edit_distance_rect(str1, len, str2, len, &options);
+}
@@ -0,0 +1,583 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "src/bk_tree.h"
+#include "src/myers.h"
+
+#define BK_TREE_MAGIC "BKTREE1\n"
+
+/*
+* Written natively; reads back as this value only with the same byte order.
+*/
+#define BK_TREE_BYTE_ORDER 0x0102030405060708ULL
+
+/*
+* Image layout: the header, num_nodes nodes, the node of every word
+* (num_nodes uint32_t) and the words' text. Nodes and text are stored in
+* breadth-first order, so the children a search steps into next, and
+* their words, sit next to each other.
+*/
+typedef struct {
+	char magic[8];
+	uint64_t byte_order;
+	uint64_t num_nodes;
+	uint64_t text_bytes;
+} BkHeader;
+
+/*
+* A node's children are nodes[first_child, first_child + num_children),
+* sorted by their distance to it. word is the node's index in the word
+* list.
+*/
+typedef struct {
+	uint64_t text_offset;
+	uint32_t length;
+	uint32_t word;
+	uint32_t distance;
+	uint32_t first_child;
+	uint32_t num_children;
+	uint32_t padding;
+} BkNode;
+
+struct BkTree {
+	const BkHeader *header;
+	const BkNode *nodes;
+	const uint32_t *positions;
+	const char *text;
+	void *image;
+	size_t image_size;
+	int mapped;	// image is a mapping of the file, not malloc()ed
+};
+
+/*
+* One string preprocessed for the bit-parallel kernel: its match masks,
+* one 64-bit word per 64 characters, and the vertical deltas of the
+* column being advanced.
+*/
+typedef struct {
+	size_t length;
+	size_t words;
+	int last_bit;
+	uint64_t *peq;
+	uint64_t *pv;
+	uint64_t *mv;
+} MyersPattern;
+
+static int pattern_reserve(MyersPattern *pattern, size_t max_length){
+	size_t words = (max_length + 63) / 64;
+	if(words == 0){
+		words = 1;
+	}
+	pattern->peq = malloc((256 + 2) * words * sizeof(uint64_t));
+	if(pattern->peq == NULL){
+		return -1;
+	}
+	pattern->pv = pattern->peq + 256 * words;
+	pattern->mv = pattern->pv + words;
+	return 0;
+}
+
+static void pattern_set(MyersPattern *pattern, const char *str, size_t len){
+	pattern->length = len;
+	pattern->words = (len + 63) / 64;
+	pattern->last_bit = (len == 0) ? 0 : (int)((len - 1) % 64);
+	memset(pattern->peq, 0, 256 * pattern->words * sizeof(uint64_t));
+	for(size_t i = 0; i < len; i++){
+		pattern->peq[(unsigned char)str[i] * pattern->words + i / 64] |= 1ULL << (i % 64);
+	}
+}
+
+/*
+* Edit distance between the pattern and text, or limit + 1 as soon as it
+* is known to exceed limit: the last row can drop by at most one per
+* remaining text character, so once it is further above limit than that,
+* the pair is out.
+*/
+static long pattern_distance(MyersPattern *pattern, const char *text, size_t n, long limit){
+	size_t m = pattern->length;
+	size_t length_difference = (m > n) ? (m - n) : (n - m);
+	if(length_difference > (size_t)limit){
+		return limit + 1;
+	}
+	if(m == 0){
+		return (long)n;
+	}
+
+	size_t words = pattern->words;
+	uint64_t *pv = pattern->pv;
+	uint64_t *mv = pattern->mv;
+	for(size_t w = 0; w < words; w++){
+		pv[w] = ~0ULL;
+		mv[w] = 0;
+	}
+	long score = m;
+	for(size_t j = 0; j < n; j++){
+		const uint64_t *eq = &pattern->peq[(unsigned char)text[j] * words];
+		int hin = 1;
+		for(size_t w = 0; w + 1 < words; w++){
+			hin = myers_advance_block(&pv[w], &mv[w], eq[w], hin, 63);
+		}
+		hin = myers_advance_block(&pv[words - 1], &mv[words - 1], eq[words - 1], hin, pattern->last_bit);
+		score += hin;
+		if(score - (long)(n - 1 - j) > limit){
+			return limit + 1;
+		}
+	}
+	return score;
+}
+
+static int match_before(const BkMatch *a, const BkMatch *b){
+	return (a->distance != b->distance) ? (a->distance < b->distance) : (a->index < b->index);
+}
+
+static int compare_matches(const void *a, const void *b){
+	const BkMatch *x = a;
+	const BkMatch *y = b;
+	return match_before(x, y) ? -1 : (match_before(y, x) ? 1 : 0);
+}
+
+static size_t image_size(uint64_t num_nodes, uint64_t text_bytes){
+	return sizeof(BkHeader) + num_nodes * (sizeof(BkNode) + sizeof(uint32_t)) + text_bytes;
+}
+
+/*
+* Points the tree's sections into its image.
+*/
+static void attach_image(BkTree *tree, void *image, size_t size, int mapped){
+	tree->image = image;
+	tree->image_size = size;
+	tree->mapped = mapped;
+	tree->header = image;
+	tree->nodes = (const BkNode*)(tree->header + 1);
+	tree->positions = (const uint32_t*)(tree->nodes + tree->header->num_nodes);
+	tree->text = (const char*)(tree->positions + tree->header->num_nodes);
+}
+
+/*
+* Checks that every offset in the node and position sections stays
+* inside the image, so a corrupt file cannot send a search out of bounds.
+* Children must come after their parent, as bk_tree_build() lays them
+* out, which also rules out cycles. Returns 0 if the image is sound.
+*/
+static int check_image(const BkHeader *header){
+	const BkNode *nodes = (const BkNode*)(header + 1);
+	const uint32_t *positions = (const uint32_t*)(nodes + header->num_nodes);
+	uint64_t num_nodes = header->num_nodes;
+	for(uint64_t i = 0; i < num_nodes; i++){
+		const BkNode *node = &nodes[i];
+		if(node->length > INT_MAX || node->length > header->text_bytes
+			|| node->text_offset > header->text_bytes - node->length
+			|| node->word >= num_nodes || positions[i] >= num_nodes){
+			return -1;
+		}
+		if(node->num_children > 0 && (node->first_child <= i
+			|| (uint64_t)node->first_child + node->num_children > num_nodes)){
+			return -1;
+		}
+	}
+	return 0;
+}
+
+BkTree *bk_tree_build(const char *const *words, const size_t *lengths, size_t n){
+	if(n > UINT32_MAX){
+		printf("Too many words for bk_tree_build().");
+		return NULL;
+	}
+	size_t text_bytes = 0;
+	size_t max_length = 0;
+	for(size_t i = 0; i < n; i++){
+		size_t length = (lengths != NULL) ? lengths[i] : strlen(words[i]);
+		if(length > INT_MAX){
+			printf("Word %zu is too long for bk_tree_build().", i);
+			return NULL;
+		}
+		text_bytes += length;
+		max_length = (length > max_length) ? length : max_length;
+	}
+
+	/*
+	* The tree is first grown as linked child lists over the word list,
+	* then laid out breadth first into the image.
+	*/
+	BkTree *tree = malloc(sizeof(BkTree));
+	uint32_t *first_child = malloc((n + 1) * sizeof(uint32_t));
+	uint32_t *next_sibling = malloc((n + 1) * sizeof(uint32_t));
+	uint32_t *parent_distance = malloc((n + 1) * sizeof(uint32_t));
+	size_t size = image_size(n, text_bytes);
+	char *image = calloc(1, size);
+	MyersPattern pattern = {0};
+	if(tree == NULL || first_child == NULL || next_sibling == NULL || parent_distance == NULL
+		|| image == NULL || pattern_reserve(&pattern, max_length) != 0){
+		printf("Failed to allocate memory in bk_tree_build().");
+		free(tree);
+		free(first_child);
+		free(next_sibling);
+		free(parent_distance);
+		free(image);
+		free(pattern.peq);
+		return NULL;
+	}
+
+	for(size_t i = 0; i < n; i++){
+		first_child[i] = UINT32_MAX;
+	}
+	for(size_t i = 1; i < n; i++){
+		size_t length = (lengths != NULL) ? lengths[i] : strlen(words[i]);
+		pattern_set(&pattern, words[i], length);
+		uint32_t node = 0;
+		for(;;){
+			size_t node_length = (lengths != NULL) ? lengths[node] : strlen(words[node]);
+			uint32_t distance = (uint32_t)pattern_distance(&pattern, words[node], node_length, LONG_MAX - 1);
+			uint32_t child = first_child[node];
+			while(child != UINT32_MAX && parent_distance[child] != distance){
+				child = next_sibling[child];
+			}
+			if(child == UINT32_MAX){
+				parent_distance[i] = distance;
+				next_sibling[i] = first_child[node];
+				first_child[node] = (uint32_t)i;
+				break;
+			}
+			node = child;
+		}
+	}
+
+	BkHeader *header = (BkHeader*)image;
+	memcpy(header->magic, BK_TREE_MAGIC, sizeof(header->magic));
+	header->byte_order = BK_TREE_BYTE_ORDER;
+	header->num_nodes = n;
+	header->text_bytes = text_bytes;
+	attach_image(tree, image, size, 0);
+	BkNode *nodes = (BkNode*)tree->nodes;
+	uint32_t *positions = (uint32_t*)tree->positions;
+	char *text = (char*)tree->text;
+
+	/*
+	* Breadth first: the image's nodes double as the queue. Each node's
+	* children are appended in one block, sorted by distance (insertion
+	* sort, a node has few children).
+	*/
+	size_t tail = (n > 0) ? 1 : 0;
+	size_t offset = 0;
+	if(n > 0){
+		nodes[0].word = 0;
+	}
+	for(size_t p = 0; p < n; p++){
+		BkNode *node = &nodes[p];
+		uint32_t word = node->word;
+		size_t length = (lengths != NULL) ? lengths[word] : strlen(words[word]);
+		memcpy(text + offset, words[word], length);
+		node->text_offset = offset;
+		node->length = (uint32_t)length;
+		offset += length;
+		positions[word] = (uint32_t)p;
+
+		node->first_child = (uint32_t)tail;
+		for(uint32_t child = first_child[word]; child != UINT32_MAX; child = next_sibling[child]){
+			size_t k = tail + node->num_children++;
+			while(k > node->first_child && nodes[k - 1].distance > parent_distance[child]){
+				nodes[k] = nodes[k - 1];
+				k--;
+			}
+			nodes[k].word = child;
+			nodes[k].distance = parent_distance[child];
+		}
+		tail += node->num_children;
+	}
+
+	free(first_child);
+	free(next_sibling);
+	free(parent_distance);
+	free(pattern.peq);
+	return tree;
+}
+
+int bk_tree_save(const BkTree *tree, const char *path){
+	FILE *file = fopen(path, "wb");
+	if(file == NULL){
+		printf("Unable to open %s.\n", path);
+		return -1;
+	}
+	int status = (fwrite(tree->image, 1, tree->image_size, file) == tree->image_size) ? 0 : -1;
+	if(fclose(file) != 0){
+		status = -1;
+	}
+	if(status != 0){
+		printf("Unable to write %s.\n", path);
+	}
+	return status;
+}
+
+BkTree *bk_tree_load(const char *path){
+	int fd = open(path, O_RDONLY);
+	struct stat info;
+	if(fd < 0 || fstat(fd, &info) != 0){
+		printf("Unable to open %s.\n", path);
+		if(fd >= 0){
+			close(fd);
+		}
+		return NULL;
+	}
+	size_t size = info.st_size;
+	void *mapping = (size >= sizeof(BkHeader))
+	? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+	close(fd);
+
+	/*
+	* The header and the size are checked first, then every node once; the
+	* sections are then used in place.
+	*/
+	const BkHeader *header = mapping;
+	if(mapping == MAP_FAILED || memcmp(header->magic, BK_TREE_MAGIC, sizeof(header->magic)) != 0
+		|| header->byte_order != BK_TREE_BYTE_ORDER || header->num_nodes > UINT32_MAX
+		|| header->text_bytes > size || image_size(header->num_nodes, header->text_bytes) != size
+		|| check_image(header) != 0){
+		printf("%s is not a valid BK-tree file.\n", path);
+		if(mapping != MAP_FAILED){
+			munmap(mapping, size);
+		}
+		return NULL;
+	}
+
+	BkTree *tree = malloc(sizeof(BkTree));
+	if(tree == NULL){
+		printf("Failed to allocate memory in bk_tree_load().");
+		munmap(mapping, size);
+		return NULL;
+	}
+	attach_image(tree, mapping, size, 1);
+	return tree;
+}
+
+void bk_tree_free(BkTree *tree){
+	if(tree == NULL){
+		return;
+	}
+	if(tree->mapped){
+		munmap(tree->image, tree->image_size);
+	}
+	else{
+		free(tree->image);
+	}
+	free(tree);
+}
+
+size_t bk_tree_size(const BkTree *tree){
+	return tree->header->num_nodes;
+}
+
+const char *bk_tree_word(const BkTree *tree, size_t index, size_t *length){
+	const BkNode *node = &tree->nodes[tree->positions[index]];
+	*length = node->length;
+	return tree->text + node->text_offset;
+}
+
+/*
+* Pending node of a search and the lower bound on its distance to the
+* query that the triangle inequality gave when it was pushed.
+*/
+typedef struct {
+	uint32_t node;
+	long lower;
+} BkVisit;
+
+typedef struct {
+	BkVisit *visits;
+	size_t count;
+	size_t capacity;
+} BkStack;
+
+static int stack_push(BkStack *stack, uint32_t node, long lower){
+	if(stack->count == stack->capacity){
+		size_t capacity = (stack->capacity == 0) ? 256 : 2 * stack->capacity;
+		BkVisit *visits = realloc(stack->visits, capacity * sizeof(BkVisit));
+		if(visits == NULL){
+			return -1;
+		}
+		stack->visits = visits;
+		stack->capacity = capacity;
+	}
+	stack->visits[stack->count++] = (BkVisit){node, lower};
+	return 0;
+}
+
+/*
+* Pushes the children of node whose edge is within bound of distance, the
+* furthest first, so the closest is searched next.
+*/
+static int push_children(const BkTree *tree, BkStack *stack, uint32_t node, long distance, long bound){
+	const BkNode *children = &tree->nodes[tree->nodes[node].first_child];
+	long lo = 0;
+	long hi = (long)tree->nodes[node].num_children - 1;
+	while(lo <= hi && children[lo].distance < distance - bound){
+		lo++;
+	}
+	while(hi >= lo && children[hi].distance > distance + bound){
+		hi--;
+	}
+	while(lo <= hi){
+		long low_gap = labs((long)children[lo].distance - distance);
+		long high_gap = labs((long)children[hi].distance - distance);
+		int take_low = (low_gap >= high_gap);
+		long child = take_low ? lo++ : hi--;
+		if(stack_push(stack, tree->nodes[node].first_child + child, take_low ? low_gap : high_gap) != 0){
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/*
+* Largest edge below node: past bound + that, neither node nor any child
+* can matter, so its distance never needs to be known exactly beyond it.
+*/
+static long max_edge(const BkTree *tree, uint32_t node){
+	const BkNode *entry = &tree->nodes[node];
+	return (entry->num_children == 0) ? 0 : tree->nodes[entry->first_child + entry->num_children - 1].distance;
+}
+
+long bk_tree_radius(const BkTree *tree, const char *query, size_t len, int radius,
+	BkMatch **matches){
+	*matches = NULL;
+	if(bk_tree_size(tree) == 0 || radius < 0){
+		return 0;
+	}
+
+	MyersPattern pattern = {0};
+	BkStack stack = {0};
+	BkMatch *found = NULL;
+	size_t count = 0;
+	size_t capacity = 0;
+	int status = pattern_reserve(&pattern, len);
+	if(status == 0){
+		pattern_set(&pattern, query, len);
+		status = stack_push(&stack, 0, 0);
+	}
+	while(status == 0 && stack.count > 0){
+		uint32_t node = stack.visits[--stack.count].node;
+		long limit = radius + max_edge(tree, node);
+		long distance = pattern_distance(&pattern, tree->text + tree->nodes[node].text_offset,
+			tree->nodes[node].length, limit);
+		if(distance > limit){
+			continue;
+		}
+		if(distance <= radius){
+			if(count == capacity){
+				capacity = (capacity == 0) ? 16 : 2 * capacity;
+				BkMatch *grown = realloc(found, capacity * sizeof(BkMatch));
+				if(grown == NULL){
+					status = -1;
+					break;
+				}
+				found = grown;
+			}
+			found[count++] = (BkMatch){tree->nodes[node].word, (int)distance};
+		}
+		status = push_children(tree, &stack, node, distance, radius);
+	}
+
+	free(pattern.peq);
+	free(stack.visits);
+	if(status != 0){
+		printf("Failed to allocate memory in bk_tree_radius().");
+		free(found);
+		return -1;
+	}
+	if(count > 0){
+		qsort(found, count, sizeof(BkMatch), compare_matches);
+	}
+	*matches = found;
+	return (long)count;
+}
+
+/*
+* Max-heap on (distance, index) holding the best matches so far.
+*/
+static void heap_sift_down(BkMatch *heap, size_t count, size_t i){
+	for(;;){
+		size_t largest = i;
+		size_t left = 2 * i + 1;
+		size_t right = left + 1;
+		if(left < count && match_before(&heap[largest], &heap[left])){
+			largest = left;
+		}
+		if(right < count && match_before(&heap[largest], &heap[right])){
+			largest = right;
+		}
+		if(largest == i){
+			return;
+		}
+		BkMatch temp = heap[i];
+		heap[i] = heap[largest];
+		heap[largest] = temp;
+		i = largest;
+	}
+}
+
+static void heap_push(BkMatch *heap, size_t count, BkMatch match){
+	size_t i = count;
+	heap[i] = match;
+	while(i > 0 && match_before(&heap[(i - 1) / 2], &heap[i])){
+		BkMatch temp = heap[i];
+		heap[i] = heap[(i - 1) / 2];
+		heap[(i - 1) / 2] = temp;
+		i = (i - 1) / 2;
+	}
+}
+
+long bk_tree_top_k(const BkTree *tree, const char *query, size_t len, size_t k,
+	BkMatch *matches){
+	if(bk_tree_size(tree) == 0 || k == 0){
+		return 0;
+	}
+
+	MyersPattern pattern = {0};
+	BkStack stack = {0};
+	size_t count = 0;
+	int status = pattern_reserve(&pattern, len);
+	if(status == 0){
+		pattern_set(&pattern, query, len);
+		status = stack_push(&stack, 0, 0);
+	}
+	while(status == 0 && stack.count > 0){
+		BkVisit visit = stack.visits[--stack.count];
+		int full = (count == k);
+		long bound = full ? matches[0].distance : LONG_MAX / 4;
+		if(visit.lower > bound){
+			continue;
+		}
+
+		long limit = bound + max_edge(tree, visit.node);
+		long distance = pattern_distance(&pattern, tree->text + tree->nodes[visit.node].text_offset,
+			tree->nodes[visit.node].length, limit);
+		if(distance > limit){
+			continue;
+		}
+		BkMatch match = {tree->nodes[visit.node].word, (int)distance};
+		if(!full){
+			heap_push(matches, count++, match);
+		}
+		else if(match_before(&match, &matches[0])){
+			matches[0] = match;
+			heap_sift_down(matches, count, 0);
+		}
+		bound = (count == k) ? matches[0].distance : LONG_MAX / 4;
+		status = push_children(tree, &stack, visit.node, distance, bound);
+	}
+
+	free(pattern.peq);
+	free(stack.visits);
+	if(status != 0){
+		printf("Failed to allocate memory in bk_tree_top_k().");
+		return -1;
+	}
+	qsort(matches, count, sizeof(BkMatch), compare_matches);
+	return (long)count;
+}
@@ -0,0 +1,238 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "src/checkpoint.h"
+
+#define CHECKPOINT_MAGIC "EDCKPT2\n"
+
+#define FINGERPRINT_MULTIPLIER 0x100000001b3ULL
+
+struct Checkpointer {
+	char *path;
+	char *temporary_path;
+	CheckpointHeader header;
+
+	/*
+	* The snapshot: rows, cols and corners back to back, as in the file.
+	*/
+	char *snapshot;
+	size_t row_bytes;
+	size_t col_bytes;
+	size_t corner_bytes;
+
+	pthread_t writer;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	int pending;	// a submitted snapshot has not been written yet
+	int stopping;
+	atomic_int busy;
+	long written;
+	int failed;
+};
+
+static int write_snapshot(Checkpointer *checkpointer){
+	FILE *file = fopen(checkpointer->temporary_path, "wb");
+	if(file == NULL){
+		return -1;
+	}
+	size_t data_bytes = checkpointer->row_bytes + checkpointer->col_bytes + checkpointer->corner_bytes;
+	int status = (fwrite(&checkpointer->header, sizeof(CheckpointHeader), 1, file) == 1
+		&& fwrite(checkpointer->snapshot, 1, data_bytes, file) == data_bytes) ? 0 : -1;
+	if(fflush(file) != 0 || fsync(fileno(file)) != 0){
+		status = -1;
+	}
+	if(fclose(file) != 0){
+		status = -1;
+	}
+	if(status == 0 && rename(checkpointer->temporary_path, checkpointer->path) != 0){
+		status = -1;
+	}
+	return status;
+}
+
+static void *writer_thread(void *arg){
+	Checkpointer *checkpointer = (Checkpointer*)arg;
+	pthread_mutex_lock(&checkpointer->lock);
+	for(;;){
+		while(!checkpointer->pending && !checkpointer->stopping){
+			pthread_cond_wait(&checkpointer->wake, &checkpointer->lock);
+		}
+		if(!checkpointer->pending){
+			break;
+		}
+		pthread_mutex_unlock(&checkpointer->lock);
+		int status = write_snapshot(checkpointer);
+		if(status != 0){
+			printf("Unable to write the checkpoint %s.\n", checkpointer->path);
+		}
+		pthread_mutex_lock(&checkpointer->lock);
+		checkpointer->pending = 0;
+		checkpointer->written += (status == 0);
+		checkpointer->failed |= (status != 0);
+		atomic_store(&checkpointer->busy, 0);
+	}
+	pthread_mutex_unlock(&checkpointer->lock);
+	return NULL;
+}
+
+uint64_t checkpoint_fingerprint(uint64_t hash, const char *data, size_t len){
+	/*
+	* FNV-1a, one character at a time, so the split into pieces does not
+	* matter. One pass over the strings is nothing next to the DP.
+	*/
+	for(size_t i = 0; i < len; i++){
+		hash = (hash ^ (unsigned char)data[i]) * FINGERPRINT_MULTIPLIER;
+	}
+	return hash;
+}
+
+int checkpoint_read_header(const char *path, CheckpointHeader *header){
+	FILE *file = fopen(path, "rb");
+	if(file == NULL){
+		if(errno == ENOENT){
+			return 0;
+		}
+		printf("Unable to open %s.\n", path);
+		return -1;
+	}
+	int valid = (fread(header, sizeof(CheckpointHeader), 1, file) == 1
+		&& memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic)) == 0);
+	fclose(file);
+	if(!valid){
+		printf("%s is not a valid checkpoint file.\n", path);
+		return -1;
+	}
+	return 1;
+}
+
+Checkpointer *checkpointer_create(const char *path, size_t len1, size_t len2, int tile_height,
+	int tile_width, size_t entry_size, uint64_t fingerprint){
+	Checkpointer *checkpointer = calloc(1, sizeof(Checkpointer));
+	if(checkpointer == NULL){
+		printf("Failed to allocate memory in checkpointer_create().");
+		return NULL;
+	}
+	size_t row_blocks = (len1 + tile_height - 1) / tile_height;
+	checkpointer->row_bytes = (len2 + 1) * entry_size;
+	checkpointer->col_bytes = (len1 + 1) * entry_size;
+	checkpointer->corner_bytes = row_blocks * entry_size;
+	checkpointer->snapshot = calloc(1, checkpointer->row_bytes + checkpointer->col_bytes
+		+ checkpointer->corner_bytes);
+	checkpointer->path = malloc(strlen(path) + 1);
+	checkpointer->temporary_path = malloc(strlen(path) + 5);
+	if(checkpointer->snapshot == NULL || checkpointer->path == NULL
+		|| checkpointer->temporary_path == NULL){
+		printf("Failed to allocate memory in checkpointer_create().");
+		free(checkpointer->snapshot);
+		free(checkpointer->path);
+		free(checkpointer->temporary_path);
+		free(checkpointer);
+		return NULL;
+	}
+	strcpy(checkpointer->path, path);
+	sprintf(checkpointer->temporary_path, "%s.tmp", path);
+
+	CheckpointHeader *header = &checkpointer->header;
+	memcpy(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic));
+	header->len1 = len1;
+	header->len2 = len2;
+	header->tile_height = tile_height;
+	header->tile_width = tile_width;
+	header->entry_size = entry_size;
+	header->fingerprint = fingerprint;
+
+	pthread_mutex_init(&checkpointer->lock, NULL);
+	pthread_cond_init(&checkpointer->wake, NULL);
+	atomic_init(&checkpointer->busy, 0);
+	if(pthread_create(&checkpointer->writer, NULL, writer_thread, checkpointer) != 0){
+		printf("Unable to start the checkpoint writer.");
+		pthread_mutex_destroy(&checkpointer->lock);
+		pthread_cond_destroy(&checkpointer->wake);
+		free(checkpointer->snapshot);
+		free(checkpointer->path);
+		free(checkpointer->temporary_path);
+		free(checkpointer);
+		return NULL;
+	}
+	return checkpointer;
+}
+
+char *checkpointer_rows(Checkpointer *checkpointer){
+	return checkpointer->snapshot;
+}
+
+char *checkpointer_cols(Checkpointer *checkpointer){
+	return checkpointer->snapshot + checkpointer->row_bytes;
+}
+
+char *checkpointer_corners(Checkpointer *checkpointer){
+	return checkpointer->snapshot + checkpointer->row_bytes + checkpointer->col_bytes;
+}
+
+int checkpointer_ready(Checkpointer *checkpointer){
+	return !atomic_load(&checkpointer->busy);
+}
+
+void checkpointer_submit(Checkpointer *checkpointer, long wave){
+	pthread_mutex_lock(&checkpointer->lock);
+	checkpointer->header.wave = wave;
+	checkpointer->pending = 1;
+	atomic_store(&checkpointer->busy, 1);
+	pthread_cond_signal(&checkpointer->wake);
+	pthread_mutex_unlock(&checkpointer->lock);
+}
+
+int checkpointer_load(Checkpointer *checkpointer, long *wave){
+	CheckpointHeader header;
+	int found = checkpoint_read_header(checkpointer->path, &header);
+	if(found <= 0){
+		return found;
+	}
+	const CheckpointHeader *expected = &checkpointer->header;
+	if(header.len1 != expected->len1 || header.len2 != expected->len2
+		|| header.tile_height != expected->tile_height || header.tile_width != expected->tile_width
+		|| header.entry_size != expected->entry_size || header.fingerprint != expected->fingerprint){
+		printf("The checkpoint %s belongs to a different run.\n", checkpointer->path);
+		return -1;
+	}
+
+	FILE *file = fopen(checkpointer->path, "rb");
+	size_t data_bytes = checkpointer->row_bytes + checkpointer->col_bytes + checkpointer->corner_bytes;
+	int status = (file != NULL && fseek(file, sizeof(CheckpointHeader), SEEK_SET) == 0
+		&& fread(checkpointer->snapshot, 1, data_bytes, file) == data_bytes) ? 1 : -1;
+	if(file != NULL){
+		fclose(file);
+	}
+	if(status < 0){
+		printf("Unable to read the checkpoint %s.\n", checkpointer->path);
+		return -1;
+	}
+	*wave = header.wave;
+	return 1;
+}
+
+long checkpointer_destroy(Checkpointer *checkpointer){
+	if(checkpointer == NULL){
+		return 0;
+	}
+	pthread_mutex_lock(&checkpointer->lock);
+	checkpointer->stopping = 1;
+	pthread_cond_signal(&checkpointer->wake);
+	pthread_mutex_unlock(&checkpointer->lock);
+	pthread_join(checkpointer->writer, NULL);
+
+	long written = checkpointer->failed ? -1 : checkpointer->written;
+	pthread_mutex_destroy(&checkpointer->lock);
+	pthread_cond_destroy(&checkpointer->wake);
+	free(checkpointer->snapshot);
+	free(checkpointer->path);
+	free(checkpointer->temporary_path);
+	free(checkpointer);
+	return written;
+}
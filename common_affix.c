@@ -0,0 +1,68 @@
+#include <stdint.h>
+#include <string.h>
+#include "src/common_affix.h"
+#include "src/avx2_affix.h"
+#include "src/cpu_features.h"
+
+static uint64_t load_word(const char *str){
+	uint64_t word;
+	memcpy(&word, str, sizeof(word));
+	return word;
+}
+
+size_t common_prefix_length(const char *str1, const char *str2, size_t len){
+	if(cpu_simd_level() >= SIMD_LEVEL_AVX2){
+		return avx2_common_prefix(str1, str2, len);
+	}
+	size_t i = 0;
+	for(; i + 8 <= len; i += 8){
+		uint64_t difference = load_word(&str1[i]) ^ load_word(&str2[i]);
+		if(difference != 0){
+			return i + __builtin_ctzll(difference) / 8;
+		}
+	}
+	while(i < len && str1[i] == str2[i]){
+		i++;
+	}
+	return i;
+}
+
+size_t common_suffix_length(const char *str1, const char *str2, size_t len){
+	if(cpu_simd_level() >= SIMD_LEVEL_AVX2){
+		return avx2_common_suffix(str1, str2, len);
+	}
+	size_t n = 0;
+	for(; n + 8 <= len; n += 8){
+		size_t i = len - n - 8;
+		uint64_t difference = load_word(&str1[i]) ^ load_word(&str2[i]);
+		if(difference != 0){
+			return n + __builtin_clzll(difference) / 8;
+		}
+	}
+	while(n < len && str1[len - n - 1] == str2[len - n - 1]){
+		n++;
+	}
+	return n;
+}
+
+void strip_common_affixes(const char **str1, size_t *len1, const char **str2, size_t *len2,
+	size_t *prefix, size_t *suffix){
+	size_t shorter = (*len1 < *len2) ? *len1 : *len2;
+	size_t head = 0;
+	size_t tail = 0;
+	if(shorter > 0){
+		head = common_prefix_length(*str1, *str2, shorter);
+		tail = common_suffix_length(*str1 + *len1 - (shorter - head),
+			*str2 + *len2 - (shorter - head), shorter - head);
+		*str1 += head;
+		*str2 += head;
+	}
+	*len1 -= head + tail;
+	*len2 -= head + tail;
+	if(prefix != NULL){
+		*prefix = head;
+	}
+	if(suffix != NULL){
+		*suffix = tail;
+	}
+}
@@ -0,0 +1,79 @@
+#include <pthread.h>
+#include "src/cpu_features.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+
+/*
+* XCR0 bits that must be enabled by the OS before the matching registers
+* can be used: SSE and AVX state, then the three AVX-512 states (opmask,
+* upper halves of zmm0-15, zmm16-31).
+*/
+#define XCR0_AVX_STATE 0x06
+#define XCR0_AVX512_STATE 0xe0
+
+/*
+* xgetbv is only encoded here (rather than through _xgetbv()) so this file
+* does not need to be compiled with -mxsave.
+*/
+static unsigned long long read_xcr0(void){
+	unsigned int eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((unsigned long long)edx << 32) | eax;
+}
+
+static SimdLevel detect_simd_level(void){
+	unsigned int eax, ebx, ecx, edx;
+	if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx)){
+		return SIMD_LEVEL_SCALAR;
+	}
+	if(!(ecx & bit_SSE4_1)){
+		return SIMD_LEVEL_SCALAR;
+	}
+	if(!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)){
+		return SIMD_LEVEL_SSE41;
+	}
+	unsigned long long xcr0 = read_xcr0();
+	if((xcr0 & XCR0_AVX_STATE) != XCR0_AVX_STATE){
+		return SIMD_LEVEL_SSE41;
+	}
+
+	if(!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) || !(ebx & bit_AVX2)){
+		return SIMD_LEVEL_SSE41;
+	}
+	if((ebx & bit_AVX512BW) && (ebx & bit_AVX512VL)
+		&& (xcr0 & XCR0_AVX512_STATE) == XCR0_AVX512_STATE){
+		return SIMD_LEVEL_AVX512;
+	}
+	return SIMD_LEVEL_AVX2;
+}
+#else
+static SimdLevel detect_simd_level(void){
+	return SIMD_LEVEL_SCALAR;
+}
+#endif
+
+static pthread_once_t detect_once = PTHREAD_ONCE_INIT;
+static SimdLevel detected_level;
+
+static void detect(void){
+	detected_level = detect_simd_level();
+}
+
+SimdLevel cpu_simd_level(void){
+	pthread_once(&detect_once, detect);
+	return detected_level;
+}
+
+const char *simd_level_name(SimdLevel level){
+	switch(level){
+		case SIMD_LEVEL_AVX512:
+			return "avx512";
+		case SIMD_LEVEL_AVX2:
+			return "avx2";
+		case SIMD_LEVEL_SSE41:
+			return "sse4.1";
+		default:
+			return "scalar";
+	}
+}
@@ -0,0 +1,167 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sched.h>
+#include <dirent.h>
+#include "src/cpu_topology.h"
+
+typedef struct {
+	int cpu;
+	int node;
+	int package;
+	int core;
+	int smt;	// 0 for the first thread of a core, then 1, 2, ...
+} CpuInfo;
+
+/*
+* Reads one integer from a sysfs file; fallback if it is missing.
+*/
+static int read_int(const char *file, int fallback){
+	FILE *f = fopen(file, "r");
+	if(f == NULL){
+		return fallback;
+	}
+	int value;
+	if(fscanf(f, "%d", &value) != 1){
+		value = fallback;
+	}
+	fclose(f);
+	return value;
+}
+
+/*
+* NUMA node of cpu: the nodeN link in its sysfs directory, 0 on kernels
+* without NUMA.
+*/
+static int read_node(int cpu){
+	char dir_name[64];
+	snprintf(dir_name, sizeof(dir_name), "/sys/devices/system/cpu/cpu%d", cpu);
+	DIR *dir = opendir(dir_name);
+	if(dir == NULL){
+		return 0;
+	}
+	int node = 0;
+	struct dirent *entry;
+	while((entry = readdir(dir)) != NULL){
+		if(strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9'){
+			node = atoi(entry->d_name + 4);
+			break;
+		}
+	}
+	closedir(dir);
+	return node;
+}
+
+/*
+* Placement order: physical cores before SMT siblings, then by node, then
+* by CPU number.
+*/
+static int compare_placement(const void *a, const void *b){
+	const CpuInfo *x = (const CpuInfo*)a;
+	const CpuInfo *y = (const CpuInfo*)b;
+	if(x->smt != y->smt){
+		return x->smt - y->smt;
+	}
+	if(x->node != y->node){
+		return x->node - y->node;
+	}
+	return x->cpu - y->cpu;
+}
+
+/*
+* Worker order: by node, keeping the placement order within a node.
+*/
+static int compare_workers(const void *a, const void *b){
+	const CpuInfo *x = (const CpuInfo*)a;
+	const CpuInfo *y = (const CpuInfo*)b;
+	if(x->node != y->node){
+		return x->node - y->node;
+	}
+	return compare_placement(a, b);
+}
+
+int cpu_topology_place(long num_threads, int *cpus, int *nodes){
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	if(num_threads < 1 || sched_getaffinity(0, sizeof(allowed), &allowed) != 0){
+		return -1;
+	}
+
+	CpuInfo *info = malloc(CPU_SETSIZE * sizeof(CpuInfo));
+	CpuInfo *chosen = malloc(num_threads * sizeof(CpuInfo));
+	if(info == NULL || chosen == NULL){
+		printf("Failed to allocate memory for the CPU topology.");
+		free(info);
+		free(chosen);
+		return -1;
+	}
+
+	int count = 0;
+	for(int cpu = 0; cpu < CPU_SETSIZE && cpu < TOPOLOGY_MAX_CPUS; cpu++){
+		if(!CPU_ISSET(cpu, &allowed)){
+			continue;
+		}
+		char file[128];
+		info[count].cpu = cpu;
+		info[count].node = read_node(cpu);
+		snprintf(file, sizeof(file), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+		info[count].package = read_int(file, 0);
+		snprintf(file, sizeof(file), "/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+		info[count].core = read_int(file, cpu);
+
+		/*
+		* CPUs come in increasing order, so the siblings already seen
+		* are the lower numbered threads of the same core.
+		*/
+		info[count].smt = 0;
+		for(int other = 0; other < count; other++){
+			if(info[other].package == info[count].package && info[other].core == info[count].core){
+				info[count].smt++;
+			}
+		}
+		count++;
+	}
+	if(count == 0){
+		free(info);
+		free(chosen);
+		return -1;
+	}
+
+	qsort(info, count, sizeof(CpuInfo), compare_placement);
+	for(long t = 0; t < num_threads; t++){
+		chosen[t] = info[t % count];
+	}
+	qsort(chosen, num_threads, sizeof(CpuInfo), compare_workers);
+
+	int num_nodes = 0;
+	for(long t = 0; t < num_threads; t++){
+		cpus[t] = chosen[t].cpu;
+		nodes[t] = chosen[t].node;
+		if(t == 0 || chosen[t].node != chosen[t - 1].node){
+			num_nodes++;
+		}
+	}
+	free(info);
+	free(chosen);
+	return num_nodes;
+}
+
+int cpu_pin_current(int cpu){
+	if(cpu < 0 || cpu >= CPU_SETSIZE){
+		return -1;
+	}
+	cpu_set_t mask;
+	CPU_ZERO(&mask);
+	CPU_SET(cpu, &mask);
+	return (sched_setaffinity(0, sizeof(mask), &mask) == 0) ? 0 : -1;
+}
+
+int cpu_mask_get(CpuMask *mask){
+	memset(mask, 0, sizeof(CpuMask));
+	return (sched_getaffinity(0, sizeof(mask->bits), (cpu_set_t*)mask->bits) == 0) ? 0 : -1;
+}
+
+int cpu_mask_set(const CpuMask *mask){
+	return (sched_setaffinity(0, sizeof(mask->bits), (const cpu_set_t*)mask->bits) == 0) ? 0 : -1;
+}
@@ -0,0 +1,251 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "src/ed_context.h"
+#include "src/cpu_topology.h"
+
+/*
+* Alignment of every arena block (one cache line, and enough for aligned
+* AVX-512 loads).
+*/
+#define ARENA_ALIGNMENT 64
+#define HUGE_PAGE_SIZE (2UL * 1024 * 1024)
+
+/*
+* Tile side assumed when sizing the tile bookkeeping up front; smaller
+* tiles just grow the arena once.
+*/
+#define SIZING_TILE 256
+
+/*
+* Memory a call needed beyond the arena, kept until the next reset.
+*/
+typedef struct Overflow {
+	struct Overflow *next;
+	size_t size;
+} Overflow;
+
+typedef struct {
+	WorkerPool *pool;
+	int *cpus;
+	int *nodes;
+	int placed;	// 1: cpus/nodes valid, -1: topology unavailable
+} ContextPool;
+
+struct EdContext {
+	int flags;
+	long max_threads;
+
+	char *base;
+	size_t capacity;
+	size_t mapped;		// bytes actually mapped (rounded for huge pages)
+	size_t used;
+	size_t high_water;	// bytes the current call asked for so far
+	Overflow *overflow;
+
+	ContextPool *pools;	// indexed by thread count
+	size_t allocations;
+};
+
+/*
+* Maps size bytes, huge page backed if asked for. *mapped receives the
+* size to unmap.
+*/
+static void *map_region(size_t size, int flags, size_t *mapped){
+	void *region = MAP_FAILED;
+	if(flags & ED_CONTEXT_HUGE_PAGES){
+		size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+#ifdef MAP_HUGETLB
+		region = mmap(NULL, size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+	}
+	if(region == MAP_FAILED){
+		region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+		if(region != MAP_FAILED && (flags & ED_CONTEXT_HUGE_PAGES)){
+			madvise(region, size, MADV_HUGEPAGE);
+		}
+#endif
+	}
+	if(region == MAP_FAILED){
+		return NULL;
+	}
+	*mapped = size;
+	return region;
+}
+
+static size_t align_up(size_t bytes){
+	return (bytes + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+}
+
+/*
+* Replaces the arena with one of capacity bytes. Returns -1 on failure
+* (the context then has no arena, and every block overflows).
+*/
+static int map_arena(EdContext *context, size_t capacity){
+	if(context->base != NULL){
+		munmap(context->base, context->mapped);
+	}
+	context->base = map_region(capacity, context->flags, &context->mapped);
+	context->capacity = (context->base != NULL) ? context->mapped : 0;
+	context->allocations++;
+	return (context->base != NULL) ? 0 : -1;
+}
+
+EdContext *ed_context_create(size_t max_len, long num_threads, int flags){
+	if(num_threads < 1){
+		num_threads = 1;
+	}
+	EdContext *context = calloc(1, sizeof(EdContext));
+	ContextPool *pools = (context != NULL) ? calloc(num_threads + 1, sizeof(ContextPool)) : NULL;
+	if(context == NULL || pools == NULL){
+		printf("Failed to allocate memory for the context in ed_context_create().");
+		free(context);
+		free(pools);
+		return NULL;
+	}
+	context->flags = flags;
+	context->max_threads = num_threads;
+	context->pools = pools;
+
+	/*
+	* Four boundary arrays (three row buffers and the column), two rows
+	* for the tiled engine, and the tile bookkeeping of the wavefront at
+	* SIZING_TILE x SIZING_TILE tiles.
+	*/
+	size_t tiles = max_len / SIZING_TILE + 1;
+	size_t capacity = 6 * align_up((max_len + 1) * sizeof(int))
+		+ tiles * tiles * sizeof(int)
+		+ (num_threads + 4) * tiles * sizeof(int)
+		+ num_threads * 256 + 64 * ARENA_ALIGNMENT;
+	if(map_arena(context, capacity) != 0){
+		printf("Failed to allocate the arena in ed_context_create().");
+		ed_context_destroy(context);
+		return NULL;
+	}
+	return context;
+}
+
+static void free_overflow(EdContext *context){
+	while(context->overflow != NULL){
+		Overflow *next = context->overflow->next;
+		free(context->overflow);
+		context->overflow = next;
+	}
+}
+
+void ed_context_destroy(EdContext *context){
+	if(context == NULL){
+		return;
+	}
+	free_overflow(context);
+	if(context->base != NULL){
+		munmap(context->base, context->mapped);
+	}
+	for(long t = 0; t <= context->max_threads; t++){
+		worker_pool_destroy(context->pools[t].pool);
+		free(context->pools[t].cpus);
+		free(context->pools[t].nodes);
+	}
+	free(context->pools);
+	free(context);
+}
+
+size_t ed_context_allocations(const EdContext *context){
+	return context->allocations;
+}
+
+void ed_context_reset(EdContext *context){
+	/*
+	* The last call did not fit: grow the arena to everything it asked
+	* for, so the next call of that size fits in one piece.
+	*/
+	if(context->overflow != NULL){
+		free_overflow(context);
+		map_arena(context, context->high_water + context->high_water / 4);
+	}
+	context->used = 0;
+	context->high_water = 0;
+}
+
+void *ed_context_alloc(EdContext *context, size_t bytes){
+	bytes = align_up(bytes);
+	context->high_water += bytes;
+	if(context->used + bytes <= context->capacity){
+		void *block = context->base + context->used;
+		context->used += bytes;
+		return block;
+	}
+
+	Overflow *overflow;
+	if(posix_memalign((void**)&overflow, ARENA_ALIGNMENT, ARENA_ALIGNMENT + bytes) != 0){
+		return NULL;
+	}
+	overflow->next = context->overflow;
+	overflow->size = bytes;
+	context->overflow = overflow;
+	context->allocations++;
+	return (char*)overflow + ARENA_ALIGNMENT;
+}
+
+void *ed_context_alloc_or_malloc(EdContext *context, size_t bytes){
+	return (context != NULL) ? ed_context_alloc(context, bytes) : malloc(bytes);
+}
+
+void *ed_context_alloc_zeroed_or_calloc(EdContext *context, size_t count, size_t size){
+	if(context == NULL){
+		return calloc(count, size);
+	}
+	void *block = ed_context_alloc(context, count * size);
+	if(block != NULL){
+		memset(block, 0, count * size);
+	}
+	return block;
+}
+
+void ed_context_free_if_heap(EdContext *context, void *block){
+	if(context == NULL){
+		free(block);
+	}
+}
+
+WorkerPool *ed_context_pool(EdContext *context, long num_threads){
+	if(num_threads < 1){
+		num_threads = 1;
+	}
+	if(num_threads > context->max_threads){
+		num_threads = context->max_threads;
+	}
+	ContextPool *slot = &context->pools[num_threads];
+	if(slot->pool == NULL){
+		slot->pool = worker_pool_create(num_threads);
+		context->allocations++;
+	}
+	return slot->pool;
+}
+
+int ed_context_placement(EdContext *context, long num_threads, const int **cpus, const int **nodes){
+	if(num_threads < 1){
+		num_threads = 1;
+	}
+	if(num_threads > context->max_threads){
+		num_threads = context->max_threads;
+	}
+	ContextPool *slot = &context->pools[num_threads];
+	if(slot->placed == 0){
+		slot->cpus = malloc(num_threads * sizeof(int));
+		slot->nodes = malloc(num_threads * sizeof(int));
+		context->allocations++;
+		slot->placed = (slot->cpus != NULL && slot->nodes != NULL
+			&& cpu_topology_place(num_threads, slot->cpus, slot->nodes) >= 0) ? 1 : -1;
+	}
+	if(slot->placed < 0){
+		return -1;
+	}
+	*cpus = slot->cpus;
+	*nodes = slot->nodes;
+	return 0;
+}
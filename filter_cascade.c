@@ -0,0 +1,242 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "src/filter_cascade.h"
+#include "src/naive_edit_distance.h"
+#include "src/simd_edit_distance.h"
+#include "src/boundary.h"
+
+/*
+* The q-gram table has at least 2^MIN_QGRAM_BITS buckets, about two per
+* q-gram of str1; up to 2^STACK_QGRAM_BITS it lives on the stack, beyond
+* that on the heap. Pairs that would need more than 2^MAX_QGRAM_BITS
+* buckets (64 MB) skip the q-gram stage.
+*/
+#define MIN_QGRAM_BITS 6
+#define STACK_QGRAM_BITS 12
+#define MAX_QGRAM_BITS 24
+
+/*
+* Pairs of at least HISTOGRAM_SPLIT_CHARS characters are counted into
+* HISTOGRAM_SPLIT interleaved sub-histograms; shorter ones into one, which
+* is cheaper to clear.
+*/
+#define HISTOGRAM_SPLIT 4
+#define HISTOGRAM_SPLIT_CHARS 1024
+
+/*
+* Adds (sign 1) or subtracts (sign -1) the characters of str to the
+* sub-histograms, four characters at a time into four different ones, so
+* runs of the same character do not wait on each other's counter.
+*/
+static void count_characters(int64_t *counts, int num_histograms, const char *str, size_t len,
+	int64_t sign){
+	const unsigned char *chars = (const unsigned char*)str;
+	size_t i = 0;
+	if(num_histograms == HISTOGRAM_SPLIT){
+		for(; i + HISTOGRAM_SPLIT <= len; i += HISTOGRAM_SPLIT){
+			counts[chars[i]] += sign;
+			counts[256 + chars[i + 1]] += sign;
+			counts[512 + chars[i + 2]] += sign;
+			counts[768 + chars[i + 3]] += sign;
+		}
+	}
+	for(; i < len; i++){
+		counts[chars[i]] += sign;
+	}
+}
+
+static long histogram_bound(const char *str1, size_t len1, const char *str2, size_t len2){
+	int64_t counts[HISTOGRAM_SPLIT * 256];
+	int num_histograms = (len1 + len2 >= HISTOGRAM_SPLIT_CHARS) ? HISTOGRAM_SPLIT : 1;
+	memset(counts, 0, num_histograms * 256 * sizeof(int64_t));
+	count_characters(counts, num_histograms, str1, len1, 1);
+	count_characters(counts, num_histograms, str2, len2, -1);
+
+	long sum = 0;
+	for(int c = 0; c < 256; c++){
+		int64_t count = 0;
+		for(int h = 0; h < num_histograms; h++){
+			count += counts[h * 256 + c];
+		}
+		sum += labs(count);
+	}
+
+	/*
+	* A substitution fixes one surplus character on each side, an
+	* insertion or deletion one on a single side. sum and the length
+	* difference have the same parity.
+	*/
+	size_t length_difference = (len1 > len2) ? (len1 - len2) : (len2 - len1);
+	return (sum + (long)length_difference) / 2;
+}
+
+/*
+* Number of q-grams the two strings share, counted with multiplicity.
+* Grams are hashed into buckets; two grams sharing a bucket can only add
+* to the count, so it never drops below the true one.
+* Returns -1 if str1 has too many q-grams for the table or it could not be
+* allocated.
+*/
+static long shared_qgrams(const char *str1, size_t len1, const char *str2, size_t len2, int q){
+	if(len1 < (size_t)q || len2 < (size_t)q){
+		return 0;
+	}
+	size_t grams = len1 - q + 1;
+	if(grams > ((size_t)1 << (MAX_QGRAM_BITS - 1))){
+		return -1;
+	}
+	int bits = MIN_QGRAM_BITS;
+	while(((size_t)1 << bits) < 2 * grams){
+		bits++;
+	}
+	int32_t stack_table[1 << STACK_QGRAM_BITS];
+	int32_t *table = stack_table;
+	if(bits > STACK_QGRAM_BITS){
+		table = malloc(sizeof(int32_t) << bits);
+		if(table == NULL){
+			return -1;
+		}
+	}
+	memset(table, 0, sizeof(int32_t) << bits);
+	uint32_t mask = (q == 4) ? 0xffffffffu : ((1u << (8 * q)) - 1);
+
+	uint32_t gram = 0;
+	for(size_t i = 0; i < len1; i++){
+		gram = ((gram << 8) | (unsigned char)str1[i]) & mask;
+		if(i + 1 >= (size_t)q){
+			table[(gram * 2654435761u) >> (32 - bits)]++;
+		}
+	}
+	long shared = 0;
+	gram = 0;
+	for(size_t j = 0; j < len2; j++){
+		gram = ((gram << 8) | (unsigned char)str2[j]) & mask;
+		if(j + 1 >= (size_t)q){
+			int32_t *bucket = &table[(gram * 2654435761u) >> (32 - bits)];
+			if(*bucket > 0){
+				(*bucket)--;
+				shared++;
+			}
+		}
+	}
+	if(table != stack_table){
+		free(table);
+	}
+	return shared;
+}
+
+FilterStage filter_cascade_check(const char *str1, size_t len1, const char *str2, size_t len2, int k){
+	if(k < 0){
+		k = 0;
+	}
+	size_t length_difference = (len1 > len2) ? (len1 - len2) : (len2 - len1);
+	if(length_difference > (size_t)k){
+		return FILTER_STAGE_LENGTH;
+	}
+	if(len1 == 0 || len2 == 0){
+		return FILTER_STAGE_NONE;
+	}
+	if(histogram_bound(str1, len1, str2, len2) > k){
+		return FILTER_STAGE_HISTOGRAM;
+	}
+
+	/*
+	* Every edit touches at most q of the longer string's q-grams, so a
+	* pair within k keeps at least longer - q + 1 - k * q of them. Longer
+	* grams tell strings apart better but leave a smaller bound; take
+	* the longest q whose bound is still positive.
+	*/
+	long longer = (len1 > len2) ? (long)len1 : (long)len2;
+	for(int q = 4; q >= 2; q--){
+		long threshold = longer - q + 1 - (long)k * q;
+		if(threshold > 0){
+			long shared = shared_qgrams(str1, len1, str2, len2, q);
+			if(shared >= 0 && shared < threshold){
+				return FILTER_STAGE_QGRAM;
+			}
+			break;
+		}
+	}
+	return FILTER_STAGE_NONE;
+}
+
+/*
+* Small survivors run the banded naive DP, large ones every thread each
+* through the SIMD kernel's band.
+*/
+static long filter_solve(const EditPair *pair, long num_threads, void *solver_args){
+	int k = *(const int*)solver_args;
+	if(!edit_pair_is_large(pair)){
+		return naive_edit_distance_rect_bounded(pair->str1, pair->len1, pair->str2, pair->len2, k);
+	}
+	WavefrontOptions options = {WAVEFRONT_SCHEDULE_DATAFLOW, NULL, 1, k};
+	return simd_edit_distance_rect(pair->str1, pair->len1, pair->str2, pair->len2,
+		num_threads, &options);
+}
+
+int filter_cascade(const EditPair *pairs, size_t n, int k, int *results, long num_threads,
+	FilterStats *stats){
+	if(k < 0){
+		k = 0;
+	}
+	if(k > BOUNDED_MAX_DISTANCE){
+		k = BOUNDED_MAX_DISTANCE;
+	}
+	if(num_threads < 1){
+		num_threads = 1;
+	}
+	FilterStats counts = {0};
+	if(n == 0){
+		if(stats != NULL){
+			*stats = counts;
+		}
+		return 0;
+	}
+	counts.candidates = n;
+	size_t *survivors = malloc(n * sizeof(size_t));
+	EditPair *survivor_pairs = malloc(n * sizeof(EditPair));
+	long *survivor_results = malloc(n * sizeof(long));
+	if(survivors == NULL || survivor_pairs == NULL || survivor_results == NULL){
+		printf("Failed to allocate memory in filter_cascade().");
+		free(survivors);
+		free(survivor_pairs);
+		free(survivor_results);
+		return -1;
+	}
+
+	size_t num_survivors = 0;
+	for(size_t i = 0; i < n; i++){
+		FilterStage stage = filter_cascade_check(pairs[i].str1, pairs[i].len1, pairs[i].str2,
+			pairs[i].len2, k);
+		counts.length_rejected += (stage == FILTER_STAGE_LENGTH);
+		counts.histogram_rejected += (stage == FILTER_STAGE_HISTOGRAM);
+		counts.qgram_rejected += (stage == FILTER_STAGE_QGRAM);
+		if(stage != FILTER_STAGE_NONE){
+			results[i] = k + 1;
+			continue;
+		}
+		survivors[num_survivors] = i;
+		survivor_pairs[num_survivors] = pairs[i];
+		num_survivors++;
+	}
+
+	int status = edit_pairs_solve(survivor_pairs, num_survivors, survivor_results, num_threads,
+		filter_solve, &k);
+	counts.computed = num_survivors;
+	for(size_t s = 0; s < num_survivors; s++){
+		results[survivors[s]] = (int)survivor_results[s];
+		counts.accepted += (survivor_results[s] <= k);
+	}
+	if(stats != NULL){
+		*stats = counts;
+	}
+	free(survivors);
+	free(survivor_pairs);
+	free(survivor_results);
+	if(status != 0){
+		printf("Failed to allocate memory in filter_cascade().");
+	}
+	return status;
+}
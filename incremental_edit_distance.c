@@ -0,0 +1,222 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "src/incremental_edit_distance.h"
+#include "src/myers.h"
+
+struct IncrementalDistance {
+	size_t len1;
+	size_t words;
+	int last_bit;
+	uint64_t *peq;		// 256 x words match masks of str1
+
+	char *text;		// str2
+	size_t length;
+	size_t text_capacity;
+
+	/*
+	* The column at length: vertical +1 deltas in column[0..words), -1
+	* deltas in column[words..2 * words), and its last cell.
+	*/
+	uint64_t *column;
+	long score;
+
+	/*
+	* Checkpoint k is the column at k * checkpoint_every, stored the same
+	* way. Checkpoint 0 (column 0) is always there.
+	*/
+	size_t checkpoint_every;
+	uint64_t *checkpoints;
+	long *checkpoint_scores;
+	size_t num_checkpoints;
+	size_t checkpoint_capacity;
+
+	size_t columns_computed;
+};
+
+/*
+* Makes room for the text and checkpoints of a str2 of length characters.
+* Returns -1 if memory could not be allocated, leaving everything as it
+* was.
+*/
+static int reserve(IncrementalDistance *incremental, size_t length){
+	if(length + 1 > incremental->text_capacity){
+		size_t capacity = 2 * incremental->text_capacity;
+		capacity = (capacity > length + 1) ? capacity : length + 1;
+		char *text = realloc(incremental->text, capacity);
+		if(text == NULL){
+			return -1;
+		}
+		incremental->text = text;
+		incremental->text_capacity = capacity;
+	}
+
+	size_t needed = 1;
+	if(incremental->checkpoint_every > 0){
+		needed += length / incremental->checkpoint_every;
+	}
+	if(needed > incremental->checkpoint_capacity){
+		size_t capacity = 2 * incremental->checkpoint_capacity;
+		capacity = (capacity > needed) ? capacity : needed;
+		size_t column_words = 2 * incremental->words;
+		uint64_t *checkpoints = realloc(incremental->checkpoints,
+			capacity * column_words * sizeof(uint64_t) + 1);
+		if(checkpoints == NULL){
+			return -1;
+		}
+		incremental->checkpoints = checkpoints;
+		long *scores = realloc(incremental->checkpoint_scores, capacity * sizeof(long));
+		if(scores == NULL){
+			return -1;
+		}
+		incremental->checkpoint_scores = scores;
+		incremental->checkpoint_capacity = capacity;
+	}
+	return 0;
+}
+
+static void save_checkpoint(IncrementalDistance *incremental){
+	size_t column_words = 2 * incremental->words;
+	size_t k = incremental->num_checkpoints++;
+	memcpy(&incremental->checkpoints[k * column_words], incremental->column,
+		column_words * sizeof(uint64_t));
+	incremental->checkpoint_scores[k] = incremental->score;
+}
+
+static void restore_checkpoint(IncrementalDistance *incremental, size_t k){
+	size_t column_words = 2 * incremental->words;
+	memcpy(incremental->column, &incremental->checkpoints[k * column_words],
+		column_words * sizeof(uint64_t));
+	incremental->score = incremental->checkpoint_scores[k];
+	incremental->num_checkpoints = k + 1;
+}
+
+/*
+* Advances the column from column from to column to of the current text,
+* saving the checkpoints it passes. Row 0 grows by one per column, so a +1
+* enters at the top of the first block.
+*/
+static void advance(IncrementalDistance *incremental, size_t from, size_t to){
+	size_t words = incremental->words;
+	uint64_t *pv = incremental->column;
+	uint64_t *mv = pv + words;
+	size_t every = incremental->checkpoint_every;
+	for(size_t j = from; j < to; j++){
+		const uint64_t *eq = &incremental->peq[(unsigned char)incremental->text[j] * words];
+		int hin = 1;
+		for(size_t w = 0; w + 1 < words; w++){
+			hin = myers_advance_block(&pv[w], &mv[w], eq[w], hin, 63);
+		}
+		if(words > 0){
+			hin = myers_advance_block(&pv[words - 1], &mv[words - 1], eq[words - 1], hin,
+				incremental->last_bit);
+		}
+		incremental->score += hin;
+		if(every > 0 && (j + 1) % every == 0){
+			save_checkpoint(incremental);
+		}
+	}
+	incremental->columns_computed += to - from;
+}
+
+IncrementalDistance *incremental_create(const char *str1, size_t len1, size_t checkpoint_every){
+	IncrementalDistance *incremental = calloc(1, sizeof(IncrementalDistance));
+	if(incremental == NULL){
+		printf("Failed to allocate memory in incremental_create().");
+		return NULL;
+	}
+	incremental->len1 = len1;
+	incremental->words = (len1 + 63) / 64;
+	incremental->last_bit = (len1 > 0) ? (int)((len1 - 1) % 64) : 0;
+	incremental->checkpoint_every = checkpoint_every;
+	incremental->peq = calloc(256 * incremental->words + 1, sizeof(uint64_t));
+	incremental->column = malloc(2 * incremental->words * sizeof(uint64_t) + 1);
+	if(incremental->peq == NULL || incremental->column == NULL || reserve(incremental, 0) != 0){
+		printf("Failed to allocate memory in incremental_create().");
+		incremental_free(incremental);
+		return NULL;
+	}
+	for(size_t i = 0; i < len1; i++){
+		incremental->peq[(unsigned char)str1[i] * incremental->words + i / 64] |= 1ULL << (i % 64);
+	}
+
+	// Column 0: D[i][0] = i
+	for(size_t w = 0; w < incremental->words; w++){
+		incremental->column[w] = ~0ULL;
+		incremental->column[incremental->words + w] = 0;
+	}
+	incremental->score = len1;
+	save_checkpoint(incremental);
+	incremental->text[0] = '\0';
+	return incremental;
+}
+
+long incremental_append(IncrementalDistance *incremental, const char *text, size_t len){
+	if(reserve(incremental, incremental->length + len) != 0){
+		printf("Failed to allocate memory in incremental_append().");
+		return -1;
+	}
+	memcpy(incremental->text + incremental->length, text, len);
+	size_t from = incremental->length;
+	incremental->length += len;
+	incremental->text[incremental->length] = '\0';
+	advance(incremental, from, incremental->length);
+	return incremental->score;
+}
+
+long incremental_edit(IncrementalDistance *incremental, size_t offset, size_t removed,
+	const char *text, size_t len){
+	if(offset > incremental->length || removed > incremental->length - offset){
+		printf("Edit past the end of the text in incremental_edit().");
+		return -1;
+	}
+	size_t length = incremental->length - removed + len;
+	if(reserve(incremental, length) != 0){
+		printf("Failed to allocate memory in incremental_edit().");
+		return -1;
+	}
+	char *start = incremental->text + offset;
+	memmove(start + len, start + removed, incremental->length - offset - removed + 1);
+	memcpy(start, text, len);
+	incremental->length = length;
+
+	/*
+	* Columns up to offset only depend on the untouched prefix.
+	*/
+	size_t k = (incremental->checkpoint_every > 0) ? offset / incremental->checkpoint_every : 0;
+	if(k >= incremental->num_checkpoints){
+		k = incremental->num_checkpoints - 1;
+	}
+	restore_checkpoint(incremental, k);
+	advance(incremental, k * incremental->checkpoint_every, length);
+	return incremental->score;
+}
+
+long incremental_distance(const IncrementalDistance *incremental){
+	return incremental->score;
+}
+
+const char *incremental_text(const IncrementalDistance *incremental){
+	return incremental->text;
+}
+
+size_t incremental_length(const IncrementalDistance *incremental){
+	return incremental->length;
+}
+
+size_t incremental_columns_computed(const IncrementalDistance *incremental){
+	return incremental->columns_computed;
+}
+
+void incremental_free(IncrementalDistance *incremental){
+	if(incremental == NULL){
+		return;
+	}
+	free(incremental->peq);
+	free(incremental->text);
+	free(incremental->column);
+	free(incremental->checkpoints);
+	free(incremental->checkpoint_scores);
+	free(incremental);
+}
@@ -8,9 +8,20 @@
 #include "naive_edit_distance.h"
 #include "src/tiled_edit_distance.h"
 #include "src/parallelized_edit_distance.h"
-#include "src/avx2_edit_distance.h"
+#include "src/simd_edit_distance.h"
+#include "src/bitparallel_edit_distance.h"
+#include "src/batch_edit_distance.h"
+#include "src/mapped_input.h"
 
 static const size_t n = 100000;
+
+/*
+* Size of the short-pair batch benchmark: num_pairs pairs of 10 to
+* max_pair_len characters each.
+*/
+static const size_t num_pairs = 100000;
+static const size_t min_pair_len = 10;
+static const size_t max_pair_len = 300;
 static const char charset[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
 
 
@@ -43,7 +54,75 @@ char *generate_random_str(size_t len){
 	return str;
 }
 
-int main(){
+/*
+* File mode (./main [--strip] FILE1 FILE2): both files are mapped read-only
+* and handed to the wavefront engines without copying. With --strip, line
+* breaks and FASTA headers are skipped through a segment map. The naive and
+* tiled engines are left out, at file sizes they would take far too long.
+*/
+static int run_files(int argc, char **argv, int num_threads){
+	int flags = MAPPED_INPUT_HUGE_PAGES;
+	int first = 1;
+	if(argc > 1 && strcmp(argv[1], "--strip") == 0){
+		flags |= MAPPED_INPUT_STRIP;
+		first = 2;
+	}
+	if(argc - first != 2){
+		fprintf(stderr, "Usage: %s [--strip] FILE1 FILE2\n", argv[0]);
+		return 1;
+	}
+
+	MappedInput input1, input2;
+	if(mapped_input_open(argv[first], flags, &input1) != 0){
+		return 1;
+	}
+	if(mapped_input_open(argv[first + 1], flags, &input2) != 0){
+		mapped_input_close(&input1);
+		return 1;
+	}
+	printf("Mapped %s (%zu characters, %zu pieces) and %s (%zu characters, %zu pieces).\n",
+		argv[first], input1.length, input1.map.num_pieces,
+		argv[first + 1], input2.length, input2.map.num_pieces);
+
+	/*
+	* Contiguous inputs go in as plain pointers; the others through their
+	* segment map.
+	*/
+	WavefrontOptions options = {WAVEFRONT_SCHEDULE_DATAFLOW};
+	options.segments1 = (input1.text == NULL) ? &input1.map : NULL;
+	options.segments2 = (input2.text == NULL) ? &input2.map : NULL;
+	const char *str1 = input1.text;
+	const char *str2 = input2.text;
+	size_t len1 = input1.length;
+	size_t len2 = input2.length;
+
+	const char *names[] = {"parallelized_edit_distance()", "simd_edit_distance()", "bitparallel_edit_distance()"};
+	long results[3];
+	for(int e = 0; e < 3; e++){
+		printf("Running %s...\n", names[e]);
+		fflush(stdout);
+		double start = returnCurrentTime();
+		if(e == 0){
+			results[e] = parallelized_edit_distance_rect(str1, len1, str2, len2, num_threads, &options);
+		}
+		else if(e == 1){
+			results[e] = simd_edit_distance_rect(str1, len1, str2, len2, num_threads, &options);
+		}
+		else{
+			results[e] = bitparallel_edit_distance_threads(str1, len1, str2, len2, num_threads, &options);
+		}
+		double end = returnCurrentTime();
+		printf("%s result: %ld, runtime: %.3f s\n", names[e], results[e], (end-start)/1000);
+	}
+	printf("%s\n", (results[0] == results[1] && results[1] == results[2])
+		? "Results are the same!" : "Results are not the same!");
+
+	mapped_input_close(&input1);
+	mapped_input_close(&input2);
+	return 0;
+}
+
+int main(int argc, char **argv){
 	const long num_processors = sysconf(_SC_NPROCESSORS_ONLN);
 	/*
 	* Fallback: 2 threads is a safe estimate for modern computers 
@@ -59,9 +138,12 @@ int main(){
     else if(num_processors >= 16) { num_threads = 16; }
     else { num_threads = num_processors; }
 	printf("Detected %ld logical processor(s). Using %i thread(s) for parallelized implementation.\n", num_processors, num_threads);
+	if(argc > 1){
+		return run_files(argc, argv, num_threads);
+	}
 
 	char *str1, *str2;
-	size_t len;
+	size_t len1, len2;
 
 	char option;
 	printf("Run edit distance calculation with two random strings of len=%lu (1) OR two custom strings (2)?", n);
@@ -79,31 +161,21 @@ int main(){
 		size_t cap2 = 0;
 
 		printf("Please enter the first string (press ENTER to terminate): ");
-		ssize_t len1 = getline(&str1, &cap1, stdin);
+		ssize_t read1 = getline(&str1, &cap1, stdin);
 
 		printf("Please enter the second string (press ENTER to terminate): ");
-		ssize_t len2 = getline(&str2, &cap2, stdin);
+		ssize_t read2 = getline(&str2, &cap2, stdin);
 
-		if (len1 == -1 || len2 == -1) {
+		if (read1 == -1 || read2 == -1) {
 			fprintf(stderr, "Error reading input.\n");
 			return 1;
 		}
-		if (len1 > 0 && str1[len1 - 1] == '\n') str1[--len1] = '\0';
-		if (len2 > 0 && str2[len2 - 1] == '\n') str2[--len2] = '\0';
-
-		if (len1 != len2) {
-			printf("Strings must be of equal length. Truncating the longer string to match the length of the shorter string.\n");
-			if (len1 > len2) {
-				str1[strlen(str2)] = '\0';
-				len1 = len2;
-			}
-			else {
-				str2[strlen(str1)] = '\0';
-				len2 = len1;
-			}
-		}
-		len = (size_t)len1;
-		printf("Custom strings loaded (length: %zu).\n\n", len);
+		if (read1 > 0 && str1[read1 - 1] == '\n') str1[--read1] = '\0';
+		if (read2 > 0 && str2[read2 - 1] == '\n') str2[--read2] = '\0';
+
+		len1 = (size_t)read1;
+		len2 = (size_t)read2;
+		printf("Custom strings loaded (lengths: %zu and %zu).\n\n", len1, len2);
 	}
 
 	// User chose random strings OR unrecognized input.
@@ -111,15 +183,16 @@ int main(){
 		if (!(res == 1 && option == '2')) {
 			printf("Could not recognize input. Defaulting to calculation with two random strings.\n");
 		}
-		len = n;
+		len1 = n;
+		len2 = n;
 		/*
 		* Generate the two random strings of size n.
 		* Potentially generating predictable sequence of values due to time(NULL) seeding, but this is not an issue
 		* for a non-critical application such as this.
  		*/
 		srand(time(NULL)); // NOLINT
-		str1 = generate_random_str(len);
-		str2 = generate_random_str(len);
+		str1 = generate_random_str(len1);
+		str2 = generate_random_str(len2);
 
 		/*
 		* Ensure str1 and str2 were initialized
@@ -144,40 +217,48 @@ int main(){
 	fflush(stdout);
 
 	double start1 = returnCurrentTime();
-	int edit_distance1 = naive_edit_distance(str1, str2, len);
+	long edit_distance1 = naive_edit_distance_rect(str1, len1, str2, len2);
 	double end1 = returnCurrentTime();
 	printf("naive_edit_distance() calculation finished. Running tiled_edit_distance()...\n");
 	fflush(stdout);
 
 	double start2 = returnCurrentTime();
-	int edit_distance2 = tiled_edit_distance(str1, str2, len);
+	long edit_distance2 = tiled_edit_distance_rect(str1, len1, str2, len2);
 	double end2 = returnCurrentTime();
 	printf("tiled_edit_distance() calculation finished. Running parallelized_edit_distance()...\n");
 	fflush(stdout);
 
 	double start3 = returnCurrentTime();
-	int edit_distance3 = parallelized_edit_distance(str1, str2, len, num_threads);
+	long edit_distance3 = parallelized_edit_distance_rect(str1, len1, str2, len2, num_threads, NULL);
 	double end3 = returnCurrentTime();
-	printf("parallelized_edit_distance() calculation finished. Running avx2_edit_distance()...\n");
+	printf("parallelized_edit_distance() calculation finished. Running simd_edit_distance() (%s kernel)...\n", simd_kernel_name());
 	fflush(stdout);
 
 	double start4 = returnCurrentTime();
-	int edit_distance4 = avx2_edit_distance(str1, str2, len, num_threads);
+	long edit_distance4 = simd_edit_distance_rect(str1, len1, str2, len2, num_threads, NULL);
 	double end4 = returnCurrentTime();
-	printf("avx2_edit_distance() calculation finished.\n");
+	printf("simd_edit_distance() calculation finished. Running bitparallel_edit_distance()...\n");
+	fflush(stdout);
+
+	double start5 = returnCurrentTime();
+	long edit_distance5 = bitparallel_edit_distance_rect(str1, len1, str2, len2, NULL);
+	double end5 = returnCurrentTime();
+	printf("bitparallel_edit_distance() calculation finished.\n");
 	fflush(stdout);
 
 	/*
 	* Print the results
 	*/
 	printf("\n");
-	printf("naive_edit_distance() result: %i\n", edit_distance1);
-	printf("tiled_edit_distance() result: %i\n", edit_distance2);
-	printf("parallelized_edit_distance() result: %i\n", edit_distance3);
-	printf("avx2_edit_distance() result: %i\n", edit_distance4);
+	printf("naive_edit_distance() result: %ld\n", edit_distance1);
+	printf("tiled_edit_distance() result: %ld\n", edit_distance2);
+	printf("parallelized_edit_distance() result: %ld\n", edit_distance3);
+	printf("simd_edit_distance() result: %ld\n", edit_distance4);
+	printf("bitparallel_edit_distance() result: %ld\n", edit_distance5);
 	if(edit_distance1 == edit_distance2 &&
 		edit_distance2 == edit_distance3 &&
-		edit_distance3 == edit_distance4){
+		edit_distance3 == edit_distance4 &&
+		edit_distance4 == edit_distance5){
 		printf("Results are the same!\n");
 		}
 	else{
@@ -191,7 +272,71 @@ int main(){
 	printf("naive_edit_distance() runtime: %.3f s\n", (end1-start1)/1000);
 	printf("tiled_edit_distance() runtime: %.3f s\n", (end2-start2)/1000);
 	printf("parallelized_edit_distance() runtime: %.3f s\n", (end3-start3)/1000);
-	printf("avx2_edit_distance() runtime: %.3f s\n", (end4-start4)/1000);
+	printf("simd_edit_distance() runtime: %.3f s\n", (end4-start4)/1000);
+	printf("bitparallel_edit_distance() runtime: %.3f s\n", (end5-start5)/1000);
+	printf("\n");
+
+	/*
+	* Compare the dataflow tile scheduler against the per-wave barrier
+	* version on the same input.
+	*/
+	printf("Comparing tile schedulers for simd_edit_distance()...\n");
+	fflush(stdout);
+	const char *schedule_names[] = {"dataflow", "barrier"};
+	WavefrontSchedule schedules[] = {WAVEFRONT_SCHEDULE_DATAFLOW, WAVEFRONT_SCHEDULE_BARRIER};
+	for(int s = 0; s < 2; s++){
+		WavefrontStats stats;
+		WavefrontOptions options = {schedules[s], &stats};
+		simd_edit_distance_rect(str1, len1, str2, len2, num_threads, &options);
+		printf("%s schedule: %.3f s, core utilization %.1f%% (%ld tiles, %ld steals)\n",
+			schedule_names[s], stats.wall_ms / 1000, stats.utilization * 100,
+			stats.tiles, stats.steals);
+	}
+	printf("\n");
+
+	/*
+	* Many short pairs: edit_distance_batch() against one naive call per pair
+	*/
+	printf("Running edit_distance_batch() on %zu random pairs of %zu-%zu characters...\n",
+		num_pairs, min_pair_len, max_pair_len);
+	fflush(stdout);
+	EditPair *pairs = malloc(num_pairs * sizeof(EditPair));
+	int *batch_results = malloc(num_pairs * sizeof(int));
+	char *pool = generate_random_str(2 * num_pairs * max_pair_len);
+	if(pairs == NULL || batch_results == NULL || pool == NULL){
+		printf("Unable to allocate the pairs, skipping the batch benchmark.\n");
+	}
+	else{
+		for(size_t i = 0; i < num_pairs; i++){
+			pairs[i].str1 = pool + 2 * i * max_pair_len;
+			pairs[i].len1 = min_pair_len + rand() % (max_pair_len - min_pair_len + 1);
+			pairs[i].str2 = pairs[i].str1 + max_pair_len;
+			pairs[i].len2 = min_pair_len + rand() % (max_pair_len - min_pair_len + 1);
+		}
+
+		double start6 = returnCurrentTime();
+		int status = edit_distance_batch(pairs, num_pairs, batch_results, num_threads);
+		double end6 = returnCurrentTime();
+
+		double start7 = returnCurrentTime();
+		int mismatches = 0;
+		for(size_t i = 0; i < num_pairs; i++){
+			int expected = naive_edit_distance_rect(pairs[i].str1, pairs[i].len1, pairs[i].str2, pairs[i].len2);
+			if(status != 0 || batch_results[i] != expected){
+				mismatches++;
+			}
+		}
+		double end7 = returnCurrentTime();
+
+		printf("%s\n", mismatches ? "Batch results are not the same!" : "Batch results are the same!");
+		printf("edit_distance_batch() runtime: %.3f s (%.0f pairs/s)\n",
+			(end6-start6)/1000, num_pairs / ((end6-start6)/1000));
+		printf("naive_edit_distance() per pair runtime: %.3f s (%.0f pairs/s)\n",
+			(end7-start7)/1000, num_pairs / ((end7-start7)/1000));
+	}
+	free(pairs);
+	free(batch_results);
+	free(pool);
 	printf("\n");
 
 	/*
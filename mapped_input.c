@@ -0,0 +1,168 @@
+#define _DEFAULT_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "src/mapped_input.h"
+
+/*
+* Appends the piece data[offset, offset + length) to the map, growing its
+* arrays as needed. Returns -1 if they could not grow.
+*/
+static int add_piece(SegmentMap *map, size_t *capacity, size_t offset, size_t length){
+	if(length == 0){
+		return 0;
+	}
+	if(map->num_pieces + 1 >= *capacity){
+		size_t grown = 2 * *capacity;
+		size_t *starts = realloc(map->starts, grown * sizeof(size_t));
+		if(starts == NULL){
+			return -1;
+		}
+		map->starts = starts;
+		size_t *offsets = realloc(map->offsets, grown * sizeof(size_t));
+		if(offsets == NULL){
+			return -1;
+		}
+		map->offsets = offsets;
+		*capacity = grown;
+	}
+	map->offsets[map->num_pieces] = offset;
+	map->starts[map->num_pieces + 1] = map->starts[map->num_pieces] + length;
+	map->num_pieces++;
+	return 0;
+}
+
+/*
+* One pass over the file: every line that is not a header or comment
+* becomes a piece, without its line break.
+*/
+static int index_lines(SegmentMap *map, size_t *capacity, const char *data, size_t size){
+	size_t line = 0;
+	while(line < size){
+		const char *newline = memchr(data + line, '\n', size - line);
+		size_t end = (newline != NULL) ? (size_t)(newline - data) : size;
+		size_t next = (newline != NULL) ? end + 1 : size;
+		if(end > line && data[end - 1] == '\r'){
+			end--;
+		}
+		if(data[line] != '>' && data[line] != ';' && add_piece(map, capacity, line, end - line) != 0){
+			return -1;
+		}
+		line = next;
+	}
+	return 0;
+}
+
+int mapped_input_open(const char *path, int flags, MappedInput *input){
+	memset(input, 0, sizeof(MappedInput));
+	int fd = open(path, O_RDONLY);
+	struct stat info;
+	if(fd < 0 || fstat(fd, &info) != 0){
+		printf("Unable to open %s.\n", path);
+		if(fd >= 0){
+			close(fd);
+		}
+		return -1;
+	}
+
+	size_t size = (size_t)info.st_size;
+	const char *data = "";
+	if(size > 0){
+		void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(mapping == MAP_FAILED){
+			printf("Unable to map %s.\n", path);
+			close(fd);
+			return -1;
+		}
+		/*
+		* The engines sweep each string front to back, a tile's worth at
+		* a time, so read-ahead helps and pages behind can go.
+		*/
+		madvise(mapping, size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+		if(flags & MAPPED_INPUT_HUGE_PAGES){
+			madvise(mapping, size, MADV_HUGEPAGE);
+		}
+#endif
+		input->mapping = mapping;
+		input->mapping_size = size;
+		data = mapping;
+	}
+	close(fd);
+
+	size_t capacity = 16;
+	input->map.data = data;
+	input->map.starts = malloc(capacity * sizeof(size_t));
+	input->map.offsets = malloc(capacity * sizeof(size_t));
+	int status = (input->map.starts == NULL || input->map.offsets == NULL) ? -1 : 0;
+	if(status == 0){
+		input->map.starts[0] = 0;
+		if(flags & MAPPED_INPUT_STRIP){
+			status = index_lines(&input->map, &capacity, data, size);
+		}
+		else{
+			size_t length = size;
+			if(length > 0 && data[length - 1] == '\n'){
+				length--;
+			}
+			if(length > 0 && data[length - 1] == '\r'){
+				length--;
+			}
+			status = add_piece(&input->map, &capacity, 0, length);
+		}
+	}
+	if(status != 0){
+		printf("Failed to allocate the segment map for %s.\n", path);
+		mapped_input_close(input);
+		return -1;
+	}
+
+	const SegmentMap *map = &input->map;
+	input->length = map->starts[map->num_pieces];
+	if(map->num_pieces == 0){
+		input->text = "";
+	}
+	else if(map->num_pieces == 1){
+		input->text = data + map->offsets[0];
+	}
+	return 0;
+}
+
+void mapped_input_close(MappedInput *input){
+	if(input->mapping != NULL){
+		munmap(input->mapping, input->mapping_size);
+	}
+	free(input->map.starts);
+	free(input->map.offsets);
+	memset(input, 0, sizeof(MappedInput));
+}
+
+void segment_map_copy(const SegmentMap *map, size_t from, size_t count, char *out){
+	/*
+	* Last piece starting at or before from
+	*/
+	size_t low = 0, high = map->num_pieces;
+	while(high - low > 1){
+		size_t middle = low + (high - low) / 2;
+		if(map->starts[middle] <= from){
+			low = middle;
+		}
+		else{
+			high = middle;
+		}
+	}
+
+	for(size_t k = low; count > 0; k++){
+		size_t skip = from - map->starts[k];
+		size_t available = map->starts[k + 1] - from;
+		size_t take = (available < count) ? available : count;
+		memcpy(out, map->data + map->offsets[k] + skip, take);
+		out += take;
+		from += take;
+		count -= take;
+	}
+}
@@ -1,6 +1,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include "src/naive_edit_distance.h"
+#include "src/common_affix.h"
+#include "src/boundary.h"
 
 /*
 * Helper minimum function (returns whichever of a, b, and c is smaller).
@@ -10,12 +12,31 @@ static inline int min(int a, int b, int c){
 	return (temp < c) ? temp : c;
 }
 
-int naive_edit_distance(const char *str1, const char *str2, size_t len){
-    if(len < 1){
-        return 0;
-    }
-	int *prev_row = malloc((len + 1) * sizeof(int));
-	int *cur_row = malloc((len + 1) * sizeof(int));
+static inline long min_long(long a, long b, long c){
+	long temp = (a < b) ? a : b;
+	return (temp < c) ? temp : c;
+}
+
+long naive_edit_distance(const char *str1, const char *str2, size_t len){
+	return naive_edit_distance_rect(str1, len, str2, len);
+}
+
+long naive_edit_distance_rect(const char *str1, size_t len1, const char *str2, size_t len2){
+	/*
+	* The common prefix and suffix cost nothing (see common_affix.h).
+	* Against an empty string, every character of the other one is an
+	* insertion.
+	*/
+	strip_common_affixes(&str1, &len1, &str2, &len2, NULL, NULL);
+	if(len1 < 1 || len2 < 1){
+		return (long)(len1 + len2);
+	}
+	/*
+	* Scores reach max(len1, len2), so the rows are 64-bit: this is the
+	* reference every other engine is checked against, at any length.
+	*/
+	long *prev_row = malloc((len2 + 1) * sizeof(long));
+	long *cur_row = malloc((len2 + 1) * sizeof(long));
 
 	/*
 	* Check for allocation errors.
@@ -30,32 +51,32 @@ int naive_edit_distance(const char *str1, const char *str2, size_t len){
 	/*
 	* Set up prev_row
 	*/
-	for(int i = 0; i <= len; i++){
-		prev_row[i] = i;
+	for(size_t j = 0; j <= len2; j++){
+		prev_row[j] = j;
 	}
 
-	for(int i = 1; i <= len; i++){
+	for(size_t i = 1; i <= len1; i++){
 		cur_row[0] = i;
 		/*
 		* Calculate costs for the current row from neighbors.
 		*/
-		for(int j = 1; j <= len; j++){
-			int cost;
+		for(size_t j = 1; j <= len2; j++){
+			long cost;
 			if(str1[i-1] == str2[j-1]){
 				cost = prev_row[j-1];
 			}
 			else{
-				int deletion = prev_row[j] + 1;
-				int insertion = cur_row[j-1] + 1;
-				int substitution = prev_row[j-1] + 1;
-				cost = min(deletion, insertion, substitution);
+				long deletion = prev_row[j] + 1;
+				long insertion = cur_row[j-1] + 1;
+				long substitution = prev_row[j-1] + 1;
+				cost = min_long(deletion, insertion, substitution);
 			}
 			cur_row[j] = cost;
 		}
 		/*
 		* Swap pointers; next iteration's prev_row is this iteration's cur_row.
 		*/
-		int *temp = prev_row;
+		long *temp = prev_row;
 		prev_row = cur_row;
 		
 		// Don't really need to keep track of this
@@ -66,8 +87,110 @@ int naive_edit_distance(const char *str1, const char *str2, size_t len){
 	* The edit distance is always the bottom right number in the table.
 	* Note that prev_row contains the last row after the swap.
 	*/
-	int result = prev_row[len];
+	long result = prev_row[len2];
 	free(prev_row);
 	free(cur_row);
 	return result;
+}
+
+int naive_edit_distance_bounded(const char *str1, const char *str2, size_t len, int k){
+	return naive_edit_distance_rect_bounded(str1, len, str2, len, k);
+}
+
+int naive_edit_distance_rect_bounded(const char *str1, size_t len1, const char *str2, size_t len2, int k){
+	if(k < 0){
+		k = 0;
+	}
+	if(k > BOUNDED_MAX_DISTANCE){
+		k = BOUNDED_MAX_DISTANCE;
+	}
+	int limit = k + 1;
+	strip_common_affixes(&str1, &len1, &str2, &len2, NULL, NULL);
+
+	/*
+	* The length difference is a lower bound on the distance, and if it
+	* exceeds k the bottom right cell is not even inside the band.
+	*/
+	size_t length_difference = (len1 > len2) ? (len1 - len2) : (len2 - len1);
+	if(length_difference > (size_t)k){
+		return limit;
+	}
+	if(len1 < 1 || len2 < 1){
+		return (int)length_difference;
+	}
+
+	int *prev_row = malloc((len2 + 1) * sizeof(int));
+	int *cur_row = malloc((len2 + 1) * sizeof(int));
+
+	/*
+	* Check for allocation errors.
+	*/
+	if(prev_row == NULL || cur_row == NULL){
+		printf("Failed to allocate memory for row arrays in naive_edit_distance_bounded(), exiting program.");
+		free(prev_row);
+		free(cur_row);
+		return -1;
+	}
+
+	/*
+	* Set up prev_row. Every cell further than k from the diagonal is
+	* treated as k + 1; its real value can only be larger.
+	*/
+	for(size_t j = 0; j <= len2; j++){
+		prev_row[j] = (j < (size_t)limit) ? (int)j : limit;
+	}
+
+	for(size_t i = 1; i <= len1; i++){
+		/*
+		* Only the band of columns [i - k, i + k] is computed (Ukkonen).
+		*/
+		size_t lo = (i > (size_t)k) ? (i - k) : 1;
+		size_t hi = (i + k < len2) ? (i + k) : len2;
+
+		// Cells just outside the band on either side
+		cur_row[lo - 1] = (lo - 1 == 0 && i < (size_t)limit) ? (int)i : limit;
+		if(i + k <= len2){
+			prev_row[i + k] = limit;
+		}
+
+		int row_min = limit;
+		for(size_t j = lo; j <= hi; j++){
+			int cost;
+			if(str1[i-1] == str2[j-1]){
+				cost = prev_row[j-1];
+			}
+			else{
+				int deletion = prev_row[j] + 1;
+				int insertion = cur_row[j-1] + 1;
+				int substitution = prev_row[j-1] + 1;
+				cost = min(deletion, insertion, substitution);
+			}
+			cur_row[j] = cost;
+			if(cost < row_min){
+				row_min = cost;
+			}
+		}
+
+		/*
+		* Every path to the bottom right crosses this row, so if the whole
+		* band already exceeds k there is nothing left to find.
+		*/
+		if(row_min > k){
+			free(prev_row);
+			free(cur_row);
+			return limit;
+		}
+
+		/*
+		* Swap pointers; next iteration's prev_row is this iteration's cur_row.
+		*/
+		int *temp = prev_row;
+		prev_row = cur_row;
+		cur_row = temp;
+	}
+
+	int result = prev_row[len2];
+	free(prev_row);
+	free(cur_row);
+	return (result > k) ? limit : result;
 }
\ No newline at end of file
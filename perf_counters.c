@@ -0,0 +1,172 @@
+#ifdef EDIT_DISTANCE_PERF
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "src/perf_counters.h"
+
+static PerfReport *active_report = NULL;
+static pthread_mutex_t report_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *counter_names[PERF_NUM_COUNTERS] = {
+	"task_clock_ns", "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"
+};
+
+const char *perf_counter_name(PerfCounter counter){
+	return counter_names[counter];
+}
+
+void perf_report_begin(PerfReport *report, int per_tile){
+	memset(report, 0, sizeof(PerfReport));
+	report->per_tile = per_tile;
+	active_report = report;
+}
+
+void perf_report_end(void){
+	active_report = NULL;
+}
+
+static void counter_attr(PerfCounter counter, struct perf_event_attr *attr){
+	memset(attr, 0, sizeof(struct perf_event_attr));
+	attr->size = sizeof(struct perf_event_attr);
+	attr->type = PERF_TYPE_HARDWARE;
+	attr->exclude_kernel = 1;
+	attr->exclude_hv = 1;
+	attr->read_format = PERF_FORMAT_GROUP;
+	switch(counter){
+		case PERF_TASK_CLOCK:
+			attr->type = PERF_TYPE_SOFTWARE;
+			attr->config = PERF_COUNT_SW_TASK_CLOCK;
+			break;
+		case PERF_CYCLES:
+			attr->config = PERF_COUNT_HW_CPU_CYCLES;
+			break;
+		case PERF_INSTRUCTIONS:
+			attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+			break;
+		case PERF_L1D_MISSES:
+			attr->type = PERF_TYPE_HW_CACHE;
+			attr->config = PERF_COUNT_HW_CACHE_L1D
+				| (PERF_COUNT_HW_CACHE_OP_READ << 8)
+				| (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+			break;
+		case PERF_LLC_MISSES:
+			attr->config = PERF_COUNT_HW_CACHE_MISSES;
+			break;
+		default:
+			attr->config = PERF_COUNT_HW_BRANCH_MISSES;
+			break;
+	}
+}
+
+/*
+* Reads the whole group at once. The group returns the counters that
+* could be opened, in the order they were added.
+*/
+static void read_group(const PerfThread *thread, PerfSample *sample){
+	uint64_t buffer[1 + PERF_NUM_COUNTERS];
+	memset(sample, 0, sizeof(PerfSample));
+	if(read(thread->fd, buffer, sizeof(buffer)) <= 0){
+		return;
+	}
+	int position = 0;
+	for(int c = 0; c < PERF_NUM_COUNTERS && position < (int)buffer[0]; c++){
+		if(thread->opened & (1u << c)){
+			sample->value[c] = buffer[1 + position++];
+		}
+	}
+}
+
+static void add_delta(PerfSample *sum, const PerfSample *end, const PerfSample *start){
+	for(int c = 0; c < PERF_NUM_COUNTERS; c++){
+		sum->value[c] += end->value[c] - start->value[c];
+	}
+}
+
+/*
+* Opens one counter group for the calling thread. The software task clock
+* is the leader, so the group exists even where no hardware counter can
+* be opened.
+*/
+void perf_thread_begin(PerfThread *thread, int thread_id){
+	thread->report = active_report;
+	thread->fd = -1;
+	thread->thread_id = thread_id;
+	thread->opened = 0;
+	if(thread->report == NULL){
+		return;
+	}
+
+	for(int c = 0; c < PERF_NUM_COUNTERS; c++){
+		struct perf_event_attr attr;
+		counter_attr(c, &attr);
+		attr.disabled = (thread->fd < 0);
+		thread->fds[c] = syscall(SYS_perf_event_open, &attr, 0, -1, thread->fd, 0);
+		if(thread->fds[c] >= 0){
+			thread->opened |= 1u << c;
+			if(thread->fd < 0){
+				thread->fd = thread->fds[c];
+			}
+		}
+	}
+	if(thread->fd < 0){
+		thread->report = NULL;
+		return;
+	}
+	ioctl(thread->fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(thread->fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	read_group(thread, &thread->start);
+}
+
+void perf_thread_end(PerfThread *thread){
+	PerfReport *report = thread->report;
+	if(report == NULL){
+		return;
+	}
+	PerfSample end;
+	read_group(thread, &end);
+
+	pthread_mutex_lock(&report_lock);
+	report->available |= thread->opened;
+	add_delta(&report->total, &end, &thread->start);
+	if(thread->thread_id < PERF_MAX_THREADS){
+		add_delta(&report->thread[thread->thread_id], &end, &thread->start);
+		if(thread->thread_id >= report->num_threads){
+			report->num_threads = thread->thread_id + 1;
+		}
+	}
+	pthread_mutex_unlock(&report_lock);
+
+	ioctl(thread->fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+	for(int c = 0; c < PERF_NUM_COUNTERS; c++){
+		if(thread->opened & (1u << c)){
+			close(thread->fds[c]);
+		}
+	}
+}
+
+void perf_tile_begin(PerfThread *thread){
+	if(thread->report == NULL || !thread->report->per_tile){
+		return;
+	}
+	read_group(thread, &thread->tile_start);
+}
+
+void perf_tile_end(PerfThread *thread){
+	PerfReport *report = thread->report;
+	if(report == NULL || !report->per_tile || thread->thread_id >= PERF_MAX_THREADS){
+		return;
+	}
+	PerfSample end;
+	read_group(thread, &end);
+	// Each thread only touches its own slot
+	add_delta(&report->tile[thread->thread_id], &end, &thread->tile_start);
+	report->tile_calls[thread->thread_id]++;
+}
+
+#endif
@@ -0,0 +1,154 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "src/shard_transport.h"
+
+/*
+* Messages a link holds before its sender blocks. A shard sends one per
+* tile row, so this lets it run a few tile rows ahead of the next one.
+*/
+#define RING_SLOTS 8
+
+/*
+* Reads of the other side's counter before going to sleep on it.
+*/
+#define SPIN_LIMIT 2000
+
+#define CACHE_LINE 64
+
+/*
+* One link, in the shared mapping. sent and received count messages and
+* double as the futex words; each side only writes its own counter, on
+* its own cache line. The slots follow the header.
+*/
+typedef struct {
+	_Alignas(CACHE_LINE) _Atomic uint32_t sent;
+	_Atomic uint32_t receiver_sleeping;
+	_Alignas(CACHE_LINE) _Atomic uint32_t received;
+	_Atomic uint32_t sender_sleeping;
+} ShmRing;
+
+typedef struct {
+	ShardTransport base;
+	char *mapping;
+	size_t mapping_bytes;
+	size_t slot_bytes;
+	size_t ring_bytes;
+} ShmTransport;
+
+/*
+* The futexes live in a MAP_SHARED mapping used by several processes, so
+* they are the shared kind (no FUTEX_PRIVATE_FLAG).
+*/
+static void futex_wait(_Atomic uint32_t *word, uint32_t expected){
+	syscall(SYS_futex, (uint32_t*)word, FUTEX_WAIT, expected, NULL, NULL, 0);
+}
+
+static void futex_wake(_Atomic uint32_t *word){
+	syscall(SYS_futex, (uint32_t*)word, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+/*
+* Waits until *word differs from value. The sleeping flag is raised before
+* the last check, and the other side stores its counter before looking at
+* the flag, so a wake-up cannot fall between the two.
+*/
+static void wait_for_change(_Atomic uint32_t *word, uint32_t value, _Atomic uint32_t *sleeping){
+	for(int spin = 0; spin < SPIN_LIMIT; spin++){
+		if(atomic_load_explicit(word, memory_order_acquire) != value){
+			return;
+		}
+	}
+	while(atomic_load(word) == value){
+		atomic_store(sleeping, 1);
+		if(atomic_load(word) == value){
+			futex_wait(word, value);
+		}
+		atomic_store(sleeping, 0);
+	}
+}
+
+static void publish(_Atomic uint32_t *word, uint32_t value, _Atomic uint32_t *sleeping){
+	atomic_store(word, value);
+	if(atomic_load(sleeping)){
+		futex_wake(word);
+	}
+}
+
+static ShmRing *ring_at(ShmTransport *shm, int link){
+	return (ShmRing*)(shm->mapping + (size_t)link * shm->ring_bytes);
+}
+
+static char *slot_at(ShmTransport *shm, ShmRing *ring, uint32_t message){
+	return (char*)ring + sizeof(ShmRing) + (size_t)(message % RING_SLOTS) * shm->slot_bytes;
+}
+
+static int shm_send(ShardTransport *transport, int link, const void *data, size_t bytes){
+	ShmTransport *shm = (ShmTransport*)transport;
+	if(bytes > shm->slot_bytes){
+		return -1;
+	}
+	ShmRing *ring = ring_at(shm, link);
+	uint32_t sent = atomic_load_explicit(&ring->sent, memory_order_relaxed);
+	uint32_t received = atomic_load_explicit(&ring->received, memory_order_acquire);
+	while(sent - received >= RING_SLOTS){
+		wait_for_change(&ring->received, received, &ring->sender_sleeping);
+		received = atomic_load_explicit(&ring->received, memory_order_acquire);
+	}
+	memcpy(slot_at(shm, ring, sent), data, bytes);
+	publish(&ring->sent, sent + 1, &ring->receiver_sleeping);
+	return 0;
+}
+
+static int shm_receive(ShardTransport *transport, int link, void *data, size_t bytes){
+	ShmTransport *shm = (ShmTransport*)transport;
+	if(bytes > shm->slot_bytes){
+		return -1;
+	}
+	ShmRing *ring = ring_at(shm, link);
+	uint32_t received = atomic_load_explicit(&ring->received, memory_order_relaxed);
+	wait_for_change(&ring->sent, received, &ring->receiver_sleeping);
+	memcpy(data, slot_at(shm, ring, received), bytes);
+	publish(&ring->received, received + 1, &ring->sender_sleeping);
+	return 0;
+}
+
+static void shm_destroy(ShardTransport *transport){
+	ShmTransport *shm = (ShmTransport*)transport;
+	munmap(shm->mapping, shm->mapping_bytes);
+	free(shm);
+}
+
+ShardTransport *shm_transport_create(int num_links, size_t message_bytes){
+	ShmTransport *shm = malloc(sizeof(ShmTransport));
+	if(shm == NULL){
+		printf("Failed to allocate memory in shm_transport_create().");
+		return NULL;
+	}
+	shm->base.send = shm_send;
+	shm->base.receive = shm_receive;
+	shm->base.destroy = shm_destroy;
+	shm->slot_bytes = (message_bytes + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+	shm->ring_bytes = sizeof(ShmRing) + RING_SLOTS * shm->slot_bytes;
+	shm->mapping_bytes = (size_t)num_links * shm->ring_bytes;
+
+	/*
+	* Anonymous shared memory comes zeroed, which is every ring's empty
+	* state, and is inherited by the shards across fork().
+	*/
+	shm->mapping = mmap(NULL, shm->mapping_bytes, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if(shm->mapping == MAP_FAILED){
+		printf("Failed to map shared memory in shm_transport_create().");
+		free(shm);
+		return NULL;
+	}
+	return &shm->base;
+}
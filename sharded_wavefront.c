@@ -0,0 +1,247 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+#include "src/sharded_wavefront.h"
+#include "src/common_affix.h"
+
+/*
+* Tiles never get narrower than this when the columns are spread over the
+* shards (see MIN_TILE_SIZE in wavefront.c).
+*/
+#define MIN_TILE_SIZE 64
+
+#define SCRATCH_ALIGNMENT 64
+
+/*
+* Everything a shard needs, set up by the coordinating process before the
+* fork.
+*/
+typedef struct {
+	const char *str1;
+	const char *str2;
+	size_t len1;
+	size_t len2;
+	int tile_height;
+	int tile_width;
+	int row_blocks;
+	int col_blocks;
+	int num_shards;
+	TileKernel kernel;
+	size_t scratch_size;
+	ShardTransport *transport;
+} ShardPlan;
+
+/*
+* Runs shard s's stripe, in its own process. rows holds the DP row at the
+* top of the current tile row across the stripe, edge the DP column at the
+* left of the next tile (edge[0] being the corner above it): it arrives
+* from shard s - 1 and leaves, as the stripe's right edge, for shard s + 1.
+* Returns -1 on failure.
+*/
+static int run_shard(const ShardPlan *plan, int s){
+	int first = (int)((long)s * plan->col_blocks / plan->num_shards);
+	int last = (int)((long)(s + 1) * plan->col_blocks / plan->num_shards);
+	size_t col_from = (size_t)first * plan->tile_width;
+	size_t col_to = (size_t)last * plan->tile_width;
+	if(col_to > plan->len2){
+		col_to = plan->len2;
+	}
+	size_t kernel_bytes = (plan->scratch_size + SCRATCH_ALIGNMENT - 1) / SCRATCH_ALIGNMENT * SCRATCH_ALIGNMENT;
+	size_t scratch_bytes = kernel_bytes + (plan->tile_height + plan->tile_width + 2) * sizeof(int);
+	scratch_bytes = (scratch_bytes + SCRATCH_ALIGNMENT - 1) / SCRATCH_ALIGNMENT * SCRATCH_ALIGNMENT;
+
+	long *rows = malloc((col_to - col_from + 1) * sizeof(long));
+	long *edge = malloc((plan->tile_height + 1) * sizeof(long));
+	char *scratch = aligned_alloc(SCRATCH_ALIGNMENT, scratch_bytes);
+	if(rows == NULL || edge == NULL || scratch == NULL){
+		printf("Failed to allocate memory in shard %d.", s);
+		free(rows);
+		free(edge);
+		free(scratch);
+		return -1;
+	}
+	int *top = (int*)(scratch + kernel_bytes);
+	int *left = top + plan->tile_width + 1;
+	for(size_t j = 0; j <= col_to - col_from; j++){
+		rows[j] = col_from + j;
+	}
+
+	int status = 0;
+	for(int r = 0; r < plan->row_blocks && status == 0; r++){
+		size_t row_offset = (size_t)r * plan->tile_height;
+		int height = (row_offset + plan->tile_height > plan->len1)
+		? (int)(plan->len1 - row_offset) : plan->tile_height;
+		size_t edge_bytes = (height + 1) * sizeof(long);
+		if(s == 0){
+			for(int i = 0; i <= height; i++){
+				edge[i] = row_offset + i;
+			}
+		}
+		else if(plan->transport->receive(plan->transport, s - 1, edge, edge_bytes) != 0){
+			status = -1;
+			break;
+		}
+
+		/*
+		* Same as run_wide_tile() in wavefront.c: every value in a tile is
+		* within height + width of its corner, so the kernel runs on int
+		* copies relative to it.
+		*/
+		for(int c = first; c < last; c++){
+			size_t col_offset = (size_t)c * plan->tile_width;
+			size_t local = col_offset - col_from;
+			int width = (col_offset + plan->tile_width > plan->len2)
+			? (int)(plan->len2 - col_offset) : plan->tile_width;
+			long corner = edge[0];
+			long next_corner = rows[local + width];
+			for(int j = 1; j <= width; j++){
+				top[j] = (int)(rows[local + j] - corner);
+			}
+			for(int i = 1; i <= height; i++){
+				left[i] = (int)(edge[i] - corner);
+			}
+			plan->kernel(top, left, top, left, 0, height, width, plan->str1 + row_offset,
+				plan->str2 + col_offset, scratch);
+			for(int j = 1; j <= width; j++){
+				rows[local + j] = top[j] + corner;
+			}
+			for(int i = 1; i <= height; i++){
+				edge[i] = left[i] + corner;
+			}
+			edge[0] = next_corner;
+		}
+
+		if(s < plan->num_shards - 1){
+			status = plan->transport->send(plan->transport, s, edge, edge_bytes);
+		}
+	}
+
+	/*
+	* The last shard hands the bottom-right cell to the coordinator.
+	*/
+	if(status == 0 && s == plan->num_shards - 1){
+		long result = rows[col_to - col_from];
+		status = plan->transport->send(plan->transport, s, &result, sizeof(long));
+	}
+	free(rows);
+	free(edge);
+	free(scratch);
+	return status;
+}
+
+/*
+* Forks the shards into one process group, so they can be waited for (and
+* killed) together without touching the caller's other children.
+* Returns -1 if any shard failed.
+*/
+static int run_shards(const ShardPlan *plan){
+	fflush(stdout);
+	pid_t group = 0;
+	int started = 0;
+	int status = 0;
+	for(int s = 0; s < plan->num_shards; s++){
+		pid_t pid = fork();
+		if(pid == 0){
+			setpgid(0, group);
+			// Nothing would wake a shard blocked on the transport otherwise
+			prctl(PR_SET_PDEATHSIG, SIGKILL);
+			int shard_status = run_shard(plan, s);
+			fflush(stdout);
+			_exit(shard_status == 0 ? 0 : 1);
+		}
+		if(pid < 0){
+			printf("Failed to start shard %d in sharded_edit_distance_rect().", s);
+			status = -1;
+			break;
+		}
+		// Also set here, so the group exists whichever process runs first
+		setpgid(pid, group);
+		if(group == 0){
+			group = pid;
+		}
+		started++;
+	}
+	if(status != 0 && started > 0){
+		kill(-group, SIGKILL);
+	}
+
+	/*
+	* A shard that fails leaves its neighbours blocked on the transport,
+	* so the first failure takes the whole group down.
+	*/
+	for(int s = 0; s < started; s++){
+		int exit_status;
+		if(waitpid(-group, &exit_status, 0) < 0){
+			status = -1;
+			break;
+		}
+		if(!WIFEXITED(exit_status) || WEXITSTATUS(exit_status) != 0){
+			if(status == 0){
+				kill(-group, SIGKILL);
+			}
+			status = -1;
+		}
+	}
+	return status;
+}
+
+long sharded_edit_distance_rect(const char *str1, size_t len1, const char *str2, size_t len2,
+	long num_shards, int block_size, TileKernel kernel, size_t scratch_size,
+	const WavefrontOptions *options, ShardTransportCreate create_transport){
+	strip_common_affixes(&str1, &len1, &str2, &len2, NULL, NULL);
+	if(len1 < 1 || len2 < 1){
+		return (long)((len1 > len2) ? len1 : len2);
+	}
+	if(num_shards < 1){
+		num_shards = 1;
+	}
+
+	ShardPlan plan;
+	plan.str1 = str1;
+	plan.str2 = str2;
+	plan.len1 = len1;
+	plan.len2 = len2;
+	plan.tile_height = block_size;
+	plan.tile_width = block_size;
+	if(options != NULL && options->tile_height > 0 && options->tile_height < block_size){
+		plan.tile_height = options->tile_height;
+	}
+	if(options != NULL && options->tile_width > 0 && options->tile_width < block_size){
+		plan.tile_width = options->tile_width;
+	}
+
+	/*
+	* Every shard needs at least one tile column.
+	*/
+	size_t stripe = (len2 + num_shards - 1) / num_shards;
+	if(stripe < (size_t)plan.tile_width){
+		plan.tile_width = (stripe > MIN_TILE_SIZE) ? (int)stripe : MIN_TILE_SIZE;
+	}
+	plan.row_blocks = (len1 + plan.tile_height - 1) / plan.tile_height;
+	plan.col_blocks = (len2 + plan.tile_width - 1) / plan.tile_width;
+	plan.num_shards = (num_shards < plan.col_blocks) ? (int)num_shards : plan.col_blocks;
+	plan.kernel = kernel;
+	plan.scratch_size = scratch_size;
+
+	if(create_transport == NULL){
+		create_transport = shm_transport_create;
+	}
+	plan.transport = create_transport(plan.num_shards, (plan.tile_height + 1) * sizeof(long));
+	if(plan.transport == NULL){
+		return -1;
+	}
+
+	long result = -1;
+	if(run_shards(&plan) == 0
+		&& plan.transport->receive(plan.transport, plan.num_shards - 1, &result, sizeof(long)) != 0){
+		result = -1;
+	}
+	plan.transport->destroy(plan.transport);
+	return result;
+}
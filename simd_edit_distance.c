@@ -0,0 +1,38 @@
+#include <stdlib.h>
+#include "src/simd_edit_distance.h"
+#include "src/cpu_features.h"
+#include "src/parallelized_edit_distance.h"
+#include "src/sse41_edit_distance.h"
+#include "src/avx2_edit_distance.h"
+#include "src/avx512_edit_distance.h"
+
+long simd_edit_distance_rect(const char *str1, size_t len1, const char *str2, size_t len2,
+	long num_threads, const WavefrontOptions *options){
+	switch(cpu_simd_level()){
+		case SIMD_LEVEL_AVX512:
+			return avx512_edit_distance_rect(str1, len1, str2, len2, num_threads, options);
+		case SIMD_LEVEL_AVX2:
+			return avx2_edit_distance_rect(str1, len1, str2, len2, num_threads, options);
+		case SIMD_LEVEL_SSE41:
+			return sse41_edit_distance_rect(str1, len1, str2, len2, num_threads, options);
+		default:
+			return parallelized_edit_distance_rect(str1, len1, str2, len2, num_threads, options);
+	}
+}
+
+long simd_edit_distance_opts(const char *str1, const char *str2, size_t len, long num_threads, const WavefrontOptions *options){
+	return simd_edit_distance_rect(str1, len, str2, len, num_threads, options);
+}
+
+long simd_edit_distance(const char *str1, const char *str2, size_t len, long num_threads){
+	return simd_edit_distance_opts(str1, str2, len, num_threads, NULL);
+}
+
+int simd_edit_distance_bounded(const char *str1, const char *str2, size_t len, long num_threads, int k){
+	WavefrontOptions options = {WAVEFRONT_SCHEDULE_DATAFLOW, NULL, 1, k};
+	return simd_edit_distance_opts(str1, str2, len, num_threads, &options);
+}
+
+const char *simd_kernel_name(void){
+	return simd_level_name(cpu_simd_level());
+}
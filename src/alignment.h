@@ -0,0 +1,50 @@
+#ifndef ALIGNMENT_H
+#define ALIGNMENT_H
+
+#include <stddef.h>
+
+/*
+* One run of identical edit operations turning str1 into str2:
+* '=' match and 'X' substitution (one character of each string),
+* 'D' deletion (a character of str1 only), 'I' insertion (a character of
+* str2 only).
+*/
+typedef struct {
+	char op;
+	size_t length;
+} EditRun;
+
+/*
+* An optimal alignment of str1 against str2: distance is the number of
+* 'X', 'D' and 'I' operations in runs.
+*/
+typedef struct {
+	long distance;
+	EditRun *runs;
+	size_t num_runs;
+} Alignment;
+
+/*
+* Aligns str1 (len1 characters) against str2 (len2 characters) with
+* Hirschberg's divide and conquer: the split point of every subproblem
+* comes from a forward and a reverse last row (simd_edit_distance_rect()),
+* so memory stays linear in len1 + len2. Large subproblems are split with
+* all num_threads workers computing each row; the small ones they break
+* into are then aligned independently, one per worker at a time.
+* Returns the edit distance and fills alignment (free it with
+* alignment_free()), or -1 if memory could not be allocated.
+*/
+long edit_distance_align(const char *str1, size_t len1, const char *str2, size_t len2,
+	long num_threads, Alignment *alignment);
+
+void alignment_free(Alignment *alignment);
+
+/*
+* Writes the alignment as an extended CIGAR string ("3=1X2I...") into
+* buffer, truncated to size - 1 characters and always terminated if size
+* is not 0. Returns the length of the whole string, so a call with a
+* NULL buffer and size 0 measures it.
+*/
+size_t alignment_cigar(const Alignment *alignment, char *buffer, size_t size);
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef ANCHORED_EDIT_DISTANCE_H
+#define ANCHORED_EDIT_DISTANCE_H
+
+#include <stddef.h>
+#include "wavefront.h"
+
+/*
+* Preprocessing stage in front of an engine, for near-identical pairs.
+* After the common prefix and suffix are stripped (see common_affix.h),
+* str1 is cut into anchor_length-character pieces, and every piece that
+* occurs exactly once in str1 and exactly once in str2 (found by rolling
+* hash, then compared) is a candidate anchor. The longest chain of anchors
+* in the same order in both strings splits the pair into independent
+* sub-problems: the gaps between consecutive anchors, each extended over
+* the exact match around its anchor. The sub-problems run in parallel
+* through the engine, and their distances add up to the cost of the best
+* alignment that keeps every anchor matched, which is an upper bound U on
+* the edit distance:
+* EXACT: U is only used as a bound. The whole (stripped) pair then runs
+* through the engine in bounded mode with max_distance = U, which only
+* computes the band |i - j| <= U and still returns the exact distance.
+* APPROXIMATE: returns U itself. Faster, but it overestimates whenever the
+* optimal alignment does not go through the anchors (an anchor that is a
+* spurious match, e.g. in a repeat that moved).
+*/
+typedef enum {
+	ANCHOR_MODE_EXACT = 0,
+	ANCHOR_MODE_APPROXIMATE
+} AnchorMode;
+
+/*
+* Any of the wavefront engines' rect entry points, e.g.
+* simd_edit_distance_rect() or bitparallel_edit_distance_threads().
+*/
+typedef long (*EditDistanceEngine)(const char *str1, size_t len1, const char *str2, size_t len2,
+	long num_threads, const WavefrontOptions *options);
+
+/*
+* What one anchored_edit_distance() call did. bound is U, or -1 if no
+* anchor was found and the pair ran through the engine as a whole.
+*/
+typedef struct {
+	size_t prefix;
+	size_t suffix;
+	size_t anchors;
+	size_t anchored_chars;	// characters inside the chained anchors, per string
+	size_t subproblems;
+	long bound;
+} AnchorStats;
+
+/*
+* mode: see AnchorMode.
+* anchor_length: piece length; 0 selects ANCHOR_DEFAULT_LENGTH. Shorter
+* pieces find more anchors but are more often repeated or spurious.
+* engine: NULL selects simd_edit_distance_rect().
+* stats: optional, filled in after the call.
+*/
+typedef struct {
+	AnchorMode mode;
+	size_t anchor_length;
+	EditDistanceEngine engine;
+	AnchorStats *stats;
+} AnchorOptions;
+
+#define ANCHOR_DEFAULT_LENGTH 32
+
+/*
+* Edit distance of str1 and str2 on num_threads threads (exact unless
+* options asks for ANCHOR_MODE_APPROXIMATE). options may be NULL, which
+* selects the defaults above.
+* Returns -1 if memory could not be allocated.
+*/
+long anchored_edit_distance(const char *str1, size_t len1, const char *str2, size_t len2,
+	long num_threads, const AnchorOptions *options);
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef APPROXIMATE_SEARCH_H
+#define APPROXIMATE_SEARCH_H
+
+#include <stddef.h>
+
+/*
+* Approximate substring search: every position where the pattern occurs
+* in the text within k edits. This is the semi-global form of the DP (row
+* 0 all zeros, so a match may start anywhere in the text), run with the
+* bit-parallel column of bitparallel_edit_distance.c along the text.
+*
+* A hit is reported for every text position a match can end at: end is
+* the offset just past the match's last character and distance the
+* smallest number of edits of any match ending there.
+*/
+typedef struct {
+	size_t end;
+	int distance;
+} SearchHit;
+
+/*
+* Receives the hits in increasing order of end.
+*/
+typedef void (*SearchHitCallback)(const SearchHit *hit, void *user);
+
+/*
+* Streaming search: the text arrives in chunks of any size through
+* approximate_search_feed(), and the DP column is carried from one chunk
+* to the next, so matches spanning a chunk boundary are found like any
+* other. Ends are offsets into the whole stream.
+*/
+typedef struct ApproximateSearch ApproximateSearch;
+
+/*
+* Returns NULL if the pattern is empty or memory could not be allocated.
+*/
+ApproximateSearch *approximate_search_create(const char *pattern, size_t len, int k);
+
+/*
+* Scans the next len characters of the stream and reports their hits.
+* Returns the number of hits, or -1 if memory could not be allocated.
+*/
+long approximate_search_feed(ApproximateSearch *search, const char *text, size_t len,
+	SearchHitCallback callback, void *user);
+
+void approximate_search_free(ApproximateSearch *search);
+
+/*
+* One-shot search of a whole text on num_threads threads. The text is cut
+* into one piece per thread, and every piece starts scanning len + k
+* characters early: a match within k edits is at most that long, so its
+* hit comes out exactly as in a single scan.
+* Returns the number of hits, or -1 if the pattern is empty or memory
+* could not be allocated.
+*/
+long approximate_search(const char *pattern, size_t len, const char *text, size_t text_len,
+	int k, long num_threads, SearchHitCallback callback, void *user);
+
+#endif
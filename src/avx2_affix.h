@@ -0,0 +1,13 @@
+#ifndef AVX2_AFFIX_H
+#define AVX2_AFFIX_H
+
+#include <stddef.h>
+
+/*
+* AVX2 part of common_affix.h: 32 characters per compare. Only call on
+* CPUs with AVX2.
+*/
+size_t avx2_common_prefix(const char *str1, const char *str2, size_t len);
+size_t avx2_common_suffix(const char *str1, const char *str2, size_t len);
+
+#endif
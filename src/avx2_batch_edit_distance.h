@@ -0,0 +1,29 @@
+#ifndef AVX2_BATCH_EDIT_DISTANCE_H
+#define AVX2_BATCH_EDIT_DISTANCE_H
+
+#include <stddef.h>
+#include "batch_edit_distance.h"
+
+/*
+* Inter-sequence AVX2 kernels behind edit_distance_batch(). Each call
+* computes up to AVX2_BATCH_LANES_16 (resp. _32) pairs at once, one pair
+* per vector lane, in lockstep over the largest pair's DP matrix. Every
+* pair must have len1 >= len2 >= 1, and the 16-bit kernel needs
+* len1 <= AVX2_BATCH_MAX_LENGTH_16. results[l] receives the distance of
+* pairs[l]. Only call on CPUs with AVX2.
+*/
+#define AVX2_BATCH_LANES_16 16
+#define AVX2_BATCH_LANES_32 8
+#define AVX2_BATCH_MAX_LENGTH_16 32000
+
+void avx2_batch_lanes_16(const EditPair *pairs, int count, int *results, void *scratch);
+
+void avx2_batch_lanes_32(const EditPair *pairs, int count, int *results, void *scratch);
+
+/*
+* Bytes of scratch either kernel needs for pairs of at most max_len1 x
+* max_len2 characters with the given number of lanes.
+*/
+size_t avx2_batch_scratch_size(size_t max_len1, size_t max_len2, int lanes);
+
+#endif
@@ -1,3 +1,56 @@
 #include <stddef.h>
+#include "wavefront.h"
+#include "shard_transport.h"
 
-int avx2_edit_distance(const char *str1, const char *str2, size_t len, long num_threads);
\ No newline at end of file
+/*
+* Lane width of the AVX2 tile kernel. AVX2_LANES_32 stores absolute int
+* scores (8 cells per vector), AVX2_LANES_16 stores scores relative to the
+* tile corner (16 cells per vector) and AVX2_LANES_8 stores the +-1
+* differences between neighboring cells (32 cells per vector). All three
+* are exact.
+*/
+typedef enum {
+	AVX2_LANES_32 = 32,
+	AVX2_LANES_16 = 16,
+	AVX2_LANES_8 = 8
+} Avx2Lanes;
+
+/*
+* Uses the 8-bit difference-encoded kernel.
+*/
+long avx2_edit_distance(const char *str1, const char *str2, size_t len, long num_threads);
+
+/*
+* Same as avx2_edit_distance(), with an explicit tile schedule and
+* optional run statistics (see wavefront.h).
+*/
+long avx2_edit_distance_opts(const char *str1, const char *str2, size_t len, long num_threads, const WavefrontOptions *options);
+
+/*
+* Same as avx2_edit_distance_opts(), with an explicit kernel lane width.
+* Returns -1 for an unsupported width.
+*/
+long avx2_edit_distance_lanes(const char *str1, const char *str2, size_t len, long num_threads,
+	Avx2Lanes lanes, const WavefrontOptions *options);
+
+/*
+* Strings of different lengths: str1 has len1 characters, str2 has len2.
+* Uses the 8-bit kernel; options may be NULL.
+*/
+long avx2_edit_distance_rect(const char *str1, size_t len1, const char *str2, size_t len2,
+	long num_threads, const WavefrontOptions *options);
+
+/*
+* Same as avx2_edit_distance_rect(), with the tile columns split over
+* num_shards worker processes instead of threads (see sharded_wavefront.h).
+* create_transport may be NULL for the shared-memory ring.
+*/
+long avx2_edit_distance_sharded(const char *str1, size_t len1, const char *str2, size_t len2,
+	long num_shards, const WavefrontOptions *options, ShardTransportCreate create_transport);
+
+/*
+* Threshold-bounded variant: only the diagonal band |i - j| <= k is
+* computed, tiles entirely outside it are skipped. Returns the distance if
+* it is at most k, and k + 1 otherwise (as soon as that is known).
+*/
+int avx2_edit_distance_bounded(const char *str1, const char *str2, size_t len, long num_threads, int k);
@@ -0,0 +1,18 @@
+#ifndef AVX2_SEARCH_H
+#define AVX2_SEARCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+* AVX2 part of approximate_search.c: advances four single-word columns,
+* one per 64-bit lane, lane l over lane_text[l][from, count), with no
+* delta entering at the top. pv, mv and score hold the four columns and
+* are updated in place. Stops after the first character where some lane's
+* score is within k and returns its index, or count if there is none.
+* Only call on CPUs with AVX2.
+*/
+size_t avx2_search_lanes(const uint64_t *peq, int last_bit, long k, uint64_t *pv, uint64_t *mv,
+	long *score, const unsigned char *const *lane_text, size_t from, size_t count);
+
+#endif
@@ -0,0 +1,13 @@
+#include <stddef.h>
+#include "wavefront.h"
+
+/*
+* AVX-512BW/VL engine (64 cells per vector). Only call on CPUs that
+* support it, or go through simd_edit_distance(), which checks.
+*/
+long avx512_edit_distance(const char *str1, const char *str2, size_t len, long num_threads);
+
+long avx512_edit_distance_opts(const char *str1, const char *str2, size_t len, long num_threads, const WavefrontOptions *options);
+
+long avx512_edit_distance_rect(const char *str1, size_t len1, const char *str2, size_t len2,
+	long num_threads, const WavefrontOptions *options);
@@ -0,0 +1,66 @@
+#ifndef BATCH_EDIT_DISTANCE_H
+#define BATCH_EDIT_DISTANCE_H
+
+#include <stddef.h>
+#include "ed_context.h"
+
+/*
+* One pair of strings for edit_distance_batch(). The strings do not need
+* to be NUL-terminated.
+*/
+typedef struct {
+	const char *str1;
+	size_t len1;
+	const char *str2;
+	size_t len2;
+} EditPair;
+
+/*
+* Computes the edit distance of every pair and stores it in results[i].
+* Meant for many short pairs, where the single-pair engines have nothing to
+* parallelize: pairs are sorted by length, packed one pair per SIMD lane
+* (16 lanes of 16-bit scores, or 8 lanes of 32-bit scores for pairs too
+* long for 16 bits) and the resulting groups are spread over num_threads
+* threads. Falls back to one pair at a time on CPUs without AVX2.
+* Each pair loses its common prefix and suffix before it is sized, so
+* near-identical pairs cost only their differing middle.
+* Results are ints, so len1 + len2 must not exceed INT_MAX for any pair.
+* Returns -1 if memory could not be allocated or a pair is too long, 0
+* otherwise.
+*/
+int edit_distance_batch(const EditPair *pairs, size_t n, int *results, long num_threads);
+
+/*
+* Same as edit_distance_batch(), with the sort buffers and the worker pool
+* taken from context (see ed_context.h) instead of the heap.
+*/
+int edit_distance_batch_ctx(EdContext *context, const EditPair *pairs, size_t n, int *results,
+	long num_threads);
+
+/*
+* Pairs of at least this many cells are large: worth the wavefront
+* engines' tiles and all the threads, one pair at a time.
+*/
+#define EDIT_PAIR_LARGE_CELLS (1 << 20)
+
+int edit_pair_is_large(const EditPair *pair);
+
+/*
+* Computes one pair for edit_pairs_solve() with num_threads threads.
+* Returns a negative value if memory could not be allocated.
+*/
+typedef long (*EditPairSolver)(const EditPair *pair, long num_threads, void *solver_args);
+
+/*
+* Stores solve's answer for every pair in results[i]. Small pairs run one
+* per worker, with one thread each, on a pool of up to num_threads
+* workers; large ones then run one at a time with all num_threads threads.
+* For callers whose pairs vary from tiny to huge, such as filter_cascade()
+* and anchored_edit_distance().
+* Returns -1 if memory could not be allocated or solve failed, 0
+* otherwise.
+*/
+int edit_pairs_solve(const EditPair *pairs, size_t n, long *results, long num_threads,
+	EditPairSolver solve, void *solver_args);
+
+#endif
@@ -0,0 +1,24 @@
+#include <stddef.h>
+#include "wavefront.h"
+
+long bitparallel_edit_distance(const char *str1, const char *str2, size_t len);
+
+/*
+* Threshold-bounded variant: returns the distance if it is at most k, and
+* k + 1 otherwise.
+*/
+int bitparallel_edit_distance_bounded(const char *str1, const char *str2, size_t len, int k);
+
+/*
+* Strings of different lengths: str1 has len1 characters, str2 has len2.
+* The thread count is picked from the matrix size. options may be NULL.
+*/
+long bitparallel_edit_distance_rect(const char *str1, size_t len1, const char *str2, size_t len2,
+	const WavefrontOptions *options);
+
+/*
+* Same as bitparallel_edit_distance_rect(), with an explicit thread count
+* instead of the one picked from the matrix size.
+*/
+long bitparallel_edit_distance_threads(const char *str1, size_t len1, const char *str2, size_t len2,
+	long num_threads, const WavefrontOptions *options);
@@ -0,0 +1,79 @@
+#ifndef BK_TREE_H
+#define BK_TREE_H
+
+#include <stddef.h>
+
+/*
+* Burkhard-Keller tree over a word list, for nearest-neighbour queries
+* under edit distance. Word i of the list is node i and node 0 is the
+* root; every other node hangs off its parent by their distance, and by
+* the triangle inequality only the children whose edge is within r of the
+* query's distance to the parent can hold a word within r of the query.
+*
+* A tree is one flat image (header, nodes, edges, word text) that is
+* identical in memory and on disk, so bk_tree_load() just maps the file.
+* Once built or loaded it is read-only: any number of threads may query
+* the same tree at once.
+*/
+typedef struct BkTree BkTree;
+
+/*
+* One query result: the word's index in the list the tree was built from
+* and its edit distance to the query.
+*/
+typedef struct {
+	size_t index;
+	int distance;
+} BkMatch;
+
+/*
+* Builds a tree over n words. lengths may be NULL for NUL-terminated words.
+* Distances are computed with a bit-parallel (Myers) kernel, one 64-bit
+* word per 64 characters of the word being inserted.
+* Returns NULL if memory could not be allocated, a word is longer than
+* INT_MAX characters or there are more than UINT32_MAX words.
+*/
+BkTree *bk_tree_build(const char *const *words, const size_t *lengths, size_t n);
+
+/*
+* Writes the tree's image to path. Returns -1 on failure, 0 otherwise.
+*/
+int bk_tree_save(const BkTree *tree, const char *path);
+
+/*
+* Maps a file written by bk_tree_save() read-only. The file must have been
+* written on a machine with the same byte order. Returns NULL if it cannot
+* be opened or is not a valid tree.
+*/
+BkTree *bk_tree_load(const char *path);
+
+void bk_tree_free(BkTree *tree);
+
+size_t bk_tree_size(const BkTree *tree);
+
+/*
+* Word index of the tree, and its length in *length. The text is not
+* NUL-terminated.
+*/
+const char *bk_tree_word(const BkTree *tree, size_t index, size_t *length);
+
+/*
+* All words within radius of query, sorted by distance, then index, in a
+* malloc()ed array stored in *matches (free() it). Every distance is only
+* computed up to the radius a node can still matter for.
+* Returns the number of matches, or -1 if memory could not be allocated.
+*/
+long bk_tree_radius(const BkTree *tree, const char *query, size_t len, int radius,
+	BkMatch **matches);
+
+/*
+* The k words closest to query, sorted by distance, then index, in
+* matches[0..k). The search radius shrinks to the k-th best distance as
+* soon as k words have been seen.
+* Returns the number of matches (less than k only if the tree is smaller),
+* or -1 if memory could not be allocated.
+*/
+long bk_tree_top_k(const BkTree *tree, const char *query, size_t len, size_t k,
+	BkMatch *matches);
+
+#endif
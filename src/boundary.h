@@ -0,0 +1,49 @@
+#ifndef BOUNDARY_H
+#define BOUNDARY_H
+
+#include <stddef.h>
+#include <limits.h>
+
+/*
+* The boundary arrays of the tiled engines hold DP values along a whole row
+* or column of the matrix, which reach max(len1, len2). Inside a tile every
+* value is within the tile's side of its corner, so tiles always work in
+* 32-bit (or narrower) scores relative to the corner; only the boundary
+* arrays need 64-bit entries, and only once a string is longer than
+* EDIT_DISTANCE_WIDE_LIMIT. The limit can be lowered at build time
+* (-DEDIT_DISTANCE_WIDE_LIMIT=1000) to exercise the 64-bit path on small
+* inputs.
+*/
+#ifndef EDIT_DISTANCE_WIDE_LIMIT
+#define EDIT_DISTANCE_WIDE_LIMIT INT_MAX
+#endif
+
+/*
+* Largest k (max_distance) the bounded modes work with. Values are capped
+* at k + 1 and the kernels still add 1 to a capped value, which has to fit
+* an int; a larger k is lowered to this one.
+*/
+#define BOUNDED_MAX_DISTANCE (INT_MAX - 2)
+
+static inline int boundary_is_wide(size_t len1, size_t len2){
+	return len1 > (size_t)EDIT_DISTANCE_WIDE_LIMIT || len2 > (size_t)EDIT_DISTANCE_WIDE_LIMIT;
+}
+
+static inline size_t boundary_entry_size(int wide){
+	return wide ? sizeof(long) : sizeof(int);
+}
+
+static inline long boundary_load(const void *bounds, int wide, size_t index){
+	return wide ? ((const long*)bounds)[index] : ((const int*)bounds)[index];
+}
+
+static inline void boundary_store(void *bounds, int wide, size_t index, long value){
+	if(wide){
+		((long*)bounds)[index] = value;
+	}
+	else{
+		((int*)bounds)[index] = (int)value;
+	}
+}
+
+#endif
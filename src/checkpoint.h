@@ -0,0 +1,98 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+* Checkpoint file of a barrier-schedule wavefront run (see checkpoint_path
+* in wavefront.h). After wave w, tile column c has finished down to tile
+* row w - c, so the run can continue from:
+* - the frontier row: under every tile column, the bottom row of its last
+* finished tile (len2 + 1 boundary entries);
+* - the column boundary: for every tile row, the right edge of its last
+* finished tile (len1 + 1 entries);
+* - for every tile row, the corner its next tile needs (row_blocks
+* entries), which the frontier row no longer holds.
+* The file is this header followed by those three arrays, in the
+* boundary entry size of the run (see boundary.h). It is written to
+* <path>.tmp and renamed over path, so a run killed mid-write leaves the
+* previous checkpoint intact. fingerprint ties the file to the strings
+* of the run (see checkpoint_fingerprint()).
+*/
+typedef struct {
+	char magic[8];
+	uint64_t len1;
+	uint64_t len2;
+	uint32_t tile_height;
+	uint32_t tile_width;
+	uint32_t entry_size;
+	uint32_t padding;
+	int64_t wave;	// last completed wave
+	uint64_t fingerprint;
+} CheckpointHeader;
+
+/*
+* Folds len characters of data into hash, for the fingerprint of a run's
+* strings: start from CHECKPOINT_FINGERPRINT_SEED and feed str1, then
+* str2, in order. The pieces of one string may be fed in any split, the
+* result is the same.
+*/
+#define CHECKPOINT_FINGERPRINT_SEED 0xcbf29ce484222325ULL
+
+uint64_t checkpoint_fingerprint(uint64_t hash, const char *data, size_t len);
+
+/*
+* Reads the header of the checkpoint at path. Returns 1 if there is a
+* valid one, 0 if there is no file and -1 if it cannot be read or is not a
+* checkpoint.
+*/
+int checkpoint_read_header(const char *path, CheckpointHeader *header);
+
+/*
+* Holds one snapshot of a run's frontier and writes it out on a
+* background thread, so the workers only stall for the in-memory copy.
+*/
+typedef struct Checkpointer Checkpointer;
+
+/*
+* fingerprint is checkpoint_fingerprint() of the run's strings.
+* Returns NULL if memory or the writer thread could not be set up.
+*/
+Checkpointer *checkpointer_create(const char *path, size_t len1, size_t len2, int tile_height,
+	int tile_width, size_t entry_size, uint64_t fingerprint);
+
+/*
+* Where the three arrays of the snapshot go.
+*/
+char *checkpointer_rows(Checkpointer *checkpointer);
+char *checkpointer_cols(Checkpointer *checkpointer);
+char *checkpointer_corners(Checkpointer *checkpointer);
+
+/*
+* 1 if the previous snapshot has been written and the buffers may be
+* filled again, 0 while the writer is still busy with it.
+*/
+int checkpointer_ready(Checkpointer *checkpointer);
+
+/*
+* Hands the filled snapshot, taken after wave, to the writer.
+*/
+void checkpointer_submit(Checkpointer *checkpointer, long wave);
+
+/*
+* Reads the checkpoint at path into the snapshot buffers. It has to match
+* the lengths, tile shape, entry size and fingerprint the checkpointer
+* was created with, so a checkpoint of other strings is rejected even when
+* their lengths agree. Returns 1 and sets wave if it was loaded, 0 if there is no file
+* and -1 if it does not match or cannot be read.
+*/
+int checkpointer_load(Checkpointer *checkpointer, long *wave);
+
+/*
+* Waits for a write in progress and stops the writer. NULL-safe.
+* Returns the number of checkpoints written, or -1 if any write failed.
+*/
+long checkpointer_destroy(Checkpointer *checkpointer);
+
+#endif
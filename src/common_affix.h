@@ -0,0 +1,28 @@
+#ifndef COMMON_AFFIX_H
+#define COMMON_AFFIX_H
+
+#include <stddef.h>
+
+/*
+* Length of the longest common prefix (suffix) of two len-character
+* strings, compared with AVX2 when the CPU has it and 8 characters at a
+* time otherwise.
+*/
+size_t common_prefix_length(const char *str1, const char *str2, size_t len);
+size_t common_suffix_length(const char *str1, const char *str2, size_t len);
+
+/*
+* Drops the common prefix of the two strings and then the common suffix
+* of what is left, by moving str1 and str2 forward and shortening len1 and
+* len2. This never changes the edit distance: some optimal alignment
+* matches a common first (or last) character to itself. prefix and suffix
+* may be NULL; otherwise they receive the number of characters dropped
+* from each end.
+* Every engine calls this at its entry point: the naive, tiled and
+* wavefront _rect functions (and so every SIMD and bit-parallel engine),
+* the sharded engine, and edit_distance_batch() for each pair.
+*/
+void strip_common_affixes(const char **str1, size_t *len1, const char **str2, size_t *len2,
+	size_t *prefix, size_t *suffix);
+
+#endif
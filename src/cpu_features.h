@@ -0,0 +1,24 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+/*
+* Instruction set levels the tile kernels are built for, from least to
+* most capable.
+*/
+typedef enum {
+	SIMD_LEVEL_SCALAR = 0,
+	SIMD_LEVEL_SSE41,
+	SIMD_LEVEL_AVX2,
+	SIMD_LEVEL_AVX512
+} SimdLevel;
+
+/*
+* Highest level supported by both the CPU (cpuid) and the operating
+* system (xgetbv: the vector registers are saved on context switch).
+* The result is computed once and cached.
+*/
+SimdLevel cpu_simd_level(void);
+
+const char *simd_level_name(SimdLevel level);
+
+#endif
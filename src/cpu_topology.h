@@ -0,0 +1,40 @@
+#ifndef CPU_TOPOLOGY_H
+#define CPU_TOPOLOGY_H
+
+/*
+* Highest CPU number the affinity code handles.
+*/
+#define TOPOLOGY_MAX_CPUS 1024
+
+/*
+* Set of CPUs, laid out like the kernel's affinity bitmask (and glibc's
+* cpu_set_t), so it can go straight to sched_setaffinity().
+*/
+typedef struct {
+	unsigned long bits[TOPOLOGY_MAX_CPUS / (8 * sizeof(unsigned long))];
+} CpuMask;
+
+/*
+* Picks a CPU for each of num_threads workers from the CPUs this process
+* may run on (read from /sys/devices/system/cpu, no libnuma): one thread
+* per physical core first, filling a NUMA node before moving on to the
+* next, and only then the SMT siblings. More threads than CPUs wrap
+* around. Workers are numbered so that the ones on the same node have
+* consecutive ids; cpus[t] and nodes[t] receive worker t's CPU and node.
+* Returns the number of nodes used, or -1 if the topology is unavailable.
+*/
+int cpu_topology_place(long num_threads, int *cpus, int *nodes);
+
+/*
+* Pins the calling thread to cpu. Returns -1 on failure.
+*/
+int cpu_pin_current(int cpu);
+
+/*
+* Saves and restores the calling thread's affinity mask. Return -1 on
+* failure.
+*/
+int cpu_mask_get(CpuMask *mask);
+int cpu_mask_set(const CpuMask *mask);
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef ED_CONTEXT_H
+#define ED_CONTEXT_H
+
+#include <stddef.h>
+#include "worker_pool.h"
+
+/*
+* Reusable workspace for repeated calls. It holds an arena for everything a
+* call needs for its own duration (boundary arrays, tile bookkeeping, the
+* tiled engine's rows) and one persistent worker pool per thread count,
+* whose per-thread scratch also stays allocated between calls.
+*
+* Pass it through WavefrontOptions.context (every wavefront engine),
+* tiled_edit_distance_ctx() or edit_distance_batch_ctx(). Once a call of a
+* given size has run, further calls of that size or smaller do no heap
+* allocation at all. A context serves one call at a time.
+*/
+typedef struct EdContext EdContext;
+
+/*
+* Backs the arena with huge pages: explicit ones (MAP_HUGETLB) if the
+* system has some reserved, else transparent huge pages (MADV_HUGEPAGE).
+*/
+#define ED_CONTEXT_HUGE_PAGES 1
+
+/*
+* Sizes the arena up front for inputs of up to max_len characters per
+* string (longer ones still work, the arena grows on the first such call)
+* and allows up to num_threads workers per call. flags: 0 or
+* ED_CONTEXT_HUGE_PAGES. Returns NULL if memory could not be allocated.
+*/
+EdContext *ed_context_create(size_t max_len, long num_threads, int flags);
+
+void ed_context_destroy(EdContext *context);
+
+/*
+* Number of times the context has had to get memory or threads from the
+* system so far (arena regions, worker pools). Stays constant across
+* repeated calls once it is warm.
+*/
+size_t ed_context_allocations(const EdContext *context);
+
+/*
+* For the engines. ed_context_reset() starts a call and releases every
+* arena block of the previous one at once (growing the arena if that call
+* overflowed it). ed_context_alloc() returns 64-byte aligned memory that is
+* valid until the next reset, not zeroed, or NULL.
+*/
+void ed_context_reset(EdContext *context);
+void *ed_context_alloc(EdContext *context, size_t bytes);
+
+/*
+* Per-call memory for engines that take an optional context: from its
+* arena when context is not NULL, else from malloc() (zeroed: calloc()).
+* ed_context_free_if_heap() frees the heap case and does nothing for arena
+* blocks, which the next reset releases.
+*/
+void *ed_context_alloc_or_malloc(EdContext *context, size_t bytes);
+void *ed_context_alloc_zeroed_or_calloc(EdContext *context, size_t count, size_t size);
+void ed_context_free_if_heap(EdContext *context, void *block);
+
+/*
+* The context's pool of min(num_threads, its thread limit) workers,
+* created on first use. NULL if it could not be started.
+*/
+WorkerPool *ed_context_pool(EdContext *context, long num_threads);
+
+/*
+* CPU placement (see cpu_topology_place()) for that pool, computed on first
+* use. Returns -1 if the topology is unavailable.
+*/
+int ed_context_placement(EdContext *context, long num_threads, const int **cpus, const int **nodes);
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef FILTER_CASCADE_H
+#define FILTER_CASCADE_H
+
+#include <stddef.h>
+#include "batch_edit_distance.h"
+
+/*
+* Cheap lower bounds on the edit distance, applied in increasing order of
+* cost in front of the bounded engines, for "is the distance at most k?"
+* questions over many candidate pairs:
+* LENGTH: |len1 - len2|.
+* HISTOGRAM: (sum over all characters of |count in str1 - count in str2|
+* + |len1 - len2|) / 2. Long pairs are counted into four interleaved
+* 64-bit sub-histograms (scalar code, as is the rest of the cascade).
+* QGRAM: a pair within k shares at least max(len1, len2) - q + 1 - k * q
+* of its q-grams (counted with multiplicity, hashed into buckets, which
+* can only raise the count), for the largest q from 4 down to 2 that
+* leaves this bound positive. The table takes about 8 bytes per character
+* of str1, and str1 past 8M characters skips this stage.
+* A pair no bound rules out is NONE and goes to the DP.
+*/
+typedef enum {
+	FILTER_STAGE_NONE = 0,
+	FILTER_STAGE_LENGTH,
+	FILTER_STAGE_HISTOGRAM,
+	FILTER_STAGE_QGRAM
+} FilterStage;
+
+/*
+* Per-stage accounting of one filter_cascade() call: every candidate is
+* either rejected by exactly one filter or computed.
+*/
+typedef struct {
+	size_t candidates;
+	size_t length_rejected;
+	size_t histogram_rejected;
+	size_t qgram_rejected;
+	size_t computed;
+	size_t accepted;	// computed and within k
+} FilterStats;
+
+/*
+* Runs the filters on one pair and returns the first stage that proves
+* the distance exceeds k, or FILTER_STAGE_NONE.
+*/
+FilterStage filter_cascade_check(const char *str1, size_t len1, const char *str2, size_t len2, int k);
+
+/*
+* For every pair, results[i] is its distance if that is at most k, and
+* k + 1 otherwise. Rejected pairs never reach the DP; the survivors run
+* through the banded naive engine on num_threads threads, or, from
+* EDIT_PAIR_LARGE_CELLS (see batch_edit_distance.h) cells on, one at a
+* time through simd_edit_distance_rect() in bounded mode with all
+* num_threads threads. k above BOUNDED_MAX_DISTANCE (see
+* boundary.h) is lowered to it. stats may be NULL.
+* Returns -1 if memory could not be allocated, 0 otherwise.
+*/
+int filter_cascade(const EditPair *pairs, size_t n, int k, int *results, long num_threads,
+	FilterStats *stats);
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef INCREMENTAL_EDIT_DISTANCE_H
+#define INCREMENTAL_EDIT_DISTANCE_H
+
+#include <stddef.h>
+
+/*
+* Edit distance of a fixed str1 against a str2 that keeps changing. str1
+* is preprocessed once into match masks, and the object keeps the last DP
+* column (D[0..len1][len2], as the bit-parallel deltas of
+* bitparallel_edit_distance.c) together with a copy of str2. Every
+* checkpoint_every columns it also keeps that column, so:
+* - appending m characters computes only the m new columns;
+* - an edit at offset p restarts from the last checkpoint at or before p
+* and recomputes the columns from there to the end.
+* Each column costs len1 / 64 word operations, and a checkpoint takes
+* len1 / 4 bytes.
+*/
+typedef struct IncrementalDistance IncrementalDistance;
+
+/*
+* str2 starts out empty. checkpoint_every 0 keeps no checkpoints but
+* column 0, so every edit restarts from the beginning.
+* Returns NULL if memory could not be allocated.
+*/
+IncrementalDistance *incremental_create(const char *str1, size_t len1, size_t checkpoint_every);
+
+/*
+* Appends len characters to str2. Returns the distance from str1 to the
+* new str2, or -1 if memory could not be allocated (the object is then
+* left as it was).
+*/
+long incremental_append(IncrementalDistance *incremental, const char *text, size_t len);
+
+/*
+* Replaces the removed characters of str2 starting at offset with the
+* len characters of text (an insertion if removed is 0, a deletion if len
+* is 0). offset + removed must not run past the end of str2.
+* Returns the distance from str1 to the new str2, or -1 if the range is
+* invalid or memory could not be allocated (the object is then left as
+* it was).
+*/
+long incremental_edit(IncrementalDistance *incremental, size_t offset, size_t removed,
+	const char *text, size_t len);
+
+long incremental_distance(const IncrementalDistance *incremental);
+
+/*
+* The current str2 and its length.
+*/
+const char *incremental_text(const IncrementalDistance *incremental);
+size_t incremental_length(const IncrementalDistance *incremental);
+
+/*
+* Columns computed since the object was created, to check that updates
+* cost what they should.
+*/
+size_t incremental_columns_computed(const IncrementalDistance *incremental);
+
+void incremental_free(IncrementalDistance *incremental);
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef MAPPED_INPUT_H
+#define MAPPED_INPUT_H
+
+#include <stddef.h>
+
+/*
+* A string stored in pieces inside a larger buffer, e.g. the sequence lines
+* of a FASTA file without their newlines and headers. Piece k holds the
+* string's characters [starts[k], starts[k + 1]) at data + offsets[k];
+* starts[num_pieces] is the string's length.
+*
+* The wavefront engines read such a string through
+* WavefrontOptions.segments1/segments2, copying only the characters of the
+* tile they are about to run.
+*/
+typedef struct SegmentMap {
+	const char *data;
+	size_t *starts;
+	size_t *offsets;
+	size_t num_pieces;
+} SegmentMap;
+
+/*
+* An input file mapped read-only. text points straight into the mapping
+* when the characters are contiguous (always, unless stripping left more
+* than one piece) and is NULL otherwise; map describes them either way.
+*/
+typedef struct {
+	const char *text;
+	size_t length;
+	SegmentMap map;
+	void *mapping;
+	size_t mapping_size;
+} MappedInput;
+
+/*
+* STRIP: drop line breaks ("\n", "\r\n") and FASTA header and comment
+* lines (starting with '>' or ';'), so the string is the concatenated
+* sequence of every record. Without it the file is taken as is, minus one
+* trailing line break.
+* HUGE_PAGES: ask for transparent huge pages on the mapping (a hint, only
+* honoured by file systems that support it).
+*/
+#define MAPPED_INPUT_STRIP 1
+#define MAPPED_INPUT_HUGE_PAGES 2
+
+/*
+* Maps path read-only (MADV_SEQUENTIAL) and builds its segment map in one
+* pass. Returns 0, or -1 if the file could not be opened, mapped or
+* indexed.
+*/
+int mapped_input_open(const char *path, int flags, MappedInput *input);
+
+void mapped_input_close(MappedInput *input);
+
+/*
+* Copies characters [from, from + count) of the string map describes to
+* out.
+*/
+void segment_map_copy(const SegmentMap *map, size_t from, size_t count, char *out);
+
+#endif
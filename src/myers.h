@@ -0,0 +1,33 @@
+#ifndef MYERS_H
+#define MYERS_H
+
+#include <stdint.h>
+
+/*
+* Advances one 64-row block of the DP column by one character of the text
+* (Myers 1999, with Hyyro's carry between blocks).
+* pv/mv hold the vertical +1/-1 deltas of the block, eq the match mask of
+* the current text character and hin the horizontal delta entering at the
+* top of the block. Returns the horizontal delta leaving at row high_bit,
+* which is the block's last row.
+*/
+static inline int myers_advance_block(uint64_t *pv, uint64_t *mv, uint64_t eq, int hin, int high_bit){
+	uint64_t hin_neg = (hin < 0);
+	uint64_t hin_pos = (hin > 0);
+
+	uint64_t xv = eq | *mv;
+	eq |= hin_neg;
+	uint64_t xh = (((eq & *pv) + *pv) ^ *pv) | eq;
+	uint64_t ph = *mv | ~(xh | *pv);
+	uint64_t mh = *pv & xh;
+
+	int hout = (int)((ph >> high_bit) & 1) - (int)((mh >> high_bit) & 1);
+
+	ph = (ph << 1) | hin_pos;
+	mh = (mh << 1) | hin_neg;
+	*pv = mh | ~(xv | ph);
+	*mv = ph & xv;
+	return hout;
+}
+
+#endif
@@ -1,3 +1,21 @@
 #include <stddef.h>
 
-int naive_edit_distance(const char *str1, const char *str2, size_t len);
\ No newline at end of file
+long naive_edit_distance(const char *str1, const char *str2, size_t len);
+
+/*
+* Strings of different lengths: str1 has len1 characters, str2 has len2.
+*/
+long naive_edit_distance_rect(const char *str1, size_t len1, const char *str2, size_t len2);
+
+/*
+* Threshold-bounded variant: only the diagonal band |i - j| <= k is
+* computed. Returns the distance if it is at most k, and k + 1 otherwise
+* (as soon as a whole row of the band exceeds k). k above
+* BOUNDED_MAX_DISTANCE (see boundary.h) is lowered to it.
+*/
+int naive_edit_distance_bounded(const char *str1, const char *str2, size_t len, int k);
+
+/*
+* Threshold-bounded variant for strings of different lengths.
+*/
+int naive_edit_distance_rect_bounded(const char *str1, size_t len1, const char *str2, size_t len2, int k);
\ No newline at end of file
@@ -1,3 +1,24 @@
 #include <stddef.h>
+#include "wavefront.h"
 
-int parallelized_edit_distance(const char *str1, const char *str2, size_t len, long num_threads);
\ No newline at end of file
+long parallelized_edit_distance(const char *str1, const char *str2, size_t len, long num_threads);
+
+/*
+* Same as parallelized_edit_distance(), with an explicit tile schedule and
+* optional run statistics (see wavefront.h).
+*/
+long parallelized_edit_distance_opts(const char *str1, const char *str2, size_t len, long num_threads, const WavefrontOptions *options);
+
+/*
+* Strings of different lengths: str1 has len1 characters, str2 has len2.
+* options may be NULL.
+*/
+long parallelized_edit_distance_rect(const char *str1, size_t len1, const char *str2, size_t len2,
+	long num_threads, const WavefrontOptions *options);
+
+/*
+* Threshold-bounded variant: only the diagonal band |i - j| <= k is
+* computed, tiles entirely outside it are skipped. Returns the distance if
+* it is at most k, and k + 1 otherwise (as soon as that is known).
+*/
+int parallelized_edit_distance_bounded(const char *str1, const char *str2, size_t len, long num_threads, int k);
\ No newline at end of file
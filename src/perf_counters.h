@@ -0,0 +1,106 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdint.h>
+
+/*
+* Optional hardware counter instrumentation based on perf_event_open().
+* It is only built with -DEDIT_DISTANCE_PERF (make PERF=1). Otherwise
+* every hook below is an empty inline function and the engines compile
+* exactly as without it.
+*
+* perf_report_begin() makes a report active. Every worker of the runs that
+* follow counts its own thread between perf_thread_begin() and
+* perf_thread_end(), and, if the report asked for it, each tile between
+* perf_tile_begin() and perf_tile_end(). perf_report_end() stops
+* collecting. Only one report can be active at a time, and it must not
+* change while an engine is running.
+*/
+typedef enum {
+	PERF_TASK_CLOCK,	// ns the thread was on a CPU (software counter)
+	PERF_CYCLES,
+	PERF_INSTRUCTIONS,
+	PERF_L1D_MISSES,	// L1 data cache read misses
+	PERF_LLC_MISSES,
+	PERF_BRANCH_MISSES,
+	PERF_NUM_COUNTERS
+} PerfCounter;
+
+/*
+* Threads with a larger id are not counted individually.
+*/
+#define PERF_MAX_THREADS 64
+
+typedef struct {
+	uint64_t value[PERF_NUM_COUNTERS];
+} PerfSample;
+
+typedef struct {
+	int per_tile;
+	/*
+	* Bit c is set if counter c could be opened. Hardware counters are
+	* missing in most VMs and containers, or when perf_event_paranoid
+	* forbids them.
+	*/
+	unsigned available;
+	long num_threads;	// highest thread id seen + 1
+	PerfSample total;
+	PerfSample thread[PERF_MAX_THREADS];
+	/*
+	* Counts inside the tile calls only (per_tile), and number of calls
+	*/
+	PerfSample tile[PERF_MAX_THREADS];
+	long tile_calls[PERF_MAX_THREADS];
+} PerfReport;
+
+/*
+* Per-thread state of a worker, kept on its stack.
+*/
+typedef struct {
+	PerfReport *report;
+	int fd;		// group leader
+	int fds[PERF_NUM_COUNTERS];
+	int thread_id;
+	unsigned opened;
+	PerfSample start;
+	PerfSample tile_start;
+} PerfThread;
+
+#ifdef EDIT_DISTANCE_PERF
+
+void perf_report_begin(PerfReport *report, int per_tile);
+
+void perf_report_end(void);
+
+const char *perf_counter_name(PerfCounter counter);
+
+void perf_thread_begin(PerfThread *thread, int thread_id);
+
+void perf_thread_end(PerfThread *thread);
+
+void perf_tile_begin(PerfThread *thread);
+
+void perf_tile_end(PerfThread *thread);
+
+#else
+
+static inline void perf_thread_begin(PerfThread *thread, int thread_id){
+	(void)thread;
+	(void)thread_id;
+}
+
+static inline void perf_thread_end(PerfThread *thread){
+	(void)thread;
+}
+
+static inline void perf_tile_begin(PerfThread *thread){
+	(void)thread;
+}
+
+static inline void perf_tile_end(PerfThread *thread){
+	(void)thread;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef SHARD_TRANSPORT_H
+#define SHARD_TRANSPORT_H
+
+#include <stddef.h>
+
+/*
+* Carries boundary segments between the processes of
+* sharded_edit_distance_rect(). Link s runs from shard s to shard s + 1;
+* the last link runs from the last shard back to the coordinating process.
+* Messages on a link arrive in the order they were sent and are at most
+* the message_bytes the transport was created with.
+*
+* A transport is created in the coordinating process before any shard
+* starts, and has to keep working in every process forked off after that.
+* A backend embeds ShardTransport as its first member and fills in the
+* three calls:
+* send: blocks while the link is full. Returns -1 on failure.
+* receive: blocks until a message arrives and copies its bytes out.
+* Returns -1 on failure.
+* destroy: called once, in the coordinating process, after every shard
+* has exited.
+*/
+typedef struct ShardTransport ShardTransport;
+struct ShardTransport {
+	int (*send)(ShardTransport *transport, int link, const void *data, size_t bytes);
+	int (*receive)(ShardTransport *transport, int link, void *data, size_t bytes);
+	void (*destroy)(ShardTransport *transport);
+};
+
+/*
+* Creates a transport with num_links links. Returns NULL on failure.
+*/
+typedef ShardTransport *(*ShardTransportCreate)(int num_links, size_t message_bytes);
+
+/*
+* Single-host backend: every link is a ring of message slots in one shared
+* anonymous mapping. Each side spins briefly on the other's counter and
+* then sleeps on it with a futex, so a shard only enters the kernel when it
+* really has to wait.
+*/
+ShardTransport *shm_transport_create(int num_links, size_t message_bytes);
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef SHARDED_WAVEFRONT_H
+#define SHARDED_WAVEFRONT_H
+
+#include <stddef.h>
+#include "wavefront.h"
+#include "shard_transport.h"
+
+/*
+* Multi-process version of wavefront_edit_distance_rect(), a stand-in for
+* running one computation across several nodes. The tile columns are cut
+* into num_shards contiguous stripes and every stripe is owned by a forked
+* worker process, which runs its tiles one tile row at a time. After a
+* tile row, a shard sends the right edge of its stripe (the column
+* boundary at its last DP column, plus the corner above it) over the
+* transport to the next shard, which needs it as the left edge of the same
+* tile row. The shards are pipelined along the anti-diagonals: shard s
+* works on tile row r while shard s + 1 works on tile row r - 1.
+*
+* The tile shape comes from options (0 uses block_size, capped at it);
+* tiles narrow so that every shard gets at least one tile column. The
+* rest of options is not supported across processes and is ignored.
+* create_transport may be NULL, which selects shm_transport_create().
+* The common prefix and suffix are dropped before the stripes are cut.
+* Boundaries are 64-bit throughout and every tile runs relative to its
+* corner, so any length works.
+* Returns the edit distance, or -1 if a shard failed or memory, processes
+* or the transport could not be set up.
+*/
+long sharded_edit_distance_rect(const char *str1, size_t len1, const char *str2, size_t len2,
+	long num_shards, int block_size, TileKernel kernel, size_t scratch_size,
+	const WavefrontOptions *options, ShardTransportCreate create_transport);
+
+#endif
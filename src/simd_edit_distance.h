@@ -0,0 +1,29 @@
+#include <stddef.h>
+#include "wavefront.h"
+#include "cpu_features.h"
+
+/*
+* Runs the fastest tile kernel this CPU supports: AVX-512BW, AVX2, SSE4.1,
+* or the scalar kernel of parallelized_edit_distance(). The choice is made
+* once, on the first call, from cpuid.
+*/
+long simd_edit_distance(const char *str1, const char *str2, size_t len, long num_threads);
+
+long simd_edit_distance_opts(const char *str1, const char *str2, size_t len, long num_threads, const WavefrontOptions *options);
+
+/*
+* Strings of different lengths: str1 has len1 characters, str2 has len2.
+* options may be NULL.
+*/
+long simd_edit_distance_rect(const char *str1, size_t len1, const char *str2, size_t len2,
+	long num_threads, const WavefrontOptions *options);
+
+/*
+* Threshold-bounded variant (see parallelized_edit_distance_bounded()).
+*/
+int simd_edit_distance_bounded(const char *str1, const char *str2, size_t len, long num_threads, int k);
+
+/*
+* Name of the kernel simd_edit_distance() runs ("avx512", "avx2", ...).
+*/
+const char *simd_kernel_name(void);
@@ -0,0 +1,12 @@
+#include <stddef.h>
+#include "wavefront.h"
+
+/*
+* SSE4.1 engine (16 cells per vector), the fallback for CPUs without AVX2.
+*/
+long sse41_edit_distance(const char *str1, const char *str2, size_t len, long num_threads);
+
+long sse41_edit_distance_opts(const char *str1, const char *str2, size_t len, long num_threads, const WavefrontOptions *options);
+
+long sse41_edit_distance_rect(const char *str1, size_t len1, const char *str2, size_t len2,
+	long num_threads, const WavefrontOptions *options);
@@ -1,16 +1,105 @@
+#ifndef THREADARGUMENTS_H
+#define THREADARGUMENTS_H
+
 #include <stddef.h>
+#include <stdatomic.h>
+#include "worker_pool.h"
+#include "wavefront.h"
+
+typedef struct TileDeque TileDeque;
+struct EdContext;
+struct SegmentMap;
+struct Checkpointer;
 
 /*
 * Struct to hold arguments threads will pass to process_tile()
 */
 typedef struct {
-		int thread_id;
+		WorkerPool *pool;
+		struct EdContext *context;	// NULL: per-call heap memory and pool
 		long num_threads;
-		int current_wave;
-		int num_blocks;
+		int row_blocks;
+		int col_blocks;
+		int tile_height;
+		int tile_width;
+		WavefrontSchedule schedule;
 		int *global_rows[3];
 		int *global_cols;
-		size_t len;
+
+		/*
+		* Wide mode (see boundary.h): the boundaries are the long arrays
+		* below instead, and each tile runs on an int copy of its slices
+		* relative to its corner, wide_offset bytes into the scratch.
+		*/
+		int wide;
+		long *wide_rows[3];
+		long *wide_cols;
+		size_t wide_offset;
+		size_t len1;
+		size_t len2;
 		const char *str1;
 		const char *str2;
-	} ThreadArguments;
\ No newline at end of file
+		TileKernel process_tile;
+
+		/*
+		* Strings in pieces: each tile gathers its characters into the
+		* worker's scratch, gather_offset bytes in (after the kernel's
+		* part). NULL for a plain array.
+		*/
+		const struct SegmentMap *segments1;
+		const struct SegmentMap *segments2;
+		size_t gather_offset;
+
+		/*
+		* Bounded mode: only tiles touching the band |i - j| <= max_distance
+		* run. total_tiles is the number of tiles that will run; row_min and
+		* row_remaining track each tile row for the early exit.
+		*/
+		int bounded;
+		int max_distance;
+		long total_tiles;
+		atomic_int *row_min;
+		atomic_int *row_remaining;
+		atomic_int aborted;
+
+		/*
+		* Dataflow schedule only, all per tile row: row_done[r] is the
+		* column up to which row r has finished (tiles left of the band
+		* count as finished), row_next[r] the next tile of the row to be
+		* released, and row_end[r] one past its last tile in the band.
+		* Then one ready deque per worker and, per tile row, the corner
+		* value the next tile in that row needs.
+		*/
+		atomic_int *row_done;
+		atomic_int *row_next;
+		int *row_end;
+		TileDeque *deques;
+		long *corners;
+		atomic_long tiles_done;
+
+		/*
+		* Pinned mode: tile column c belongs to worker c % num_threads,
+		* and thread_nodes[t] is worker t's NUMA node (NULL otherwise).
+		*/
+		int pinned;
+		int *thread_nodes;
+
+		/*
+		* Barrier schedule checkpoints: after every checkpoint_every-th
+		* wave the workers copy the frontier into the checkpointer's
+		* snapshot, if take_checkpoint[wave % 2] says the writer is done
+		* with the previous one (two slots, since a worker may still be
+		* reading one wave's while thread 0 sets the next one's). A
+		* resumed run starts at first_wave.
+		*/
+		struct Checkpointer *checkpointer;
+		long checkpoint_every;
+		atomic_int take_checkpoint[2];
+		int first_wave;
+
+		// Per-thread accounting, indexed by thread_id
+		double *busy_ms;
+		long *steals;
+	} ThreadArguments;
+
+#endif
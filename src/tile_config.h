@@ -0,0 +1,53 @@
+#ifndef TILE_CONFIG_H
+#define TILE_CONFIG_H
+
+#include <stddef.h>
+#include "wavefront.h"
+
+/*
+* Data cache sizes in bytes (0 if unknown), read from
+* /sys/devices/system/cpu/cpu0/cache.
+*/
+typedef struct {
+	size_t l1d;
+	size_t l2;
+	size_t l3;
+} CacheSizes;
+
+void tile_cache_sizes(CacheSizes *sizes);
+
+/*
+* Tuned tile shapes are kept in a small text file, one line per host and
+* engine:
+*   <host> <engine> <tile height> <tile width> <l1d> <l2> <l3>
+* The file is $EDIT_DISTANCE_TILE_CACHE, else
+* $XDG_CACHE_HOME/edit_distance_tiles, else ~/.cache/edit_distance_tiles.
+* Setting EDIT_DISTANCE_TILE_CACHE to an empty string turns it off.
+* A line only applies if both the host name and the cache sizes match.
+*/
+const char *tile_config_path(void);
+
+/*
+* Tuned shape of engine ("tiled", "parallel", "avx2", ...) on this host.
+* The file is read once, on the first call. Returns 1 and sets the shape
+* if there is one, 0 otherwise.
+*/
+int tile_config_lookup(const char *engine, int *tile_height, int *tile_width);
+
+/*
+* Records the shape of engine for this host, in memory and in the file
+* (the other hosts' lines are kept). Returns -1 if the file could not be
+* written.
+*/
+int tile_config_save(const char *engine, int tile_height, int tile_width);
+
+/*
+* What the engines call on entry: copies options (or the defaults, if it
+* is NULL) into storage and fills in whatever part of the tile shape it
+* leaves at 0, from the tuned shape of engine or else default_size.
+* Returns storage.
+*/
+const WavefrontOptions *tile_config_options(const char *engine, const WavefrontOptions *options,
+	int default_size, WavefrontOptions *storage);
+
+#endif
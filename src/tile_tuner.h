@@ -0,0 +1,37 @@
+#ifndef TILE_TUNER_H
+#define TILE_TUNER_H
+
+#include <stddef.h>
+
+/*
+* Outcome of tuning one engine. gcups are single-threaded.
+*/
+typedef struct {
+	const char *engine;
+	int tile_height;
+	int tile_width;
+	double gcups;
+	int default_size;
+	double default_gcups;
+	int candidates;
+} TileTuneResult;
+
+/*
+* Engines the tuner knows: "tiled", "parallel", "sse41", "avx2",
+* "avx2-16", "avx2-32", "avx512" and "bitparallel". index runs from 0 and
+* NULL ends the list.
+*/
+const char *tile_tune_engine(int index);
+
+/*
+* Times engine on one thread over a len x len random input for every
+* candidate tile shape (square and non-square sides from 64 up to the
+* engine's largest tile or len / 4, skipping shapes whose working set does
+* not fit the L2 cache) and keeps the best of reps runs of each. The
+* winner is only reported; tile_config_save() persists it.
+* Returns -1 for an unknown engine, one the CPU cannot run, or if memory
+* could not be allocated.
+*/
+int tile_tune(const char *engine, size_t len, int reps, TileTuneResult *result);
+
+#endif
@@ -1,3 +1,37 @@
 #include <stddef.h>
+#include "ed_context.h"
 
-int tiled_edit_distance(const char *str1, const char *str2, size_t len);
\ No newline at end of file
+long tiled_edit_distance(const char *str1, const char *str2, size_t len);
+
+/*
+* Strings of different lengths: str1 has len1 characters, str2 has len2.
+*/
+long tiled_edit_distance_rect(const char *str1, size_t len1, const char *str2, size_t len2);
+
+/*
+* Same as tiled_edit_distance_rect() with tiles of tile_height rows of
+* str1 by tile_width columns of str2. A side of 0 uses the tuned shape for
+* this host (see tile_config.h), or 512 if there is none.
+*/
+long tiled_edit_distance_shape(const char *str1, size_t len1, const char *str2, size_t len2,
+	int tile_height, int tile_width);
+
+/*
+* Same as tiled_edit_distance_shape(), with every array taken from context
+* (see ed_context.h) instead of the heap.
+*/
+long tiled_edit_distance_ctx(EdContext *context, const char *str1, size_t len1, const char *str2,
+	size_t len2, int tile_height, int tile_width);
+
+/*
+* Threshold-bounded variant: only tiles that touch the diagonal band
+* |i - j| <= k are computed. Returns the distance if it is at most k, and
+* k + 1 otherwise (as soon as a whole tile row of the band exceeds k).
+* k above BOUNDED_MAX_DISTANCE (see boundary.h) is lowered to it.
+*/
+int tiled_edit_distance_bounded(const char *str1, const char *str2, size_t len, int k);
+
+/*
+* Threshold-bounded variant for strings of different lengths.
+*/
+int tiled_edit_distance_rect_bounded(const char *str1, size_t len1, const char *str2, size_t len2, int k);
\ No newline at end of file
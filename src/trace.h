@@ -0,0 +1,71 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+* Execution trace of the worker threads, written out as Chrome trace
+* event JSON (chrome://tracing, https://ui.perfetto.dev).
+*
+* Every worker appends to its own fixed-size ring buffer, so recording
+* takes no lock. A full ring overwrites its oldest events, and the
+* number of lost events is written with the trace. The hooks cost one
+* pointer check when no run is being traced.
+*/
+typedef enum {
+	TRACE_TILE,		// a = tile row, b = tile column
+	TRACE_BARRIER_WAIT,	// a = wave
+	TRACE_IDLE,		// dataflow worker without a ready tile, a = 1 if it then stole one
+	TRACE_ALLOC		// a = bytes
+} TraceEventType;
+
+/*
+* Most worker threads a trace can hold.
+*/
+#define TRACE_MAX_THREADS 64
+
+/*
+* Runs recorded into one trace (each becomes a process in the viewer).
+*/
+#define TRACE_MAX_RUNS 256
+
+typedef struct Trace Trace;
+
+/*
+* Allocates a ring of events_per_thread events for each of the first
+* num_threads workers; workers with a larger id are not recorded.
+* Returns NULL if the buffers could not be allocated.
+*/
+Trace *trace_create(int num_threads, size_t events_per_thread);
+
+void trace_destroy(Trace *trace);
+
+/*
+* Starts recording a run called name into trace, until trace_end_run().
+* Only one run can be recorded at a time, and it must not start or end
+* while an engine is running. Returns -1 once TRACE_MAX_RUNS is reached.
+*/
+int trace_begin_run(Trace *trace, const char *name);
+
+void trace_end_run(void);
+
+/*
+* Timestamp to pass to trace_record() as the start of an event, or 0 if
+* no run is being recorded.
+*/
+uint64_t trace_now(void);
+
+/*
+* Records an event from start (a trace_now() value) until now on the
+* calling worker's ring. Does nothing if no run is being recorded.
+*/
+void trace_record(int thread_id, TraceEventType type, uint64_t start, long a, long b);
+
+/*
+* Writes every recorded run to path. Returns -1 if the file could not be
+* written.
+*/
+int trace_write_chrome(const Trace *trace, const char *path);
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef WAVEFRONT_H
+#define WAVEFRONT_H
+
+#include <stddef.h>
+
+struct SegmentMap;
+
+/*
+* Signature shared by the per-tile kernels of the parallel engines.
+*
+* top[1..width] holds the DP row just above the tile, left[1..height] the
+* DP column just left of it and corner the cell diagonally above-left.
+* The kernel writes the tile's last row to bottom[1..width] and its last
+* column to right[1..height], and returns the bottom-right cell.
+* s1 and s2 point at the first character of the tile's row and column
+* substrings. bottom may alias top and right may alias left, so a kernel
+* must read its inputs before it writes its outputs.
+*/
+typedef int (*TileKernel)(const int *top, const int *left, int *bottom,
+	int *right, int corner, int height, int width, const char *s1,
+	const char *s2, void *scratch);
+
+/*
+* How tiles are handed out to the workers.
+* DATAFLOW: a tile (r, c) becomes ready as soon as (r-1, c) and (r, c-1) are
+* done; ready tiles sit in per-worker deques and idle workers steal.
+* BARRIER: tiles of one anti-diagonal are split round-robin between the
+* workers, with a barrier after every wave.
+*/
+typedef enum {
+	WAVEFRONT_SCHEDULE_DATAFLOW = 0,
+	WAVEFRONT_SCHEDULE_BARRIER
+} WavefrontSchedule;
+
+/*
+* Where the workers run and their data lives.
+* NONE: wherever the scheduler puts them; the calling thread initializes
+* the boundary arrays.
+* PINNED: every worker is pinned to its own CPU, physical cores first and
+* one NUMA node at a time (see cpu_topology.h). Tile column c belongs to
+* worker c % num_threads in both schedules, and each worker first-touches
+* its scratch and the boundary segments of its own columns, so that data
+* stays on the worker's node from wave to wave.
+*/
+typedef enum {
+	WAVEFRONT_AFFINITY_NONE = 0,
+	WAVEFRONT_AFFINITY_PINNED
+} WavefrontAffinity;
+
+/*
+* Filled in after a run when requested through WavefrontOptions.
+* utilization is busy_ms / (wall_ms * num_threads), i.e. the fraction of
+* the workers' time spent inside tile kernels. checkpoints counts the
+* checkpoints written.
+*/
+typedef struct {
+	double wall_ms;
+	double busy_ms;
+	double utilization;
+	long num_threads;
+	long tiles;
+	long steals;
+	long checkpoints;
+} WavefrontStats;
+
+/*
+* schedule: see WavefrontSchedule.
+* stats: optional, filled in after the run.
+* bounded: when set, only the diagonal band |i - j| <= max_distance is
+* computed and the run returns max_distance + 1 as soon as the distance is
+* known to exceed max_distance. max_distance above BOUNDED_MAX_DISTANCE
+* (see boundary.h) is lowered to it.
+* tile_height, tile_width: tile shape; 0 uses the engine's default (its
+* tuned shape if there is one, see tile_config.h). Capped at the largest
+* tile the engine's kernel supports.
+* affinity: see WavefrontAffinity.
+* context: optional workspace reused across calls (see ed_context.h); the
+* call then takes its memory and workers from it instead of the heap.
+* last_row: optional, receives the matrix's last row (len2 + 1 values:
+* the distance from str1 to every prefix of str2) after an unbounded run.
+* Values are longs, since they reach len1 + len2.
+* segments1, segments2: optional, read str1 (str2) through this map of
+* pieces (see mapped_input.h) instead of as one array, which may then be
+* NULL. Each tile copies just its own characters out of the pieces.
+* checkpoint_path: optional, unbounded runs only, and implies the barrier
+* schedule. Every checkpoint_every waves (0: never) the workers copy the
+* boundaries into a snapshot, which a background thread writes to this
+* file (see checkpoint.h); a checkpoint that comes up while the previous
+* one is still being written is skipped. The file is removed when the run
+* completes.
+* resume: continue from the checkpoint at checkpoint_path, with its tile
+* shape, instead of from wave 0 (from wave 0 if there is none). The
+* strings must be the same as in the run that wrote it.
+*/
+typedef struct {
+	WavefrontSchedule schedule;
+	WavefrontStats *stats;
+	int bounded;
+	int max_distance;
+	int tile_height;
+	int tile_width;
+	WavefrontAffinity affinity;
+	struct EdContext *context;
+	long *last_row;
+	const struct SegmentMap *segments1;
+	const struct SegmentMap *segments2;
+	const char *checkpoint_path;
+	long checkpoint_every;
+	int resume;
+} WavefrontOptions;
+
+/*
+* Runs kernel over the len x len DP matrix in block_size x block_size tiles
+* on a worker pool of num_threads threads. scratch_size is the number of
+* bytes of per-thread scratch the kernel needs. options may be NULL, which
+* selects the dataflow schedule.
+* Kernels always see int values: past EDIT_DISTANCE_WIDE_LIMIT (see
+* boundary.h) the boundaries are kept as longs and every tile gets them
+* relative to its corner.
+* The common prefix and suffix of the strings are dropped first (see
+* common_affix.h), except for runs that ask for last_row or read segment
+* maps.
+* Returns the edit distance, or -1 if memory could not be allocated.
+*/
+long wavefront_edit_distance(const char *str1, const char *str2, size_t len,
+	long num_threads, int block_size, TileKernel kernel, size_t scratch_size,
+	const WavefrontOptions *options);
+
+/*
+* Same as wavefront_edit_distance() for a len1 x len2 matrix (str1 along
+* the rows, str2 along the columns). Tiles are at most block_size on each
+* side, or the smaller shape options asks for; when one string is much
+* shorter than the other, its side is split into narrower tiles so all
+* threads still get work.
+*/
+long wavefront_edit_distance_rect(const char *str1, size_t len1, const char *str2,
+	size_t len2, long num_threads, int block_size, TileKernel kernel,
+	size_t scratch_size, const WavefrontOptions *options);
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <stddef.h>
+
+/*
+* A fixed set of worker threads that is started once and then reused for
+* any number of runs. Each worker keeps its own scratch buffer alive between
+* runs, so tile kernels do not malloc()/free() per wave or per call.
+*/
+typedef struct WorkerPool WorkerPool;
+
+/*
+* Function every worker executes during worker_pool_run().
+* thread_id is in [0, num_threads), scratch is at least the requested
+* number of bytes and 64-byte aligned.
+*/
+typedef void (*WorkerTask)(void *task_args, int thread_id, void *scratch);
+
+/*
+* Starts num_threads - 1 threads; the calling thread acts as worker 0 during
+* worker_pool_run(). Returns NULL if the pool could not be created.
+*/
+WorkerPool *worker_pool_create(long num_threads);
+
+/*
+* Runs task on every worker and returns once all of them have finished.
+* Returns -1 if a worker could not allocate its scratch buffer (in which
+* case task is not run at all), 0 otherwise.
+*/
+int worker_pool_run(WorkerPool *pool, WorkerTask task, void *task_args, size_t scratch_size);
+
+/*
+* Blocks until every worker in the pool has reached the barrier. Only valid
+* from inside a task started by worker_pool_run().
+*/
+void worker_pool_barrier(WorkerPool *pool);
+
+/*
+* Lets idle workers wait for work the same way the barrier waits: take a
+* ticket, look for work, and if there is none call worker_pool_wait(),
+* which spins for a while and then sleeps until worker_pool_notify() has
+* been called since the ticket was taken. Only valid from inside a task.
+*/
+unsigned int worker_pool_work_ticket(WorkerPool *pool);
+
+void worker_pool_wait(WorkerPool *pool, unsigned int ticket);
+
+void worker_pool_notify(WorkerPool *pool);
+
+/*
+* Pins worker t to CPU cpus[t] from its next run on (see cpu_topology.h),
+* or lets every worker run anywhere again if cpus is NULL. Worker 0 is
+* only pinned for the duration of each worker_pool_run().
+*/
+void worker_pool_set_affinity(WorkerPool *pool, const int *cpus);
+
+long worker_pool_size(const WorkerPool *pool);
+
+void worker_pool_destroy(WorkerPool *pool);
+
+#endif
@@ -0,0 +1,140 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdio.h>
+#include <smmintrin.h>
+#include <string.h>
+#include <stdint.h>
+#include "src/sse41_edit_distance.h"
+#include "src/wavefront.h"
+#include "src/tile_config.h"
+
+/*
+* n size for each individual block while tiling.
+*/
+#define BLOCK_SIZE 512
+
+/*
+* Largest tile side accepted at runtime (WavefrontOptions, tuned shapes);
+* sizes the per-thread scratch.
+*/
+#define MAX_TILE_SIZE 2048
+
+/*
+* Cells per vector, also the padding behind every scratch array so the
+* vector loop can always run in whole vectors.
+*/
+#define LANES 16
+
+/*
+* Size of one array of the kernel's scratch.
+*/
+#define LANE_ARRAY (MAX_TILE_SIZE + 1 + LANES)
+
+/*
+* SSE4.1 version of the 8-bit difference-encoded kernel in
+* avx2_edit_distance.c (see process_tile_8() there for the recurrence):
+* 16 cells per vector (pminsb is the SSE4.1 instruction it needs).
+*/
+static int process_tile(const int *top, const int *left, int *bottom,
+	int *right, int corner, int height, int width, const char *str1,
+	const char *str2, void *scratch){
+
+	int8_t *prev_dh = (int8_t*)scratch;
+	int8_t *prev_dv = prev_dh + LANE_ARRAY;
+	int8_t *cur_dh = prev_dv + LANE_ARRAY;
+	int8_t *cur_dv = cur_dh + LANE_ARRAY;
+	int8_t *bottom_dh = cur_dv + LANE_ARRAY;
+	int8_t *right_dv = bottom_dh + LANE_ARRAY;
+	char *s1 = (char*)(right_dv + LANE_ARRAY);
+	char *s2_reversed = s1 + LANE_ARRAY;
+
+	memcpy(s1, str1, height);
+	for(int m = 0; m < width; m++){
+		s2_reversed[m] = str2[width - 1 - m];
+	}
+
+	int top_last = top[width];
+	int left_last = left[height];
+
+	// Anti-diagonal 1: cells (0, 1) and (1, 0)
+	prev_dh[0] = (int8_t)(top[1] - corner);
+	prev_dv[1] = (int8_t)(left[1] - corner);
+
+	const __m128i v_one = _mm_set1_epi8(1);
+
+	int max_wave = height + width;
+	for(int k = 2; k <= max_wave; k++){
+		int min_i = (k - width > 1) ? (k - width) : 1;
+		int max_i = (k - 1 < height) ? (k - 1) : height;
+		const char *s2_wave = &s2_reversed[width - k];
+
+		for(int i = min_i; i <= max_i; i += LANES){
+			__m128i v_dh_up = _mm_loadu_si128((__m128i*)&prev_dh[i-1]);
+			__m128i v_dv_left = _mm_loadu_si128((__m128i*)&prev_dv[i]);
+
+			__m128i v_s1 = _mm_loadu_si128((const __m128i*)&s1[i - 1]);
+			__m128i v_s2 = _mm_loadu_si128((const __m128i*)&s2_wave[i]);
+			__m128i v_cost = _mm_add_epi8(_mm_cmpeq_epi8(v_s1, v_s2), v_one);
+
+			__m128i v_z = _mm_min_epi8(_mm_add_epi8(v_dh_up, v_one), _mm_add_epi8(v_dv_left, v_one));
+			v_z = _mm_min_epi8(v_z, v_cost);
+
+			_mm_storeu_si128((__m128i*)&cur_dv[i], _mm_sub_epi8(v_z, v_dh_up));
+			_mm_storeu_si128((__m128i*)&cur_dh[i], _mm_sub_epi8(v_z, v_dv_left));
+		}
+
+		// Boundary cells of this anti-diagonal
+		if(k <= width){
+			cur_dh[0] = (int8_t)(top[k] - top[k-1]);
+		}
+		if(k <= height){
+			cur_dv[k] = (int8_t)(left[k] - left[k-1]);
+		}
+
+		// Record the deltas crossing the tile's last row and column
+		if(k - height >= 1 && k - height <= width){
+			bottom_dh[k - height] = cur_dh[height];
+		}
+		if(k - width >= 1 && k - width <= height){
+			right_dv[k - width] = cur_dv[k - width];
+		}
+
+		int8_t *swap = prev_dh;
+		prev_dh = cur_dh;
+		cur_dh = swap;
+		swap = prev_dv;
+		prev_dv = cur_dv;
+		cur_dv = swap;
+	}
+
+	int value = left_last;
+	for(int j = 1; j <= width; j++){
+		value += bottom_dh[j];
+		bottom[j] = value;
+	}
+	int bottom_score = value;
+
+	value = top_last;
+	for(int i = 1; i <= height; i++){
+		value += right_dv[i];
+		right[i] = value;
+	}
+
+	return bottom_score;
+}
+
+long sse41_edit_distance_rect(const char *str1, size_t len1, const char *str2, size_t len2,
+	long num_threads, const WavefrontOptions *options){
+	WavefrontOptions tuned;
+	options = tile_config_options("sse41", options, BLOCK_SIZE, &tuned);
+	return wavefront_edit_distance_rect(str1, len1, str2, len2, num_threads, MAX_TILE_SIZE,
+		process_tile, 8 * LANE_ARRAY, options);
+}
+
+long sse41_edit_distance_opts(const char *str1, const char *str2, size_t len, long num_threads, const WavefrontOptions *options){
+	return sse41_edit_distance_rect(str1, len, str2, len, num_threads, options);
+}
+
+long sse41_edit_distance(const char *str1, const char *str2, size_t len, long num_threads){
+	return sse41_edit_distance_opts(str1, str2, len, num_threads, NULL);
+}
@@ -0,0 +1,260 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "src/tile_config.h"
+
+/*
+* Most tuned engines kept in memory, and the longest engine/host name.
+*/
+#define MAX_ENTRIES 32
+#define MAX_NAME 64
+
+typedef struct {
+	char engine[MAX_NAME];
+	int tile_height;
+	int tile_width;
+} TileEntry;
+
+static TileEntry entries[MAX_ENTRIES];
+static int num_entries = 0;
+static char path[4096];
+static char host[MAX_NAME];
+static CacheSizes caches;
+static pthread_once_t load_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t entries_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+* Reads a sysfs value such as "48K" or "32M" as bytes; 0 if missing.
+*/
+static size_t read_size(const char *file){
+	FILE *f = fopen(file, "r");
+	if(f == NULL){
+		return 0;
+	}
+	unsigned long value = 0;
+	char unit = '\0';
+	int fields = fscanf(f, "%lu%c", &value, &unit);
+	fclose(f);
+	if(fields < 1){
+		return 0;
+	}
+	if(unit == 'K'){
+		value *= 1024;
+	}
+	else if(unit == 'M'){
+		value *= 1024 * 1024;
+	}
+	return value;
+}
+
+void tile_cache_sizes(CacheSizes *sizes){
+	memset(sizes, 0, sizeof(CacheSizes));
+	for(int index = 0; index < 16; index++){
+		char file[128];
+		char type[32] = "";
+
+		snprintf(file, sizeof(file), "/sys/devices/system/cpu/cpu0/cache/index%d/type", index);
+		FILE *f = fopen(file, "r");
+		if(f == NULL){
+			break;
+		}
+		int fields = fscanf(f, "%31s", type);
+		fclose(f);
+		if(fields != 1 || strcmp(type, "Instruction") == 0){
+			continue;
+		}
+
+		snprintf(file, sizeof(file), "/sys/devices/system/cpu/cpu0/cache/index%d/level", index);
+		size_t level = read_size(file);
+		snprintf(file, sizeof(file), "/sys/devices/system/cpu/cpu0/cache/index%d/size", index);
+		size_t size = read_size(file);
+		if(level == 1){
+			sizes->l1d = size;
+		}
+		else if(level == 2){
+			sizes->l2 = size;
+		}
+		else if(level == 3){
+			sizes->l3 = size;
+		}
+	}
+}
+
+static void find_path(void){
+	const char *env = getenv("EDIT_DISTANCE_TILE_CACHE");
+	const char *xdg = getenv("XDG_CACHE_HOME");
+	const char *home = getenv("HOME");
+	path[0] = '\0';
+	if(env != NULL){
+		snprintf(path, sizeof(path), "%s", env);
+	}
+	else if(xdg != NULL && xdg[0] != '\0'){
+		snprintf(path, sizeof(path), "%s/edit_distance_tiles", xdg);
+	}
+	else if(home != NULL && home[0] != '\0'){
+		snprintf(path, sizeof(path), "%s/.cache/edit_distance_tiles", home);
+	}
+}
+
+/*
+* Sets the in-memory entry of engine. Caller holds entries_lock.
+*/
+static void set_entry(const char *engine, int tile_height, int tile_width){
+	int e = 0;
+	while(e < num_entries && strcmp(entries[e].engine, engine) != 0){
+		e++;
+	}
+	if(e == num_entries){
+		if(num_entries == MAX_ENTRIES){
+			return;
+		}
+		num_entries++;
+	}
+	snprintf(entries[e].engine, MAX_NAME, "%s", engine);
+	entries[e].tile_height = tile_height;
+	entries[e].tile_width = tile_width;
+}
+
+/*
+* Parses one line of the file. Returns 1 if it is valid and belongs to
+* this host with its current caches.
+*/
+static int parse_line(const char *line, char *engine, int *tile_height, int *tile_width){
+	char line_host[MAX_NAME];
+	size_t l1d, l2, l3;
+	if(sscanf(line, "%63s %63s %d %d %zu %zu %zu", line_host, engine, tile_height, tile_width,
+		&l1d, &l2, &l3) != 7){
+		return 0;
+	}
+	return strcmp(line_host, host) == 0 && l1d == caches.l1d && l2 == caches.l2
+		&& l3 == caches.l3 && *tile_height > 0 && *tile_width > 0;
+}
+
+static void load(void){
+	if(gethostname(host, sizeof(host)) != 0){
+		snprintf(host, sizeof(host), "unknown");
+	}
+	host[MAX_NAME - 1] = '\0';
+	tile_cache_sizes(&caches);
+	find_path();
+	if(path[0] == '\0'){
+		return;
+	}
+
+	FILE *file = fopen(path, "r");
+	if(file == NULL){
+		return;
+	}
+	char line[512];
+	while(fgets(line, sizeof(line), file) != NULL){
+		char engine[MAX_NAME];
+		int tile_height, tile_width;
+		if(line[0] != '#' && parse_line(line, engine, &tile_height, &tile_width)){
+			set_entry(engine, tile_height, tile_width);
+		}
+	}
+	fclose(file);
+}
+
+const char *tile_config_path(void){
+	pthread_once(&load_once, load);
+	return path;
+}
+
+int tile_config_lookup(const char *engine, int *tile_height, int *tile_width){
+	pthread_once(&load_once, load);
+	int found = 0;
+	pthread_mutex_lock(&entries_lock);
+	for(int e = 0; e < num_entries; e++){
+		if(strcmp(entries[e].engine, engine) == 0){
+			*tile_height = entries[e].tile_height;
+			*tile_width = entries[e].tile_width;
+			found = 1;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&entries_lock);
+	return found;
+}
+
+int tile_config_save(const char *engine, int tile_height, int tile_width){
+	pthread_once(&load_once, load);
+	pthread_mutex_lock(&entries_lock);
+	set_entry(engine, tile_height, tile_width);
+	pthread_mutex_unlock(&entries_lock);
+	if(path[0] == '\0'){
+		return -1;
+	}
+
+	/*
+	* Rewrite the file through a temporary one, so a concurrent reader
+	* sees either the old or the new version. Lines of other hosts (or
+	* of this host's other engines) are kept as they are.
+	*/
+	char temp_path[sizeof(path) + 32];
+	snprintf(temp_path, sizeof(temp_path), "%s.%ld.tmp", path, (long)getpid());
+	char *slash = strrchr(path, '/');
+	if(slash != NULL){
+		*slash = '\0';
+		mkdir(path, 0755);
+		*slash = '/';
+	}
+	FILE *out = fopen(temp_path, "w");
+	if(out == NULL){
+		return -1;
+	}
+	FILE *in = fopen(path, "r");
+	if(in != NULL){
+		char line[512];
+		while(fgets(line, sizeof(line), in) != NULL){
+			char line_host[MAX_NAME], line_engine[MAX_NAME];
+			if(sscanf(line, "%63s %63s", line_host, line_engine) == 2
+				&& strcmp(line_host, host) == 0 && strcmp(line_engine, engine) == 0){
+				continue;
+			}
+			fputs(line, out);
+		}
+		fclose(in);
+	}
+	else{
+		fprintf(out, "# host engine tile_height tile_width l1d l2 l3\n");
+	}
+	fprintf(out, "%s %s %d %d %zu %zu %zu\n", host, engine, tile_height, tile_width,
+		caches.l1d, caches.l2, caches.l3);
+
+	int status = ferror(out) ? -1 : 0;
+	if(fclose(out) != 0 || status != 0 || rename(temp_path, path) != 0){
+		remove(temp_path);
+		return -1;
+	}
+	return 0;
+}
+
+const WavefrontOptions *tile_config_options(const char *engine, const WavefrontOptions *options,
+	int default_size, WavefrontOptions *storage){
+	if(options != NULL){
+		*storage = *options;
+	}
+	else{
+		memset(storage, 0, sizeof(WavefrontOptions));
+		storage->schedule = WAVEFRONT_SCHEDULE_DATAFLOW;
+	}
+	if(storage->tile_height > 0 && storage->tile_width > 0){
+		return storage;
+	}
+
+	int tile_height = default_size;
+	int tile_width = default_size;
+	tile_config_lookup(engine, &tile_height, &tile_width);
+	if(storage->tile_height <= 0){
+		storage->tile_height = tile_height;
+	}
+	if(storage->tile_width <= 0){
+		storage->tile_width = tile_width;
+	}
+	return storage;
+}
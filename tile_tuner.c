@@ -0,0 +1,237 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "src/tile_tuner.h"
+#include "src/tile_config.h"
+#include "src/cpu_features.h"
+#include "src/tiled_edit_distance.h"
+#include "src/parallelized_edit_distance.h"
+#include "src/sse41_edit_distance.h"
+#include "src/avx2_edit_distance.h"
+#include "src/avx512_edit_distance.h"
+#include "src/bitparallel_edit_distance.h"
+
+/*
+* Tile sides tried, from smallest to largest; an engine stops at its
+* max_size. Shapes more than MAX_ASPECT times taller than wide (or the
+* other way around) are not tried, nor sides longer than 1 / MIN_TILES of
+* the input: timed on one thread, a single huge tile always wins, but it
+* leaves nothing to run in parallel.
+*/
+static const int sides[] = {64, 128, 256, 512, 1024, 2048, 4096};
+#define NUM_SIDES (int)(sizeof(sides) / sizeof(sides[0]))
+#define MAX_ASPECT 4
+#define MIN_TILES 4
+
+typedef long (*TuneRun)(const char *str1, const char *str2, size_t len, const WavefrontOptions *options);
+
+/*
+* default_size and max_size mirror BLOCK_SIZE and MAX_TILE_SIZE of the
+* engine's file. cell_bytes is the size of one stored DP cell; diagonal
+* is set for the kernels that keep three anti-diagonals instead of two
+* rows.
+*/
+typedef struct {
+	const char *name;
+	TuneRun run;
+	SimdLevel level;
+	int default_size;
+	int max_size;
+	int cell_bytes;
+	int diagonal;
+} TuneEngine;
+
+static long run_tiled(const char *str1, const char *str2, size_t len, const WavefrontOptions *options){
+	return tiled_edit_distance_shape(str1, len, str2, len, options->tile_height, options->tile_width);
+}
+
+static long run_parallel(const char *str1, const char *str2, size_t len, const WavefrontOptions *options){
+	return parallelized_edit_distance_opts(str1, str2, len, 1, options);
+}
+
+static long run_sse41(const char *str1, const char *str2, size_t len, const WavefrontOptions *options){
+	return sse41_edit_distance_opts(str1, str2, len, 1, options);
+}
+
+static long run_avx2(const char *str1, const char *str2, size_t len, const WavefrontOptions *options){
+	return avx2_edit_distance_lanes(str1, str2, len, 1, AVX2_LANES_8, options);
+}
+
+static long run_avx2_16(const char *str1, const char *str2, size_t len, const WavefrontOptions *options){
+	return avx2_edit_distance_lanes(str1, str2, len, 1, AVX2_LANES_16, options);
+}
+
+static long run_avx2_32(const char *str1, const char *str2, size_t len, const WavefrontOptions *options){
+	return avx2_edit_distance_lanes(str1, str2, len, 1, AVX2_LANES_32, options);
+}
+
+static long run_avx512(const char *str1, const char *str2, size_t len, const WavefrontOptions *options){
+	return avx512_edit_distance_opts(str1, str2, len, 1, options);
+}
+
+static long run_bitparallel(const char *str1, const char *str2, size_t len, const WavefrontOptions *options){
+	return bitparallel_edit_distance_threads(str1, len, str2, len, 1, options);
+}
+
+static const TuneEngine engines[] = {
+	{"tiled", run_tiled, SIMD_LEVEL_SCALAR, 512, 4096, 4, 0},
+	{"parallel", run_parallel, SIMD_LEVEL_SCALAR, 512, 4096, 4, 0},
+	{"sse41", run_sse41, SIMD_LEVEL_SSE41, 512, 2048, 1, 1},
+	{"avx2", run_avx2, SIMD_LEVEL_AVX2, 1024, 2048, 1, 1},
+	{"avx2-16", run_avx2_16, SIMD_LEVEL_AVX2, 1024, 2048, 2, 1},
+	{"avx2-32", run_avx2_32, SIMD_LEVEL_AVX2, 1024, 2048, 4, 1},
+	{"avx512", run_avx512, SIMD_LEVEL_AVX512, 1024, 2048, 1, 1},
+	{"bitparallel", run_bitparallel, SIMD_LEVEL_SCALAR, 1024, 2048, 8, 0}
+};
+#define NUM_ENGINES (int)(sizeof(engines) / sizeof(engines[0]))
+
+static double current_time_ms(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1000 + (double)ts.tv_nsec / 1e6;
+}
+
+const char *tile_tune_engine(int index){
+	return (index >= 0 && index < NUM_ENGINES) ? engines[index].name : NULL;
+}
+
+/*
+* Bytes a tile touches while it runs: the rows (or diagonals) of DP cells,
+* the two substrings and the boundary segments it reads and writes.
+*/
+static size_t working_set(const TuneEngine *engine, int height, int width){
+	size_t cells;
+	if(engine->diagonal){
+		cells = 3 * (size_t)((height < width) ? height : width);
+	}
+	else{
+		cells = 2 * (size_t)width;
+	}
+	return cells * engine->cell_bytes + height + width + 2 * sizeof(int) * (height + width);
+}
+
+/*
+* Best time of reps runs with the given shape, or a negative value if the
+* result disagrees with expected (or the run failed).
+*/
+static double time_shape(const TuneEngine *engine, const char *str1, const char *str2,
+	size_t len, int height, int width, int reps, long *expected){
+	WavefrontOptions options;
+	memset(&options, 0, sizeof(options));
+	options.schedule = WAVEFRONT_SCHEDULE_DATAFLOW;
+	options.tile_height = height;
+	options.tile_width = width;
+
+	double best = -1;
+	for(int rep = 0; rep < reps; rep++){
+		double start = current_time_ms();
+		long result = engine->run(str1, str2, len, &options);
+		double elapsed = current_time_ms() - start;
+		if(result < 0 || (*expected >= 0 && result != *expected)){
+			return -1;
+		}
+		*expected = result;
+		if(best < 0 || elapsed < best){
+			best = elapsed;
+		}
+	}
+	return best;
+}
+
+int tile_tune(const char *name, size_t len, int reps, TileTuneResult *result){
+	const TuneEngine *engine = NULL;
+	for(int e = 0; e < NUM_ENGINES; e++){
+		if(strcmp(engines[e].name, name) == 0){
+			engine = &engines[e];
+		}
+	}
+	if(engine == NULL || cpu_simd_level() < engine->level){
+		return -1;
+	}
+	if(len < 64 * MIN_TILES){
+		len = 64 * MIN_TILES;
+	}
+	if(reps < 1){
+		reps = 1;
+	}
+
+	/*
+	* A random string and a copy with 10% of it substituted, so both
+	* branches of the scalar kernels are taken.
+	*/
+	char *str1 = malloc(len);
+	char *str2 = malloc(len);
+	if(str1 == NULL || str2 == NULL){
+		printf("Unable to allocate memory for the strings in tile_tune().");
+		free(str1);
+		free(str2);
+		return -1;
+	}
+	unsigned long long state = 0x9e3779b97f4a7c15ULL;
+	for(size_t i = 0; i < len; i++){
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		str1[i] = "ACGT"[(state >> 33) % 4];
+		str2[i] = ((state >> 40) % 10 == 0) ? "ACGT"[(state >> 20) % 4] : str1[i];
+	}
+
+	CacheSizes caches;
+	tile_cache_sizes(&caches);
+	double cells = (double)len * len;
+
+	/*
+	* The default shape is timed first, so it also provides the expected
+	* distance every other shape is checked against.
+	*/
+	long expected = -1;
+	double default_ms = time_shape(engine, str1, str2, len, engine->default_size,
+		engine->default_size, reps, &expected);
+	if(default_ms < 0){
+		free(str1);
+		free(str2);
+		return -1;
+	}
+	result->engine = engine->name;
+	result->default_size = engine->default_size;
+	result->default_gcups = cells / (default_ms * 1e6);
+	result->tile_height = engine->default_size;
+	result->tile_width = engine->default_size;
+	result->gcups = result->default_gcups;
+	result->candidates = 1;
+	double best_ms = default_ms;
+
+	size_t max_side = len / MIN_TILES;
+	for(int h = 0; h < NUM_SIDES && sides[h] <= engine->max_size && (size_t)sides[h] <= max_side; h++){
+		for(int w = 0; w < NUM_SIDES && sides[w] <= engine->max_size && (size_t)sides[w] <= max_side; w++){
+			int height = sides[h];
+			int width = sides[w];
+			if(height > MAX_ASPECT * width || width > MAX_ASPECT * height
+				|| (height == engine->default_size && width == engine->default_size)){
+				continue;
+			}
+			if(caches.l2 > 0 && working_set(engine, height, width) > caches.l2){
+				continue;
+			}
+
+			double elapsed = time_shape(engine, str1, str2, len, height, width, reps, &expected);
+			if(elapsed < 0){
+				printf("Tile shape %dx%d of %s gave a different distance.\n", height, width, engine->name);
+				free(str1);
+				free(str2);
+				return -1;
+			}
+			result->candidates++;
+			if(elapsed < best_ms){
+				best_ms = elapsed;
+				result->tile_height = height;
+				result->tile_width = width;
+				result->gcups = cells / (elapsed * 1e6);
+			}
+		}
+	}
+
+	free(str1);
+	free(str2);
+	return 0;
+}
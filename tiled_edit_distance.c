@@ -1,6 +1,10 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include "src/tiled_edit_distance.h"
+#include "src/tile_config.h"
+#include "src/ed_context.h"
+#include "src/boundary.h"
+#include "src/common_affix.h"
 
 /*
 * n size for each individual block while tiling. 
@@ -8,6 +12,22 @@
 */
 #define BLOCK_SIZE 512
 
+/*
+* Helper function to resolve the tile shape: the one asked for, else the
+* tuned shape for this host (see tile_config.h), else BLOCK_SIZE.
+*/
+static void resolve_shape(int *tile_height, int *tile_width){
+	int tuned_height = BLOCK_SIZE;
+	int tuned_width = BLOCK_SIZE;
+	tile_config_lookup("tiled", &tuned_height, &tuned_width);
+	if(*tile_height <= 0){
+		*tile_height = tuned_height;
+	}
+	if(*tile_width <= 0){
+		*tile_width = tuned_width;
+	}
+}
+
 /*
 * Helper minimum function (returns whichever of a, b, and c is smaller).
 */
@@ -18,53 +38,46 @@ static inline int min(int a, int b, int c){
 
 /*
 * Helper function to process a single tile AND update the global rows and cols.
-* Returns -1 if memory could not be allocated for the two rows.
-* Returns 0 otherwise.
+* rows holds two rows of at least width + 1 ints, allocated once per call
+* by the caller. The global arrays hold ints, or longs if wide is set (see
+* boundary.h); the tile itself works relative to its corner, so its rows
+* stay ints either way. Returns the tile's bottom right cell.
 */
-static int process_tile(int row_offset, int col_offset, int *global_rows_read, 
-	int* global_rows_write, int *global_cols, int height, int width, 
-	const char *str1, const char *str2){
+static long process_tile(size_t row_offset, size_t col_offset, void *global_rows_read,
+	void *global_rows_write, void *global_cols, int wide, int height, int width,
+	const char *str1, const char *str2, int *rows){
 
-	int *prev_row = malloc((width + 1) * sizeof(int));
-	int *cur_row = malloc((width + 1) * sizeof(int));
-
-	/*
-	* Check for allocation errors.
-	*/
-	if(prev_row == NULL || cur_row == NULL){
-		printf("Failed to allocate memory for row arrays in tiled_edit_distance(), exiting program.");
-		free(prev_row);
-		free(cur_row);
-		return -1;
-	}
-
-	/*
-	* Set up prev_row using global_rows_read
-	*/ 
-	for(int j = 1; j <= width; j++){
-		prev_row[j] = global_rows_read[col_offset + j];
-	}
+	int *prev_row = rows;
+	int *cur_row = rows + (width + 1);
 
 	// Initialize the corner separately
+	long corner;
 	if(col_offset == 0){
 		// Grab the value from the left
-		prev_row[0] = row_offset;
+		corner = row_offset;
 	}
 	else if(row_offset == 0){
-		prev_row[0] = col_offset;
+		corner = col_offset;
 	}
 	else{
 		/*
 		* Safe read because neighboring tile to the left writes to 
 		* global_rows_write, not global_rows_read.
 		*/
-		prev_row[0] = global_rows_read[col_offset];
+		corner = boundary_load(global_rows_read, wide, col_offset);
 	}
 
+	/*
+	* Set up prev_row using global_rows_read
+	*/ 
+	prev_row[0] = 0;
+	for(int j = 1; j <= width; j++){
+		prev_row[j] = boundary_load(global_rows_read, wide, col_offset + j) - corner;
+	}
 
 	for(int i = 1; i <= height; i++){
 		size_t global_row_index = row_offset + i;
-		cur_row[0] = global_cols[global_row_index];
+		cur_row[0] = boundary_load(global_cols, wide, global_row_index) - corner;
 
 		for(int j = 1; j <= width; j++){
 			size_t global_col_index = col_offset + j;
@@ -86,7 +99,7 @@ static int process_tile(int row_offset, int col_offset, int *global_rows_read,
 		* Update the global column so the tile to the right of this one can read its
 		* correct initial cur_row[0]
 		*/
-		global_cols[global_row_index] = cur_row[width];
+		boundary_store(global_cols, wide, global_row_index, cur_row[width] + corner);
 
 		/*
 		* Swap pointers; next iteration's prev_row is this iteration's 
@@ -103,59 +116,78 @@ static int process_tile(int row_offset, int col_offset, int *global_rows_read,
 	* one can read its correct initial prev_row values.
 	*/
 	for(int j = 1; j <= width; j++){
-		global_rows_write[col_offset + j] = prev_row[j];
+		boundary_store(global_rows_write, wide, col_offset + j, prev_row[j] + corner);
 	}
 
-	// Cleanup
-	int result = prev_row[width];
-	free(prev_row);
-	free(cur_row);
-	return result;
+	return prev_row[width] + corner;
+}
+
+long tiled_edit_distance(const char *str1, const char *str2, size_t len){
+	return tiled_edit_distance_rect(str1, len, str2, len);
 }
 
-int tiled_edit_distance(const char *str1, const char *str2, size_t len){
-    if(len < 1){
-        return 0;
-    }
+long tiled_edit_distance_rect(const char *str1, size_t len1, const char *str2, size_t len2){
+	return tiled_edit_distance_shape(str1, len1, str2, len2, 0, 0);
+}
+
+static long tiled_edit_distance_core(EdContext *context, const char *str1, size_t len1,
+	const char *str2, size_t len2, int tile_height, int tile_width){
+	strip_common_affixes(&str1, &len1, &str2, &len2, NULL, NULL);
+	if(len1 < 1 || len2 < 1){
+		return (long)(len1 + len2);
+	}
+	resolve_shape(&tile_height, &tile_width);
+	if(context != NULL){
+		ed_context_reset(context);
+	}
+
 	/*
 	* Allocate the global boundaries arrays (holds the numbers future 
-	* process_tile calls will need).
+	* process_tile calls will need), and the two rows every tile works
+	* in. Rows run along str1, columns along str2.
 	*/
-	int *row_bounds1 = malloc((len + 1) * sizeof(int));
-	int *row_bounds2 = malloc((len + 1) * sizeof(int));
-	int *col_bounds = malloc((len + 1) * sizeof(int));
+	int wide = boundary_is_wide(len1, len2);
+	size_t entry = boundary_entry_size(wide);
+	void *row_bounds1 = ed_context_alloc_or_malloc(context, (len2 + 1) * entry);
+	void *row_bounds2 = ed_context_alloc_or_malloc(context, (len2 + 1) * entry);
+	void *col_bounds = ed_context_alloc_or_malloc(context, (len1 + 1) * entry);
+	int *rows = ed_context_alloc_or_malloc(context, 2 * ((size_t)tile_width + 1) * sizeof(int));
 
 	/*
 	* Check for allocation errors
 	*/
 	if(row_bounds1 == NULL || row_bounds2 == NULL || 
-		col_bounds == NULL){
+		col_bounds == NULL || rows == NULL){
 
-		free(row_bounds1);	
-		free(row_bounds2);
-		free(col_bounds);
+		printf("Failed to allocate memory for row arrays in tiled_edit_distance(), exiting program.");
+		ed_context_free_if_heap(context, row_bounds1);	
+		ed_context_free_if_heap(context, row_bounds2);
+		ed_context_free_if_heap(context, col_bounds);
+		ed_context_free_if_heap(context, rows);
 		return -1;
 	}
 
 	/*
 	* Initialize the boundaries (row 0 and col 0)
 	*/
-	for(size_t i = 0; i <= len; i++){
-		row_bounds1[i] = i;
-		row_bounds2[i] = i;
-		col_bounds[i] = i;
+	for(size_t j = 0; j <= len2; j++){
+		boundary_store(row_bounds1, wide, j, j);
+		boundary_store(row_bounds2, wide, j, j);
+	}
+	for(size_t i = 0; i <= len1; i++){
+		boundary_store(col_bounds, wide, i, i);
 	}
 
 	/*
 	* Sequentially iterate through tiles, row-by-row.
 	*/
-	for(size_t i = 0; i < len; i += BLOCK_SIZE){
+	for(size_t i = 0; i < len1; i += tile_height){
 		/*
 		* To avoid off-by-one errors caused by shared boundary arrays,
 		* use double buffering.
 		*/
-		int block_row_index = i / BLOCK_SIZE;
-		int *current_read_buffer, *current_write_buffer;
+		size_t block_row_index = i / tile_height;
+		void *current_read_buffer, *current_write_buffer;
 
 		if(block_row_index % 2 == 0){
 			// Even rows
@@ -168,38 +200,194 @@ int tiled_edit_distance(const char *str1, const char *str2, size_t len){
 			current_write_buffer = row_bounds1;
 		}
 
-		for(size_t j = 0; j < len; j+= BLOCK_SIZE){
+		for(size_t j = 0; j < len2; j+= tile_width){
 			/*
 			* Handle edge case where there are not enough elements left to create a full size tile.
 			*/
-			int height = (i + BLOCK_SIZE > len) ? (len - i) : BLOCK_SIZE;
-			int width = (j + BLOCK_SIZE > len) ? (len - j) : BLOCK_SIZE;
-
-			int result = process_tile(i, j, current_read_buffer, current_write_buffer, 
-				col_bounds, height, width, str1, str2);
-			if(result == -1){
-				free(row_bounds1);
-				free(row_bounds2);
-				free(col_bounds);
-				return result;
-			}
+			int height = (i + tile_height > len1) ? (len1 - i) : tile_height;
+			int width = (j + tile_width > len2) ? (len2 - j) : tile_width;
+
+			process_tile(i, j, current_read_buffer, current_write_buffer, 
+				col_bounds, wide, height, width, str1, str2, rows);
 		}
 	}
 
 	// Cleanup
-	int num_block_rows = (len + BLOCK_SIZE - 1) / BLOCK_SIZE;
-	int result;
+	size_t num_block_rows = (len1 + tile_height - 1) / tile_height;
+	long result;
 	if((num_block_rows - 1) % 2 == 0){
 		// Last row was even
-		result = row_bounds2[len];
+		result = boundary_load(row_bounds2, wide, len2);
 	}
 	else{
 		// Last row was odd
-		result = row_bounds1[len];
+		result = boundary_load(row_bounds1, wide, len2);
+	}
+
+	ed_context_free_if_heap(context, row_bounds1);
+	ed_context_free_if_heap(context, row_bounds2);
+	ed_context_free_if_heap(context, col_bounds);
+	ed_context_free_if_heap(context, rows);
+	return result;
+}
+
+long tiled_edit_distance_shape(const char *str1, size_t len1, const char *str2, size_t len2,
+	int tile_height, int tile_width){
+	return tiled_edit_distance_core(NULL, str1, len1, str2, len2, tile_height, tile_width);
+}
+
+long tiled_edit_distance_ctx(EdContext *context, const char *str1, size_t len1, const char *str2,
+	size_t len2, int tile_height, int tile_width){
+	return tiled_edit_distance_core(context, str1, len1, str2, len2, tile_height, tile_width);
+}
+
+/*
+* Helper function to check whether a tile holds at least one cell (i, j)
+* with |i - j| <= k. Tiles that do not are skipped by the bounded variant.
+*/
+static int tile_in_band(size_t row_offset, size_t col_offset, int height, int width, int k){
+	long long first_row = row_offset + 1;
+	long long last_row = row_offset + height;
+	long long first_col = col_offset + 1;
+	long long last_col = col_offset + width;
+	return (first_col - last_row <= k) && (first_row - last_col <= k);
+}
+
+int tiled_edit_distance_bounded(const char *str1, const char *str2, size_t len, int k){
+	return tiled_edit_distance_rect_bounded(str1, len, str2, len, k);
+}
+
+int tiled_edit_distance_rect_bounded(const char *str1, size_t len1, const char *str2, size_t len2, int k){
+	if(k < 0){
+		k = 0;
+	}
+	if(k > BOUNDED_MAX_DISTANCE){
+		k = BOUNDED_MAX_DISTANCE;
+	}
+	int limit = k + 1;
+	strip_common_affixes(&str1, &len1, &str2, &len2, NULL, NULL);
+
+	/*
+	* The length difference is a lower bound on the distance, and if it
+	* exceeds k the bottom right cell is not even inside the band.
+	*/
+	size_t length_difference = (len1 > len2) ? (len1 - len2) : (len2 - len1);
+	if(length_difference > (size_t)k){
+		return limit;
+	}
+	if(len1 < 1 || len2 < 1){
+		return (int)length_difference;
+	}
+	int tile_height = 0;
+	int tile_width = 0;
+	resolve_shape(&tile_height, &tile_width);
+
+	/*
+	* Allocate the global boundaries arrays (holds the numbers future 
+	* process_tile calls will need).
+	*/
+	int *row_bounds1 = malloc((len2 + 1) * sizeof(int));
+	int *row_bounds2 = malloc((len2 + 1) * sizeof(int));
+	int *col_bounds = malloc((len1 + 1) * sizeof(int));
+	int *rows = malloc(2 * ((size_t)tile_width + 1) * sizeof(int));
+
+	/*
+	* Check for allocation errors
+	*/
+	if(row_bounds1 == NULL || row_bounds2 == NULL || 
+		col_bounds == NULL || rows == NULL){
+
+		printf("Failed to allocate memory for row arrays in tiled_edit_distance(), exiting program.");
+		free(row_bounds1);	
+		free(row_bounds2);
+		free(col_bounds);
+		free(rows);
+		return -1;
 	}
 
+	/*
+	* Initialize the boundaries (row 0 and col 0), capped at k + 1
+	*/
+	for(size_t j = 0; j <= len2; j++){
+		int value = (j < (size_t)limit) ? (int)j : limit;
+		row_bounds1[j] = value;
+		row_bounds2[j] = value;
+	}
+	for(size_t i = 0; i <= len1; i++){
+		col_bounds[i] = (i < (size_t)limit) ? (int)i : limit;
+	}
+
+	/*
+	* Sequentially iterate through tiles, row-by-row, skipping every tile
+	* that lies entirely outside the band.
+	*/
+	int result = limit;
+	for(size_t i = 0; i < len1; i += tile_height){
+		size_t block_row_index = i / tile_height;
+		int *current_read_buffer, *current_write_buffer;
+
+		if(block_row_index % 2 == 0){
+			// Even rows
+			current_read_buffer = row_bounds1;
+			current_write_buffer = row_bounds2;
+		}
+		else{
+			// Odd rows
+			current_read_buffer = row_bounds2;
+			current_write_buffer = row_bounds1;
+		}
+
+		int height = (i + tile_height > len1) ? (len1 - i) : tile_height;
+		int row_min = limit;
+		for(size_t j = 0; j < len2; j+= tile_width){
+			int width = (j + tile_width > len2) ? (len2 - j) : tile_width;
+			if(!tile_in_band(i, j, height, width, k)){
+				continue;
+			}
+
+			/*
+			* Neighbours outside the band were never computed; their
+			* boundary cells all exceed k, so k + 1 stands in for them.
+			*/
+			if(i > 0 && !tile_in_band(i - tile_height, j, tile_height, width, k)){
+				for(int w = 1; w <= width; w++){
+					current_read_buffer[j + w] = limit;
+				}
+			}
+			if(i > 0 && j > 0 && !tile_in_band(i - tile_height, j - tile_width, tile_height, tile_width, k)){
+				current_read_buffer[j] = limit;
+			}
+			if(j > 0 && !tile_in_band(i, j - tile_width, height, tile_width, k)){
+				for(int h = 1; h <= height; h++){
+					col_bounds[i + h] = limit;
+				}
+			}
+
+			process_tile(i, j, current_read_buffer, current_write_buffer, 
+				col_bounds, 0, height, width, str1, str2, rows);
+			for(int w = 1; w <= width; w++){
+				if(current_write_buffer[j + w] < row_min){
+					row_min = current_write_buffer[j + w];
+				}
+			}
+		}
+
+		/*
+		* Every path to the bottom right crosses the last row of this tile
+		* row, so if none of its band cells is within k, stop here.
+		*/
+		if(row_min > k){
+			break;
+		}
+		if(i + height == len1){
+			result = current_write_buffer[len2];
+		}
+	}
+
+	// Cleanup
 	free(row_bounds1);
 	free(row_bounds2);
 	free(col_bounds);
-	return result;
+	free(rows);
+	return (result > k) ? limit : result;
 }
\ No newline at end of file
@@ -0,0 +1,197 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "src/trace.h"
+
+typedef struct {
+	uint64_t start_ns;
+	uint64_t end_ns;
+	int type;
+	int run;
+	long a;
+	long b;
+} TraceEvent;
+
+typedef struct {
+	TraceEvent *events;
+	size_t written;		// total, the ring holds the last capacity of them
+	int max_run;		// highest run seen on this thread, -1 for none
+} TraceRing;
+
+struct Trace {
+	TraceRing rings[TRACE_MAX_THREADS];
+	int num_threads;
+	size_t capacity;
+	int num_runs;
+	char *run_names[TRACE_MAX_RUNS];
+	uint64_t origin_ns;
+};
+
+static Trace *active_trace = NULL;
+static int active_run = 0;
+
+static uint64_t monotonic_ns(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+Trace *trace_create(int num_threads, size_t events_per_thread){
+	Trace *trace = calloc(1, sizeof(Trace));
+	if(trace == NULL || events_per_thread == 0 || num_threads < 1){
+		free(trace);
+		return NULL;
+	}
+	trace->num_threads = (num_threads > TRACE_MAX_THREADS) ? TRACE_MAX_THREADS : num_threads;
+	trace->capacity = events_per_thread;
+	trace->origin_ns = monotonic_ns();
+
+	/*
+	* The rings are allocated up front so that recording never allocates.
+	*/
+	for(int t = 0; t < trace->num_threads; t++){
+		trace->rings[t].events = malloc(events_per_thread * sizeof(TraceEvent));
+		trace->rings[t].max_run = -1;
+		if(trace->rings[t].events == NULL){
+			printf("Unable to allocate the trace buffers in trace_create().");
+			trace_destroy(trace);
+			return NULL;
+		}
+	}
+	return trace;
+}
+
+void trace_destroy(Trace *trace){
+	if(trace == NULL){
+		return;
+	}
+	for(int t = 0; t < trace->num_threads; t++){
+		free(trace->rings[t].events);
+	}
+	for(int r = 0; r < trace->num_runs; r++){
+		free(trace->run_names[r]);
+	}
+	free(trace);
+}
+
+int trace_begin_run(Trace *trace, const char *name){
+	if(trace->num_runs == TRACE_MAX_RUNS){
+		return -1;
+	}
+	trace->run_names[trace->num_runs] = strdup(name);
+	active_run = trace->num_runs++;
+	active_trace = trace;
+	return 0;
+}
+
+void trace_end_run(void){
+	active_trace = NULL;
+}
+
+uint64_t trace_now(void){
+	return (active_trace != NULL) ? monotonic_ns() : 0;
+}
+
+void trace_record(int thread_id, TraceEventType type, uint64_t start, long a, long b){
+	Trace *trace = active_trace;
+	if(trace == NULL || thread_id < 0 || thread_id >= trace->num_threads){
+		return;
+	}
+	TraceRing *ring = &trace->rings[thread_id];
+	TraceEvent *event = &ring->events[ring->written % trace->capacity];
+	event->start_ns = start;
+	event->end_ns = monotonic_ns();
+	event->type = type;
+	event->run = active_run;
+	event->a = a;
+	event->b = b;
+	ring->written++;
+	if(active_run > ring->max_run){
+		ring->max_run = active_run;
+	}
+}
+
+/*
+* Writes the comma between two events (none before the first)
+*/
+static void separate(FILE *file, int *first){
+	fprintf(file, *first ? "\n" : ",\n");
+	*first = 0;
+}
+
+static void write_event(FILE *file, const Trace *trace, int thread_id, const TraceEvent *event){
+	static const char *names[] = {"tile", "barrier wait", "idle", "alloc"};
+	double ts = (event->start_ns - trace->origin_ns) / 1000.0;
+	double dur = (event->end_ns - event->start_ns) / 1000.0;
+
+	fprintf(file, "{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, "
+		"\"pid\": %d, \"tid\": %d, \"args\": ",
+		names[event->type], names[event->type], ts, dur, event->run, thread_id);
+	switch(event->type){
+		case TRACE_TILE:
+			fprintf(file, "{\"r\": %ld, \"c\": %ld}}", event->a, event->b);
+			break;
+		case TRACE_BARRIER_WAIT:
+			fprintf(file, "{\"wave\": %ld}}", event->a);
+			break;
+		case TRACE_IDLE:
+			fprintf(file, "{\"stolen\": %ld}}", event->a);
+			break;
+		default:
+			fprintf(file, "{\"bytes\": %ld}}", event->a);
+			break;
+	}
+}
+
+int trace_write_chrome(const Trace *trace, const char *path){
+	FILE *file = fopen(path, "w");
+	if(file == NULL){
+		return -1;
+	}
+
+	/*
+	* Metadata first: one process per run, one thread per worker.
+	*/
+	size_t dropped = 0;
+	int first = 1;
+	fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+	for(int r = 0; r < trace->num_runs; r++){
+		separate(file, &first);
+		fprintf(file, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, \"args\": {\"name\": \"%s\"}}",
+			r, trace->run_names[r]);
+		separate(file, &first);
+		fprintf(file, "{\"name\": \"process_sort_index\", \"ph\": \"M\", \"pid\": %d, \"args\": {\"sort_index\": %d}}",
+			r, r);
+	}
+	for(int t = 0; t < trace->num_threads; t++){
+		const TraceRing *ring = &trace->rings[t];
+		for(int r = 0; r <= ring->max_run; r++){
+			separate(file, &first);
+			fprintf(file, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, "
+				"\"args\": {\"name\": \"worker %d\"}}", r, t, t);
+		}
+	}
+
+	/*
+	* Then every thread's ring, oldest event first.
+	*/
+	for(int t = 0; t < trace->num_threads; t++){
+		const TraceRing *ring = &trace->rings[t];
+		size_t count = (ring->written < trace->capacity) ? ring->written : trace->capacity;
+		size_t oldest = ring->written - count;
+		dropped += oldest;
+		for(size_t i = oldest; i < ring->written; i++){
+			separate(file, &first);
+			write_event(file, trace, t, &ring->events[i % trace->capacity]);
+		}
+	}
+
+	fprintf(file, "\n], \"otherData\": {\"dropped_events\": %zu}}\n", dropped);
+	int status = ferror(file) ? -1 : 0;
+	if(fclose(file) != 0){
+		status = -1;
+	}
+	return status;
+}
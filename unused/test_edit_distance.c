@@ -2,14 +2,32 @@
 #include <stddef.h>
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
 #include "naive_edit_distance.h"
-#include "../tiled_edit_distance.h"
+#include "tiled_edit_distance.h"
 #include "parallelized_edit_distance.h"
-#include "../avx2_edit_distance.h"
+#include "avx2_edit_distance.h"
+#include "bitparallel_edit_distance.h"
+#include "simd_edit_distance.h"
+#include "batch_edit_distance.h"
+#include "alignment.h"
+#include "mapped_input.h"
+#include "bk_tree.h"
+#include "filter_cascade.h"
+#include "approximate_search.h"
+#include "sharded_wavefront.h"
+#include "checkpoint.h"
+#include "incremental_edit_distance.h"
+#include "anchored_edit_distance.h"
 
 #define NUM_THREADS 4
 #define BLOCK_SIZE 512
 
+static int failures = 0;
+
 static void run_test_expected(const char* name, const char* s1, const char* s2, int expected) {
     printf("Running Test: %s ... ", name);
     fflush(stdout);
@@ -21,6 +39,10 @@ static void run_test_expected(const char* name, const char* s1, const char* s2,
     int r_tiled = tiled_edit_distance(s1, s2, len);
     int r_para  = parallelized_edit_distance(s1, s2, len, NUM_THREADS);
     int r_avx   = avx2_edit_distance(s1, s2, len, NUM_THREADS);
+    int r_avx16 = avx2_edit_distance_lanes(s1, s2, len, NUM_THREADS, AVX2_LANES_16, NULL);
+    int r_avx32 = avx2_edit_distance_lanes(s1, s2, len, NUM_THREADS, AVX2_LANES_32, NULL);
+    int r_bit   = bitparallel_edit_distance(s1, s2, len);
+    int r_simd  = simd_edit_distance(s1, s2, len, NUM_THREADS);
 
     // Check against expected
     int fail = 0;
@@ -28,14 +50,23 @@ static void run_test_expected(const char* name, const char* s1, const char* s2,
     if (r_tiled != expected) { fail = 1; }
     if (r_para != expected)  { fail = 1; }
     if (r_avx != expected)   { fail = 1; }
+    if (r_avx16 != expected) { fail = 1; }
+    if (r_avx32 != expected) { fail = 1; }
+    if (r_bit != expected)   { fail = 1; }
+    if (r_simd != expected)  { fail = 1; }
 
     // Print results
     if (fail) {
+        failures++;
         printf("FAILED!\n");
         printf("Naive:    %d\n", r_naive);
         printf("Tiled:    %d\n", r_tiled);
         printf("Parallel: %d\n", r_para);
         printf("AVX2:     %d\n", r_avx);
+        printf("AVX2/16:  %d\n", r_avx16);
+        printf("AVX2/32:  %d\n", r_avx32);
+        printf("BitPar:   %d\n", r_bit);
+        printf("SIMD:     %d\n", r_simd);
     } else {
         printf("PASSED (Result: %d)\n", r_naive);
     }
@@ -53,26 +84,658 @@ static void run_test_naive(const char* name, const char* s1, const char* s2) {
     int r_tiled = tiled_edit_distance(s1, s2, len);
     int r_para  = parallelized_edit_distance(s1, s2, len, NUM_THREADS);
     int r_avx   = avx2_edit_distance(s1, s2, len, NUM_THREADS);
+    int r_avx16 = avx2_edit_distance_lanes(s1, s2, len, NUM_THREADS, AVX2_LANES_16, NULL);
+    int r_avx32 = avx2_edit_distance_lanes(s1, s2, len, NUM_THREADS, AVX2_LANES_32, NULL);
+    int r_bit   = bitparallel_edit_distance(s1, s2, len);
+    int r_simd  = simd_edit_distance(s1, s2, len, NUM_THREADS);
 
     // Check against naive implementation
     int fail = 0;
     if (r_tiled != r_naive) { fail = 1; }
     if (r_para != r_naive)  { fail = 1; }
     if (r_avx != r_naive)   { fail = 1; }
+    if (r_avx16 != r_naive) { fail = 1; }
+    if (r_avx32 != r_naive) { fail = 1; }
+    if (r_bit != r_naive)   { fail = 1; }
+    if (r_simd != r_naive)  { fail = 1; }
 
     // Print results
     if (fail) {
+        failures++;
         printf("FAILED!\n");
         printf("Naive:    %d\n", r_naive);
         printf("Tiled:    %d\n", r_tiled);
         printf("Parallel: %d\n", r_para);
         printf("AVX2:     %d\n", r_avx);
+        printf("AVX2/16:  %d\n", r_avx16);
+        printf("AVX2/32:  %d\n", r_avx32);
+        printf("BitPar:   %d\n", r_bit);
+        printf("SIMD:     %d\n", r_simd);
     } else {
         printf("PASSED (Result: %d)\n", r_naive);
     }
     fflush(stdout);
 }
 
+// Bounded variants return the distance if it is <= k, and k + 1 otherwise
+static void run_test_bounded(const char* name, const char* s1, const char* s2, int k, int expected) {
+    printf("Running Test: %s ... ", name);
+    fflush(stdout);
+
+    size_t len = strlen(s1);
+
+    int r_naive = naive_edit_distance_bounded(s1, s2, len, k);
+    int r_tiled = tiled_edit_distance_bounded(s1, s2, len, k);
+    int r_para  = parallelized_edit_distance_bounded(s1, s2, len, NUM_THREADS, k);
+    int r_avx   = avx2_edit_distance_bounded(s1, s2, len, NUM_THREADS, k);
+    int r_bit   = bitparallel_edit_distance_bounded(s1, s2, len, k);
+
+    if (r_naive != expected || r_tiled != expected || r_para != expected
+        || r_avx != expected || r_bit != expected) {
+        failures++;
+        printf("FAILED!\n");
+        printf("Naive:    %d\n", r_naive);
+        printf("Tiled:    %d\n", r_tiled);
+        printf("Parallel: %d\n", r_para);
+        printf("AVX2:     %d\n", r_avx);
+        printf("BitPar:   %d\n", r_bit);
+    } else {
+        printf("PASSED (Result: %d)\n", r_naive);
+    }
+    fflush(stdout);
+}
+
+// Strings of different lengths go through the _rect variants
+static void run_test_rect(const char* name, const char* s1, const char* s2, int expected) {
+    printf("Running Test: %s ... ", name);
+    fflush(stdout);
+
+    size_t len1 = strlen(s1);
+    size_t len2 = strlen(s2);
+
+    int r_naive = naive_edit_distance_rect(s1, len1, s2, len2);
+    int r_tiled = tiled_edit_distance_rect(s1, len1, s2, len2);
+    int r_para  = parallelized_edit_distance_rect(s1, len1, s2, len2, NUM_THREADS, NULL);
+    int r_avx   = avx2_edit_distance_rect(s1, len1, s2, len2, NUM_THREADS, NULL);
+    int r_bit   = bitparallel_edit_distance_rect(s1, len1, s2, len2, NULL);
+    int r_simd  = simd_edit_distance_rect(s1, len1, s2, len2, NUM_THREADS, NULL);
+
+    if (r_naive != expected || r_tiled != expected || r_para != expected
+        || r_avx != expected || r_bit != expected || r_simd != expected) {
+        failures++;
+        printf("FAILED!\n");
+        printf("Naive:    %d\n", r_naive);
+        printf("Tiled:    %d\n", r_tiled);
+        printf("Parallel: %d\n", r_para);
+        printf("AVX2:     %d\n", r_avx);
+        printf("BitPar:   %d\n", r_bit);
+        printf("SIMD:     %d\n", r_simd);
+    } else {
+        printf("PASSED (Result: %d)\n", r_naive);
+    }
+    fflush(stdout);
+}
+
+// Forces a tile shape (tall, wide or uneven) on the tiled and wavefront engines
+static void run_test_shape(const char* name, const char* s1, const char* s2, int height, int width) {
+    printf("Running Test: %s ... ", name);
+    fflush(stdout);
+
+    size_t len1 = strlen(s1);
+    size_t len2 = strlen(s2);
+    WavefrontOptions options = {WAVEFRONT_SCHEDULE_DATAFLOW, NULL, 0, 0, height, width};
+
+    int r_naive = naive_edit_distance_rect(s1, len1, s2, len2);
+    int r_tiled = tiled_edit_distance_shape(s1, len1, s2, len2, height, width);
+    int r_para  = parallelized_edit_distance_rect(s1, len1, s2, len2, NUM_THREADS, &options);
+    int r_avx   = avx2_edit_distance_rect(s1, len1, s2, len2, NUM_THREADS, &options);
+    int r_bit   = bitparallel_edit_distance_rect(s1, len1, s2, len2, &options);
+
+    if (r_tiled != r_naive || r_para != r_naive || r_avx != r_naive || r_bit != r_naive) {
+        failures++;
+        printf("FAILED!\n");
+        printf("Naive:    %d\n", r_naive);
+        printf("Tiled:    %d\n", r_tiled);
+        printf("Parallel: %d\n", r_para);
+        printf("AVX2:     %d\n", r_avx);
+        printf("BitPar:   %d\n", r_bit);
+    } else {
+        printf("PASSED (Result: %d)\n", r_naive);
+    }
+    fflush(stdout);
+}
+
+// Pinned workers (both schedules) must give the same results as the default placement
+static void run_test_pinned(const char* name, const char* s1, const char* s2) {
+    printf("Running Test: %s ... ", name);
+    fflush(stdout);
+
+    size_t len1 = strlen(s1);
+    size_t len2 = strlen(s2);
+    WavefrontOptions dataflow = {WAVEFRONT_SCHEDULE_DATAFLOW, NULL, 0, 0, 0, 0, WAVEFRONT_AFFINITY_PINNED};
+    WavefrontOptions barrier = {WAVEFRONT_SCHEDULE_BARRIER, NULL, 0, 0, 0, 0, WAVEFRONT_AFFINITY_PINNED};
+
+    int r_naive = naive_edit_distance_rect(s1, len1, s2, len2);
+    int r_para  = parallelized_edit_distance_rect(s1, len1, s2, len2, NUM_THREADS, &dataflow);
+    int r_parb  = parallelized_edit_distance_rect(s1, len1, s2, len2, NUM_THREADS, &barrier);
+    int r_avx   = avx2_edit_distance_rect(s1, len1, s2, len2, NUM_THREADS, &dataflow);
+    int r_avxb  = avx2_edit_distance_rect(s1, len1, s2, len2, NUM_THREADS, &barrier);
+
+    if (r_para != r_naive || r_parb != r_naive || r_avx != r_naive || r_avxb != r_naive) {
+        failures++;
+        printf("FAILED!\n");
+        printf("Naive:              %d\n", r_naive);
+        printf("Parallel dataflow:  %d\n", r_para);
+        printf("Parallel barrier:   %d\n", r_parb);
+        printf("AVX2 dataflow:      %d\n", r_avx);
+        printf("AVX2 barrier:       %d\n", r_avxb);
+    } else {
+        printf("PASSED (Result: %d)\n", r_naive);
+    }
+    fflush(stdout);
+}
+
+// Runs the engines twice through one context: results must match naive and
+// the second round must not need any new memory
+static void run_test_context(const char* name, const char* s1, const char* s2) {
+    printf("Running Test: %s ... ", name);
+    fflush(stdout);
+
+    size_t len1 = strlen(s1);
+    size_t len2 = strlen(s2);
+    EdContext* context = ed_context_create(len1 > len2 ? len1 : len2, NUM_THREADS, 0);
+    WavefrontOptions options = {WAVEFRONT_SCHEDULE_DATAFLOW, NULL, 0, 0, 0, 0, WAVEFRONT_AFFINITY_NONE, context};
+    int r_naive = naive_edit_distance_rect(s1, len1, s2, len2);
+    int wrong = 0;
+    size_t warm = 0;
+
+    for (int round = 0; round < 2; round++) {
+        if (round == 1) warm = ed_context_allocations(context);
+        wrong += tiled_edit_distance_ctx(context, s1, len1, s2, len2, 0, 0) != r_naive;
+        wrong += parallelized_edit_distance_rect(s1, len1, s2, len2, NUM_THREADS, &options) != r_naive;
+        wrong += avx2_edit_distance_rect(s1, len1, s2, len2, NUM_THREADS, &options) != r_naive;
+    }
+    size_t grown = ed_context_allocations(context) - warm;
+
+    if (wrong || grown != 0) {
+        failures++;
+        printf("FAILED!\n");
+        printf("Wrong results:           %d\n", wrong);
+        printf("Allocations when warm:   %zu\n", grown);
+    } else {
+        printf("PASSED (Result: %d)\n", r_naive);
+    }
+    ed_context_destroy(context);
+    fflush(stdout);
+}
+
+// The alignment must turn s1 into s2 with exactly the naive distance in edits
+static void run_test_align(const char* name, const char* s1, const char* s2) {
+    printf("Running Test: %s ... ", name);
+    fflush(stdout);
+
+    size_t len1 = strlen(s1);
+    size_t len2 = strlen(s2);
+    Alignment alignment;
+    int r_naive = naive_edit_distance_rect(s1, len1, s2, len2);
+    int r_align = edit_distance_align(s1, len1, s2, len2, NUM_THREADS, &alignment);
+
+    // Replay the operations against both strings
+    size_t i = 0, j = 0;
+    int edits = 0, valid = (r_align >= 0);
+    for (size_t r = 0; valid && r < alignment.num_runs; r++) {
+        for (size_t k = 0; k < alignment.runs[r].length; k++) {
+            char op = alignment.runs[r].op;
+            if (op == '=' || op == 'X') {
+                valid &= (i < len1 && j < len2 && (s1[i] == s2[j]) == (op == '='));
+                i++; j++;
+            }
+            else if (op == 'D') i++;
+            else j++;
+            edits += (op != '=');
+        }
+    }
+    valid &= (i == len1 && j == len2 && edits == r_align);
+
+    if (!valid || r_align != r_naive) {
+        failures++;
+        printf("FAILED!\n");
+        printf("Naive:     %d\n", r_naive);
+        printf("Alignment: %d (%d edits, %s)\n", r_align, edits, valid ? "valid" : "invalid");
+    } else {
+        char cigar[32];
+        alignment_cigar(&alignment, cigar, sizeof(cigar));
+        printf("PASSED (Result: %d, CIGAR %s)\n", r_align, cigar);
+    }
+    alignment_free(&alignment);
+    fflush(stdout);
+}
+
+// Reads s1 through a segment map over a copy broken into lines of width
+// characters, as a FASTA file would be; both schedules must match naive
+static void run_test_segments(const char* name, const char* s1, const char* s2, size_t width) {
+    printf("Running Test: %s ... ", name);
+    fflush(stdout);
+
+    size_t len1 = strlen(s1);
+    size_t len2 = strlen(s2);
+    size_t lines = (len1 + width - 1) / width;
+    char* text = malloc(len1 + lines + 1);
+    size_t* starts = malloc((lines + 1) * sizeof(size_t));
+    size_t* offsets = malloc((lines + 1) * sizeof(size_t));
+    starts[0] = 0;
+    for (size_t k = 0; k < lines; k++) {
+        size_t length = (len1 - k * width < width) ? len1 - k * width : width;
+        offsets[k] = k * (width + 1);
+        starts[k + 1] = starts[k] + length;
+        memcpy(text + offsets[k], s1 + k * width, length);
+        text[offsets[k] + length] = '\n';
+    }
+    SegmentMap map = {text, starts, offsets, lines};
+    WavefrontOptions dataflow = {WAVEFRONT_SCHEDULE_DATAFLOW};
+    WavefrontOptions barrier = {WAVEFRONT_SCHEDULE_BARRIER};
+    dataflow.segments1 = &map;
+    barrier.segments1 = &map;
+
+    int r_naive = naive_edit_distance_rect(s1, len1, s2, len2);
+    int r_para  = parallelized_edit_distance_rect(NULL, len1, s2, len2, NUM_THREADS, &dataflow);
+    int r_avxb  = avx2_edit_distance_rect(NULL, len1, s2, len2, NUM_THREADS, &barrier);
+
+    if (r_para != r_naive || r_avxb != r_naive) {
+        failures++;
+        printf("FAILED!\n");
+        printf("Naive:              %d\n", r_naive);
+        printf("Parallel dataflow:  %d\n", r_para);
+        printf("AVX2 barrier:       %d\n", r_avxb);
+    } else {
+        printf("PASSED (Result: %d)\n", r_naive);
+    }
+    free(text);
+    free(starts);
+    free(offsets);
+    fflush(stdout);
+}
+
+// Runs all pairs in one edit_distance_batch() call and checks each against naive
+static void run_test_batch(const char* name, const EditPair* pairs, size_t n) {
+    printf("Running Test: %s ... ", name);
+    fflush(stdout);
+
+    int* results = malloc(n * sizeof(int));
+    int status = edit_distance_batch(pairs, n, results, NUM_THREADS);
+    int wrong = 0;
+    for (size_t i = 0; i < n; i++) {
+        int expected = naive_edit_distance_rect(pairs[i].str1, pairs[i].len1, pairs[i].str2, pairs[i].len2);
+        if (status != 0 || results[i] != expected) {
+            if (wrong++ == 0) printf("FAILED!\n");
+            printf("Pair %zu: expected %d, got %d\n", i, expected, results[i]);
+        }
+    }
+    if (wrong) {
+        failures++;
+    } else {
+        printf("PASSED (%zu pairs)\n", n);
+    }
+    free(results);
+    fflush(stdout);
+}
+
+// Thresholded distances through the filter cascade: every pair must match
+// naive capped at k + 1, and every pair must be counted by exactly one stage
+static void run_test_filter(const char* name, const EditPair* pairs, size_t n, int k) {
+    printf("Running Test: %s ... ", name);
+    fflush(stdout);
+
+    int* results = malloc(n * sizeof(int));
+    FilterStats stats;
+    int status = filter_cascade(pairs, n, k, results, NUM_THREADS, &stats);
+    int wrong = (status != 0) || (stats.length_rejected + stats.histogram_rejected
+        + stats.qgram_rejected + stats.computed != n);
+    for (size_t i = 0; i < n && !wrong; i++) {
+        int expected = naive_edit_distance_rect(pairs[i].str1, pairs[i].len1, pairs[i].str2, pairs[i].len2);
+        if (expected > k) expected = k + 1;
+        if (results[i] != expected) {
+            printf("FAILED!\n");
+            printf("Pair %zu: expected %d, got %d\n", i, expected, results[i]);
+            wrong = 2;
+        }
+    }
+    if (wrong) {
+        failures++;
+        if (wrong == 1) printf("FAILED!\n");
+    } else {
+        printf("PASSED (%zu filtered, %zu computed)\n", n - stats.computed, stats.computed);
+    }
+    free(results);
+    fflush(stdout);
+}
+
+// A single pair the cascade has to reject at the given stage
+static void run_test_filter_stage(const char* name, const char* s1, size_t len1, const char* s2,
+    size_t len2, int k, FilterStage expected) {
+    printf("Running Test: %s ... ", name);
+    fflush(stdout);
+
+    FilterStage stage = filter_cascade_check(s1, len1, s2, len2, k);
+    long distance = naive_edit_distance_rect(s1, len1, s2, len2);
+    if (stage != expected || distance <= k) {
+        failures++;
+        printf("FAILED!\n");
+        printf("Expected stage %d, got %d (distance %ld)\n", (int)expected, (int)stage, distance);
+    } else {
+        printf("PASSED (distance %ld)\n", distance);
+    }
+    fflush(stdout);
+}
+
+// Brute-force answer for a BK-tree query: true if match is the expected
+// rank-th closest word (by distance, then index) of words
+static int bk_rank_matches(const char** words, size_t n, const char* query, size_t rank, const BkMatch* match) {
+    int distance = naive_edit_distance_rect(query, strlen(query), words[match->index], strlen(words[match->index]));
+    size_t before = 0;
+    for (size_t i = 0; i < n; i++) {
+        int d = naive_edit_distance_rect(query, strlen(query), words[i], strlen(words[i]));
+        before += (d < distance || (d == distance && i < match->index));
+    }
+    return distance == match->distance && before == rank;
+}
+
+// Top-k and radius queries against brute force, on the built tree and on
+// the same tree saved and mapped back in; a file whose root points its
+// children past the last node must then fail to load
+static void run_test_bk_tree(const char* name, const char** words, size_t n, const char* query, size_t k, int radius) {
+    printf("Running Test: %s ... ", name);
+    fflush(stdout);
+
+    char path[] = "/tmp/test_bk_tree_XXXXXX";
+    int fd = mkstemp(path);
+    BkTree* built = bk_tree_build(words, NULL, n);
+    int saved = (fd >= 0 && built != NULL) ? bk_tree_save(built, path) : -1;
+    BkTree* loaded = (saved == 0) ? bk_tree_load(path) : NULL;
+    BkTree* trees[2] = {built, loaded};
+
+    int wrong = (loaded == NULL);
+    long in_radius = 0;
+    for (size_t i = 0; i < n; i++) {
+        in_radius += (naive_edit_distance_rect(query, strlen(query), words[i], strlen(words[i])) <= radius);
+    }
+    for (int t = 0; t < 2 && !wrong; t++) {
+        BkMatch top[16];
+        long found = bk_tree_top_k(trees[t], query, strlen(query), k, top);
+        wrong |= (found != (long)((k < n) ? k : n));
+        for (long r = 0; r < found && !wrong; r++) {
+            wrong |= !bk_rank_matches(words, n, query, r, &top[r]);
+        }
+        BkMatch* near;
+        long count = bk_tree_radius(trees[t], query, strlen(query), radius, &near);
+        wrong |= (count != in_radius);
+        for (long r = 0; r < count && !wrong; r++) {
+            wrong |= !bk_rank_matches(words, n, query, r, &near[r]);
+        }
+        free(near);
+    }
+    if (!wrong) {
+        uint32_t bad_child = UINT32_MAX - 1;
+        // Header (32 bytes), then the root's text_offset, length, word and distance
+        wrong |= (pwrite(fd, &bad_child, sizeof(bad_child), 32 + 8 + 3 * 4) != sizeof(bad_child));
+        BkTree* corrupt = bk_tree_load(path);
+        wrong |= (corrupt != NULL);
+        bk_tree_free(corrupt);
+    }
+
+    if (wrong) {
+        failures++;
+        printf("FAILED!\n");
+    } else {
+        printf("PASSED (%ld within %d)\n", in_radius, radius);
+    }
+    bk_tree_free(built);
+    bk_tree_free(loaded);
+    if (fd >= 0) {
+        close(fd);
+        unlink(path);
+    }
+    fflush(stdout);
+}
+
+// Collects search hits into a growing array
+typedef struct {
+    SearchHit* hits;
+    size_t count;
+} HitCollector;
+
+static void collect_hit(const SearchHit* hit, void* user) {
+    HitCollector* collector = (HitCollector*)user;
+    collector->hits = realloc(collector->hits, (collector->count + 1) * sizeof(SearchHit));
+    collector->hits[collector->count++] = *hit;
+}
+
+// Approximate search against a plain semi-global DP, both in one shot on
+// NUM_THREADS threads and streamed in chunks of chunk characters
+static void run_test_search(const char* name, const char* pattern, const char* text, int k, size_t chunk) {
+    printf("Running Test: %s ... ", name);
+    fflush(stdout);
+
+    size_t m = strlen(pattern);
+    size_t n = strlen(text);
+    HitCollector expected = {NULL, 0};
+    int* column = malloc((m + 1) * sizeof(int));
+    for (size_t i = 0; i <= m; i++) column[i] = (int)i;
+    for (size_t j = 0; j < n; j++) {
+        int diagonal = 0;
+        column[0] = 0;
+        for (size_t i = 1; i <= m; i++) {
+            int up = column[i];
+            int best = diagonal + (pattern[i - 1] != text[j]);
+            if (up + 1 < best) best = up + 1;
+            if (column[i - 1] + 1 < best) best = column[i - 1] + 1;
+            diagonal = up;
+            column[i] = best;
+        }
+        if (column[m] <= k) {
+            SearchHit hit = {j + 1, column[m]};
+            collect_hit(&hit, &expected);
+        }
+    }
+    free(column);
+
+    HitCollector whole = {NULL, 0};
+    HitCollector streamed = {NULL, 0};
+    long found = approximate_search(pattern, m, text, n, k, NUM_THREADS, collect_hit, &whole);
+    ApproximateSearch* search = approximate_search_create(pattern, m, k);
+    for (size_t offset = 0; search != NULL && offset < n; offset += chunk) {
+        approximate_search_feed(search, text + offset, (n - offset < chunk) ? n - offset : chunk,
+            collect_hit, &streamed);
+    }
+    approximate_search_free(search);
+
+    int wrong = (found != (long)expected.count) || (whole.count != expected.count)
+        || (streamed.count != expected.count);
+    for (size_t h = 0; h < expected.count && !wrong; h++) {
+        wrong |= (whole.hits[h].end != expected.hits[h].end)
+            || (whole.hits[h].distance != expected.hits[h].distance)
+            || (streamed.hits[h].end != expected.hits[h].end)
+            || (streamed.hits[h].distance != expected.hits[h].distance);
+    }
+    if (wrong) {
+        failures++;
+        printf("FAILED!\n");
+        printf("Expected %zu hits, got %zu in one shot and %zu streamed\n", expected.count, whole.count,
+            streamed.count);
+    } else {
+        printf("PASSED (%zu hits)\n", expected.count);
+    }
+    free(expected.hits);
+    free(whole.hits);
+    free(streamed.hits);
+    fflush(stdout);
+}
+
+// Column stripes in separate processes against naive, with small tiles so
+// every stripe spans several tile columns and tile rows. A transport that
+// cannot be created must fail the call instead of hanging it
+static ShardTransport* no_transport(int num_links, size_t message_bytes) {
+    (void)num_links;
+    (void)message_bytes;
+    return NULL;
+}
+
+static void run_test_sharded(const char* name, const char* s1, const char* s2, long num_shards) {
+    printf("Running Test: %s ... ", name);
+    fflush(stdout);
+
+    size_t len1 = strlen(s1);
+    size_t len2 = strlen(s2);
+    WavefrontOptions options = {0};
+    options.tile_height = 64;
+    options.tile_width = 64;
+    long expected = naive_edit_distance_rect(s1, len1, s2, len2);
+    long r_shard = avx2_edit_distance_sharded(s1, len1, s2, len2, num_shards, &options, NULL);
+    long r_fail = avx2_edit_distance_sharded(s1, len1, s2, len2, num_shards, &options, no_transport);
+
+    if (r_shard != expected || (len1 > 0 && len2 > 0 && r_fail != -1)) {
+        failures++;
+        printf("FAILED!\n");
+        printf("Expected %ld, got %ld (%ld without a transport)\n", expected, r_shard, r_fail);
+    } else {
+        printf("PASSED (Result: %ld)\n", r_shard);
+    }
+    fflush(stdout);
+}
+
+// Barrier runs writing checkpoints: one killed as soon as its first
+// checkpoint is on disk and then resumed, one left to finish. Both must
+// match the plain run and leave no checkpoint behind
+static void run_test_checkpoint(const char* name, const char* s1, const char* s2, long every) {
+    printf("Running Test: %s ... ", name);
+    fflush(stdout);
+
+    size_t len1 = strlen(s1);
+    size_t len2 = strlen(s2);
+    char path[] = "/tmp/test_checkpoint_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0) {
+        close(fd);
+        unlink(path);
+    }
+    WavefrontOptions options = {WAVEFRONT_SCHEDULE_BARRIER, NULL, 0, 0, 64, 64};
+    long expected = avx2_edit_distance_rect(s1, len1, s2, len2, NUM_THREADS, &options);
+    options.checkpoint_path = path;
+    options.checkpoint_every = every;
+
+    long resumed_from = -1;
+    pid_t pid = fork();
+    if (pid == 0) {
+        avx2_edit_distance_rect(s1, len1, s2, len2, NUM_THREADS, &options);
+        _exit(0);
+    }
+    CheckpointHeader header;
+    for (int poll = 0; pid > 0 && poll < 10000; poll++) {
+        if (checkpoint_read_header(path, &header) > 0 || waitpid(pid, NULL, WNOHANG) == pid) {
+            break;
+        }
+        usleep(100);
+    }
+    if (pid > 0) {
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+        if (checkpoint_read_header(path, &header) > 0) {
+            resumed_from = (long)header.wave;
+        }
+    }
+    options.resume = 1;
+
+    // Other strings of the same lengths must not pick the checkpoint up
+    long r_other = -1;
+    if (resumed_from >= 0) {
+        char* other = malloc(len1 + 1);
+        memcpy(other, s1, len1 + 1);
+        other[len1 / 2] = (other[len1 / 2] == 'A') ? 'C' : 'A';
+        r_other = avx2_edit_distance_rect(other, len1, s2, len2, NUM_THREADS, &options);
+        free(other);
+    }
+    long r_resumed = avx2_edit_distance_rect(s1, len1, s2, len2, NUM_THREADS, &options);
+    int left_behind = (access(path, F_OK) == 0);
+    options.resume = 0;
+    long r_whole = avx2_edit_distance_rect(s1, len1, s2, len2, NUM_THREADS, &options);
+    left_behind |= (access(path, F_OK) == 0);
+
+    if (fd < 0 || r_resumed != expected || r_whole != expected || left_behind || r_other != -1) {
+        failures++;
+        printf("FAILED!\n");
+        printf("Expected %ld, resumed %ld, whole %ld, other strings %ld%s\n", expected, r_resumed,
+            r_whole, r_other, left_behind ? ", checkpoint left behind" : "");
+        unlink(path);
+    } else {
+        printf("PASSED (Result: %ld, resumed after wave %ld)\n", expected, resumed_from);
+    }
+    fflush(stdout);
+}
+
+// Builds s2 by appends of chunk characters, then replaces a character in
+// the middle and deletes one near the end, checking every step against
+// naive and that an append only computes its own columns
+static void run_test_incremental(const char* name, const char* s1, const char* s2, size_t chunk, size_t every) {
+    printf("Running Test: %s ... ", name);
+    fflush(stdout);
+
+    size_t len1 = strlen(s1);
+    size_t len2 = strlen(s2);
+    IncrementalDistance* incremental = incremental_create(s1, len1, every);
+    int wrong = (incremental == NULL);
+    for (size_t offset = 0; offset < len2 && !wrong; offset += chunk) {
+        size_t n = (len2 - offset < chunk) ? len2 - offset : chunk;
+        size_t columns = incremental_columns_computed(incremental);
+        long result = incremental_append(incremental, s2 + offset, n);
+        wrong |= (incremental_columns_computed(incremental) - columns != n);
+        wrong |= (result != naive_edit_distance_rect(s1, len1, s2, offset + n));
+    }
+    long r_edit = -1, r_delete = -1, e_edit = 0, e_delete = 0;
+    if (!wrong && len2 > 2) {
+        r_edit = incremental_edit(incremental, len2 / 2, 1, "#", 1);
+        e_edit = naive_edit_distance_rect(s1, len1, incremental_text(incremental), len2);
+        r_delete = incremental_edit(incremental, len2 - 2, 1, "", 0);
+        e_delete = naive_edit_distance_rect(s1, len1, incremental_text(incremental), len2 - 1);
+        wrong |= (r_edit != e_edit) || (r_delete != e_delete);
+    }
+
+    if (wrong) {
+        failures++;
+        printf("FAILED!\n");
+        printf("Edit: expected %ld, got %ld; delete: expected %ld, got %ld\n", e_edit, r_edit, e_delete, r_delete);
+    } else {
+        printf("PASSED (Result: %ld)\n", incremental_distance(incremental));
+    }
+    incremental_free(incremental);
+    fflush(stdout);
+}
+
+// Exact anchored mode has to match naive on the given engine; the
+// approximate mode may only overestimate
+static void run_test_anchored(const char* name, const char* s1, const char* s2, size_t anchor_length,
+    EditDistanceEngine engine) {
+    printf("Running Test: %s ... ", name);
+    fflush(stdout);
+
+    size_t len1 = strlen(s1);
+    size_t len2 = strlen(s2);
+    long expected = naive_edit_distance_rect(s1, len1, s2, len2);
+    AnchorStats stats;
+    AnchorOptions options = {ANCHOR_MODE_EXACT, anchor_length, engine, &stats};
+    long exact = anchored_edit_distance(s1, len1, s2, len2, NUM_THREADS, &options);
+    options.mode = ANCHOR_MODE_APPROXIMATE;
+    long approximate = anchored_edit_distance(s1, len1, s2, len2, NUM_THREADS, &options);
+
+    if (exact != expected || approximate < expected) {
+        failures++;
+        printf("FAILED!\n");
+        printf("Expected %ld, got %ld (approximate %ld)\n", expected, exact, approximate);
+    } else {
+        printf("PASSED (Result: %ld, approximate %ld, %zu anchors)\n", exact, approximate, stats.anchors);
+    }
+    fflush(stdout);
+}
+
 // Helper to generate long strings
 static char* make_string(size_t len, char fill) {
     char* str = malloc(len + 1);
@@ -106,6 +769,15 @@ int main(){
     char* s65_b = make_string(BLOCK_SIZE+1, 'B');
     run_test_expected("1 Over Block Size", s65_a, s65_b, BLOCK_SIZE+1);
 
+    /*
+    * Bit-vector word boundary tests
+    */
+    char* s65_w = make_string(65, 'A');
+    char* s65_v = make_string(65, 'A');
+    s65_v[63] = 'B';
+    s65_v[64] = 'B';
+    run_test_expected("Mismatch Across Word Boundary", s65_w, s65_v, 2);
+
     /*
     * Race condition tests
     */
@@ -113,10 +785,180 @@ int main(){
     char* s_long = make_string(2048, 'X');
     run_test_expected("Large Identical (Race Condition Check)", s_long, s_long, 0);
 
+    /*
+    * Bounded (banded) tests
+    */
+    char* s_near = make_string(2048, 'X');
+    s_near[100] = 'Y';
+    s_near[1500] = 'Y';
+    run_test_bounded("Bounded Within Limit", s_long, s_near, 5, 2);
+    run_test_bounded("Bounded Exact Limit", s_long, s_near, 2, 2);
+    run_test_bounded("Bounded Over Limit", s_long, s_near, 1, 2);
+    run_test_bounded("Bounded INT_MAX", s_long, s_near, INT_MAX, 2);
+    run_test_bounded("Bounded All Different", s65_a, s65_b, 10, 11);
+
+    /*
+    * Unequal length tests
+    */
+    run_test_rect("Empty vs Non-Empty", "", "ABC", 3);
+    run_test_rect("Kitten Sitting", "KITTEN", "SITTING", 3);
+    run_test_rect("Prefix", "HELLO", "HELLO WORLD", 6);
+
+    // Tall-skinny: 2048 rows against a 100 column string that matches its start
+    char* s_short = make_string(100, 'X');
+    run_test_rect("Tall Skinny", s_long, s_short, 2048 - 100);
+    run_test_rect("Short Wide", s_short, s_long, 2048 - 100);
+
+    // Non-square tiles, as picked by the tile tuner
+    run_test_shape("Tall Tiles", s_long, s_near, 1024, 128);
+    run_test_shape("Wide Tiles", s_long, s_near, 64, 2048);
+    run_test_shape("Uneven Tiles", s_near, s_long, 300, 77);
+
+    // Workers pinned to cores, each owning a set of tile columns
+    run_test_pinned("Pinned Workers", s_long, s_near);
+    run_test_pinned("Pinned Tall Skinny", s_long, s_short);
+
+    // One reusable workspace for repeated calls
+    run_test_context("Context Reuse", s_long, s_near);
+    run_test_context("Context Tall Skinny", s_long, s_short);
+
+    /*
+    * Alignment tests
+    */
+    run_test_align("Align Kitten Sitting", "KITTEN", "SITTING");
+    run_test_align("Align Empty", "", "ABC");
+    run_test_align("Align Two Substitutions", s_long, s_near);
+    run_test_align("Align Tall Skinny", s_long, s_short);
+
+    // Input read in pieces, as from a mapped FASTA file
+    run_test_segments("Segmented Lines", s_near, s_long, 60);
+    run_test_segments("Segmented Short Lines", s_long, s_near, 7);
+
+    /*
+    * Batch tests
+    */
+    // Mixes empty, swapped, short and long pairs; the 40000 character pair
+    // is too long for the 16-bit lanes.
+    char* s_huge = make_string(40000, 'X');
+    s_huge[20000] = 'Y';
+    EditPair pairs[40];
+    for (int i = 0; i < 40; i++) {
+        pairs[i].str1 = s_near;
+        pairs[i].len1 = (size_t)(i * 50);
+        pairs[i].str2 = s_long;
+        pairs[i].len2 = (size_t)((i * 37) % 2048);
+    }
+    pairs[0] = (EditPair){"", 0, "ABC", 3};
+    pairs[1] = (EditPair){"KITTEN", 6, "SITTING", 7};
+    pairs[2] = (EditPair){"SITTING", 7, "KITTEN", 6};
+    pairs[3] = (EditPair){s_huge, 40000, s_short, 100};
+    pairs[4] = (EditPair){s_long, 2048, s_huge, 40000};
+    run_test_batch("Batch Mixed Lengths", pairs, 40);
+
+    // The same pairs as thresholded queries, filtered before the DP
+    run_test_filter("Filter Tight Threshold", pairs, 40, 3);
+    run_test_filter("Filter Loose Threshold", pairs, 40, 1000);
+
+    // Random bytes against their reverse: same histogram, few shared
+    // q-grams, and more of them than a small fixed table has buckets
+    size_t scrambled_len = 20000;
+    char* s_scrambled = malloc(scrambled_len);
+    char* s_reversed = malloc(scrambled_len);
+    unsigned int scramble_seed = 7;
+    for (size_t i = 0; i < scrambled_len; i++) {
+        scramble_seed = scramble_seed * 1103515245u + 12345u;
+        s_scrambled[i] = (char)(1 + (scramble_seed >> 16) % 255);
+    }
+    for (size_t i = 0; i < scrambled_len; i++) {
+        s_reversed[i] = s_scrambled[scrambled_len - 1 - i];
+    }
+    run_test_filter_stage("Filter Long Q-Gram Pair", s_scrambled, scrambled_len, s_reversed,
+        scrambled_len, 2500, FILTER_STAGE_QGRAM);
+    free(s_scrambled);
+    free(s_reversed);
+
+    /*
+    * Dictionary index tests
+    */
+    // Duplicates, an empty word and words past one 64-bit block
+    const char* words[] = {"KITTEN", "SITTING", "MITTEN", "KITCHEN", "SITTER", "BITTEN", "KITTEN", "",
+        "WRITTEN", "SMITTEN", "KNITTING", "FITTING", "HITTING", "KIT", "TEN", "SIT",
+        "XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXKITTEN",
+        "XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX"};
+    run_test_bk_tree("BK-Tree Near Query", words, 18, "KITTENS", 5, 2);
+    run_test_bk_tree("BK-Tree Long Query", words, 18,
+        "XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXSITTEN", 3, 8);
+
+    /*
+    * Approximate search tests
+    */
+    // A text long enough for the interleaved columns, with a few planted
+    // copies of the patterns (one of them edited) among random letters
+    size_t text_len = 60000;
+    char* s_text = malloc(text_len + 1);
+    unsigned int seed = 12345;
+    for (size_t i = 0; i < text_len; i++) {
+        seed = seed * 1103515245u + 12345u;
+        s_text[i] = "ACGT"[(seed >> 16) % 4];
+    }
+    s_text[text_len] = '\0';
+    memcpy(s_text + 100, "GATTACAGATTACA", 14);
+    memcpy(s_text + 29990, "GATTCAGATTACA", 13);
+    char* s_pattern = malloc(101);
+    memcpy(s_pattern, s_text + 45000, 100);
+    s_pattern[100] = '\0';
+    s_text[45050] = 'N';
+    run_test_search("Search Short Pattern", "GATTACAGATTACA", s_text, 2, 4093);
+    run_test_search("Search Long Pattern", s_pattern, s_text, 12, 7);
+
+    /*
+    * Multi-process tests
+    */
+    run_test_sharded("Sharded Kitten Sitting", "KITTEN", "SITTING", 4);
+    char* s_stripe = malloc(3001);
+    memcpy(s_stripe, s_text + 44000, 3000);
+    s_stripe[3000] = '\0';
+    run_test_sharded("Sharded Uneven Stripes", s_stripe, s_text + 50000, 3);
+
+    /*
+    * Checkpoint tests
+    */
+    run_test_checkpoint("Checkpoint Every Wave", s_stripe, s_text + 50000, 1);
+    run_test_checkpoint("Checkpoint Every 7 Waves", s_text + 20000, s_stripe, 7);
+
+    /*
+    * Incremental tests
+    */
+    run_test_incremental("Incremental Appends", s_pattern, s_stripe, 97, 64);
+    run_test_incremental("Incremental Long Pattern", s_stripe, s_pattern, 1, 0);
+
+    /*
+    * Anchored tests
+    */
+    char* s_moved = malloc(3001);
+    memcpy(s_moved, s_stripe, 1000);
+    memcpy(s_moved + 1000, s_stripe + 1100, 1400);
+    memcpy(s_moved + 2400, s_stripe + 1000, 100);
+    memcpy(s_moved + 2500, s_stripe + 2500, 501);
+    s_moved[300] = 'N';
+    run_test_anchored("Anchored Moved Block", s_stripe, s_moved, 16, simd_edit_distance_rect);
+    run_test_anchored("Anchored No Unique Pieces", s_long, s_near, 0, bitparallel_edit_distance_threads);
+    EditPair near_pairs[4] = {
+        {s_stripe, 3000, s_moved, 3000},
+        {s_long, 2048, s_near, 2048},
+        {s_stripe, 1200, s_stripe, 1200},
+        {s_stripe, 2999, s_stripe + 1, 2999}
+    };
+    run_test_batch("Batch Near-Identical", near_pairs, 4);
+
     // Cleanup
     free(s63_a); free(s63_b);
     free(s64_a); free(s64_b);
     free(s65_a); free(s65_b);
-    free(s_long);
-    return 0;
+    free(s65_w); free(s65_v);
+    free(s_long); free(s_near);
+    free(s_short); free(s_huge);
+    free(s_text); free(s_pattern);
+    free(s_stripe); free(s_moved);
+    return failures ? 1 : 0;
 }
\ No newline at end of file
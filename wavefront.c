@@ -0,0 +1,1171 @@
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include "src/wavefront.h"
+#include "src/worker_pool.h"
+#include "src/threadarguments.h"
+#include "src/perf_counters.h"
+#include "src/trace.h"
+#include "src/cpu_topology.h"
+#include "src/ed_context.h"
+#include "src/mapped_input.h"
+#include "src/boundary.h"
+#include "src/checkpoint.h"
+#include "src/common_affix.h"
+
+/*
+* Tall-skinny inputs: the short side is split so that every thread gets at
+* least this many tiles along it, but tiles never get narrower than
+* MIN_TILE_SIZE (one bit-vector word, a couple of SIMD vectors).
+*/
+#define TILES_PER_THREAD 2
+#define MIN_TILE_SIZE 64
+
+/*
+* Slack after each gathered tile string (segmented inputs), and the
+* alignment of the first one.
+*/
+#define GATHER_PADDING 64
+
+/*
+* Ready queue of one worker. The owner pushes and pops at the tail (LIFO, so
+* it keeps working along the row it just advanced), thieves take from the
+* head. At most one tile per tile row can be ready at any time, so a ring of
+* row_blocks entries never overflows.
+*/
+struct TileDeque {
+	pthread_mutex_t lock;
+	long *tiles;
+	long capacity;
+	long head;
+	long tail;
+};
+
+static double current_time_ms(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1000 + (double)ts.tv_nsec / 1e6;
+}
+
+static void deque_push(TileDeque *deque, long tile){
+	pthread_mutex_lock(&deque->lock);
+	deque->tiles[deque->tail % deque->capacity] = tile;
+	deque->tail++;
+	pthread_mutex_unlock(&deque->lock);
+}
+
+/*
+* Owner end. Returns -1 if the deque is empty.
+*/
+static long deque_pop(TileDeque *deque){
+	long tile = -1;
+	pthread_mutex_lock(&deque->lock);
+	if(deque->tail > deque->head){
+		deque->tail--;
+		tile = deque->tiles[deque->tail % deque->capacity];
+	}
+	pthread_mutex_unlock(&deque->lock);
+	return tile;
+}
+
+/*
+* Thief end. Returns -1 if the deque is empty.
+*/
+static long deque_steal(TileDeque *deque){
+	long tile = -1;
+	pthread_mutex_lock(&deque->lock);
+	if(deque->tail > deque->head){
+		tile = deque->tiles[deque->head % deque->capacity];
+		deque->head++;
+	}
+	pthread_mutex_unlock(&deque->lock);
+	return tile;
+}
+
+/*
+* Returns 1 if tile (r, c) exists and, in bounded mode, holds at least one
+* cell (i, j) with |i - j| <= max_distance. Tiles outside the band are never
+* run: every cell in them is known to exceed the bound.
+*/
+static int tile_in_band(const ThreadArguments *data, int r, int c){
+	if(r < 0 || c < 0 || r >= data->row_blocks || c >= data->col_blocks){
+		return 0;
+	}
+	if(!data->bounded){
+		return 1;
+	}
+	long long height = data->tile_height;
+	long long width = data->tile_width;
+	long long len1 = data->len1;
+	long long len2 = data->len2;
+	long long first_row = r * height + 1;
+	long long last_row = (r * height + height < len1) ? (r * height + height) : len1;
+	long long first_col = c * width + 1;
+	long long last_col = (c * width + width < len2) ? (c * width + width) : len2;
+	return (first_col - last_row <= data->max_distance)
+		&& (first_row - last_col <= data->max_distance);
+}
+
+static void fill_bound(int *values, int count, int limit){
+	for(int i = 1; i <= count; i++){
+		values[i] = limit;
+	}
+}
+
+/*
+* Bounded mode: caps a freshly written boundary at limit (so it holds
+* min(distance, max_distance + 1) exactly, which keeps the neighbouring
+* deltas in {-1, 0, 1} for the bit-vector kernel) and returns its minimum.
+*/
+static int clamp_bound(int *values, int count, int limit){
+	int minimum = limit;
+	for(int i = 1; i <= count; i++){
+		if(values[i] > limit){
+			values[i] = limit;
+		}
+		if(values[i] < minimum){
+			minimum = values[i];
+		}
+	}
+	return minimum;
+}
+
+/*
+* Bounded mode: records the minimum of a finished tile's last row. Once all
+* band tiles of a tile row are done and none of their bottom cells is within
+* the bound, no path can reach the last cell within it either, so the run is
+* aborted. aborted holds the wave the abort was detected in, plus one, so
+* the barrier schedule can stop every worker after the same wave.
+*/
+static void finish_bounded_tile(ThreadArguments *data, int r, int c, int bottom_min){
+	int current = atomic_load(&data->row_min[r]);
+	while(bottom_min < current
+		&& !atomic_compare_exchange_weak(&data->row_min[r], &current, bottom_min));
+
+	if(atomic_fetch_sub(&data->row_remaining[r], 1) == 1
+		&& atomic_load(&data->row_min[r]) > data->max_distance){
+		int not_aborted = 0;
+		atomic_compare_exchange_strong(&data->aborted, &not_aborted, r + c + 1);
+	}
+}
+
+/*
+* Points s1 and s2 at the tile's characters, gathering them out of the
+* segment maps into the scratch when the strings are in pieces.
+*/
+static void tile_strings(const ThreadArguments *data, size_t row_offset, size_t col_offset,
+	int height, int width, void *scratch, const char **s1, const char **s2){
+	char *gather = (char*)scratch + data->gather_offset;
+	if(data->segments1 != NULL){
+		segment_map_copy(data->segments1, row_offset, height, gather);
+		*s1 = gather;
+	}
+	else{
+		*s1 = data->str1 + row_offset;
+	}
+	if(data->segments2 != NULL){
+		char *gather2 = gather + data->tile_height + GATHER_PADDING;
+		segment_map_copy(data->segments2, col_offset, width, gather2);
+		*s2 = gather2;
+	}
+	else{
+		*s2 = data->str2 + col_offset;
+	}
+}
+
+/*
+* Wide mode version of run_tile() (never bounded). The tile's slices of the
+* long boundaries are copied into int buffers relative to its corner; every
+* value in a tile is within height + width of the corner, so the kernel
+* runs with a corner of 0 and its results are shifted back on the way out.
+*/
+static void run_wide_tile(ThreadArguments *data, int r, int c, size_t row_offset,
+	size_t col_offset, int height, int width, void *scratch){
+	long *rows_read, *rows_write;
+	long *cols = &data->wide_cols[row_offset];
+	if(data->schedule == WAVEFRONT_SCHEDULE_BARRIER){
+		rows_read = data->wide_rows[(r-1+3) % 3];
+		rows_write = data->wide_rows[r % 3];
+	}
+	else{
+		rows_read = data->wide_rows[0];
+		rows_write = data->wide_rows[0];
+	}
+
+	// Same corner logic as run_tile(), every neighbour is in the band
+	long corner;
+	if(col_offset == 0){
+		corner = row_offset;
+	}
+	else if(row_offset == 0){
+		corner = col_offset;
+	}
+	else if(data->schedule == WAVEFRONT_SCHEDULE_BARRIER){
+		corner = rows_read[col_offset];
+	}
+	else{
+		corner = data->corners[r];
+	}
+	if(data->schedule == WAVEFRONT_SCHEDULE_DATAFLOW){
+		data->corners[r] = rows_read[col_offset + width];
+	}
+
+	int *top = (int*)((char*)scratch + data->wide_offset);
+	int *left = top + data->tile_width + 1;
+	for(int j = 1; j <= width; j++){
+		top[j] = (int)(rows_read[col_offset + j] - corner);
+	}
+	for(int i = 1; i <= height; i++){
+		left[i] = (int)(cols[i] - corner);
+	}
+
+	const char *s1, *s2;
+	tile_strings(data, row_offset, col_offset, height, width, scratch, &s1, &s2);
+	data->process_tile(top, left, top, left, 0, height, width, s1, s2, scratch);
+
+	for(int j = 1; j <= width; j++){
+		rows_write[col_offset + j] = top[j] + corner;
+	}
+	for(int i = 1; i <= height; i++){
+		cols[i] = left[i] + corner;
+	}
+}
+
+/*
+* Helper function to run the kernel on tile (r, c) with the right slices of
+* the global boundary arrays.
+*/
+static void run_tile(ThreadArguments *data, int r, int c, void *scratch){
+	size_t row_offset = (size_t)r * data->tile_height;
+	size_t col_offset = (size_t)c * data->tile_width;
+
+	/*
+	* Handle edge case where there are not enough elements
+	* left to create a full size tile.
+	*/
+	int height = (row_offset + data->tile_height > data->len1)
+	? (data->len1 - row_offset) : data->tile_height;
+	int width = (col_offset + data->tile_width > data->len2)
+	? (data->len2 - col_offset) : data->tile_width;
+	if(data->wide){
+		run_wide_tile(data, r, c, row_offset, col_offset, height, width, scratch);
+		return;
+	}
+
+	int *rows_read, *rows_write;
+	int *cols = &data->global_cols[row_offset];
+	int limit = data->max_distance + 1;
+	if(data->schedule == WAVEFRONT_SCHEDULE_BARRIER){
+		/*
+		* Read from (r-1) % 3, write to r % 3 (add 3 to deal with
+		* the negative)
+		*/
+		rows_read = data->global_rows[(r-1+3) % 3];
+		rows_write = data->global_rows[r % 3];
+	}
+	else{
+		/*
+		* Tiles of a column run strictly top to bottom, so a single row
+		* buffer is enough.
+		*/
+		rows_read = data->global_rows[0];
+		rows_write = data->global_rows[0];
+	}
+
+	/*
+	* Bounded mode: neighbours outside the band were never run, so their
+	* boundary cells are filled in with the bound instead.
+	*/
+	if(data->bounded){
+		if(r > 0 && !tile_in_band(data, r - 1, c)){
+			fill_bound(&rows_read[col_offset], width, limit);
+		}
+		if(c > 0 && !tile_in_band(data, r, c - 1)){
+			fill_bound(cols, height, limit);
+		}
+	}
+
+	// Initialize the corner separately
+	int corner;
+	if(col_offset == 0){
+		// Grab the value from the left
+		corner = row_offset;
+	}
+	else if(row_offset == 0){
+		// Grab the value from the top
+		corner = col_offset;
+	}
+	else if(!tile_in_band(data, r - 1, c - 1)){
+		corner = limit;
+	}
+	else if(data->schedule == WAVEFRONT_SCHEDULE_BARRIER || !tile_in_band(data, r, c - 1)){
+		/*
+		* Safe read because the neighboring tile to the left writes to
+		* rows_write, not rows_read (or, in the dataflow schedule, never
+		* ran).
+		*/
+		corner = rows_read[col_offset];
+	}
+	else{
+		/*
+		* Dataflow: the single row buffer already holds the bottom row of
+		* tile (r, c-1) here, so use what that tile saw above its own last
+		* column.
+		*/
+		corner = data->corners[r];
+	}
+	if(data->schedule == WAVEFRONT_SCHEDULE_DATAFLOW){
+		data->corners[r] = rows_read[col_offset + width];
+	}
+	if(data->bounded && corner > limit){
+		corner = limit;
+	}
+
+	const char *s1, *s2;
+	tile_strings(data, row_offset, col_offset, height, width, scratch, &s1, &s2);
+
+	data->process_tile(&rows_read[col_offset], cols, &rows_write[col_offset],
+		cols, corner, height, width, s1, s2, scratch);
+
+	if(data->bounded){
+		clamp_bound(cols, height, limit);
+		int bottom_min = clamp_bound(&rows_write[col_offset], width, limit);
+		finish_bounded_tile(data, r, c, bottom_min);
+	}
+}
+
+/*
+* Writes the initial values of row 0 at columns from..to into every row
+* buffer, capped at the bound in bounded mode.
+*/
+static void init_row_bounds(ThreadArguments *data, size_t from, size_t to){
+	int limit = data->max_distance + 1;
+	for(size_t j = from; j <= to; j++){
+		int value = (data->bounded && j > (size_t)limit) ? limit : (int)j;
+		for(int k = 0; k < 3; k++){
+			if(data->global_rows[k] != NULL){
+				data->global_rows[k][j] = value;
+			}
+			if(data->wide_rows[k] != NULL){
+				data->wide_rows[k][j] = j;
+			}
+		}
+	}
+}
+
+/*
+* Same for column 0 at rows from..to.
+*/
+static void init_col_bounds(ThreadArguments *data, size_t from, size_t to){
+	int limit = data->max_distance + 1;
+	for(size_t i = from; i <= to; i++){
+		if(data->wide){
+			data->wide_cols[i] = i;
+		}
+		else{
+			data->global_cols[i] = (data->bounded && i > (size_t)limit) ? limit : (int)i;
+		}
+	}
+}
+
+/*
+* Pinned mode, run once before the schedule: every worker initializes the
+* row boundary under its own tile columns, so those pages are first-touched
+* on its node. The column boundary is passed along by every worker of a
+* tile row, so its tile rows are spread over the workers instead.
+*/
+static void touch_worker(void *args, int thread_id, void *scratch){
+	(void)scratch;
+	ThreadArguments *data = (ThreadArguments*)args;
+	for(int c = thread_id; c < data->col_blocks; c += data->num_threads){
+		size_t from = (c == 0) ? 0 : (size_t)c * data->tile_width + 1;
+		size_t to = (size_t)(c + 1) * data->tile_width;
+		init_row_bounds(data, from, (to < data->len2) ? to : data->len2);
+	}
+	for(int r = thread_id; r < data->row_blocks; r += data->num_threads){
+		size_t from = (r == 0) ? 0 : (size_t)r * data->tile_height + 1;
+		size_t to = (size_t)(r + 1) * data->tile_height;
+		init_col_bounds(data, from, (to < data->len1) ? to : data->len1);
+	}
+}
+
+/*
+* Copies the state after wave between the boundary buffers and a
+* checkpoint snapshot (see checkpoint.h), into the snapshot or, with
+* restore set, back out of it. Tile columns and tile rows first, first +
+* stride, ... are copied, so the workers can split a snapshot between them.
+* With the barrier schedule's three row buffers, the bottom row of tile
+* row r is in buffer r % 3; the corner tile (r, c) needs is in buffer
+* (r - 1) % 3 at column c * tile_width, where no frontier segment lands.
+*/
+static void copy_frontier(ThreadArguments *data, long wave, int first, int stride, int restore){
+	size_t entry = boundary_entry_size(data->wide);
+	char *buffers[3];
+	for(int k = 0; k < 3; k++){
+		buffers[k] = data->wide ? (char*)data->wide_rows[k] : (char*)data->global_rows[k];
+	}
+	char *cols = data->wide ? (char*)data->wide_cols : (char*)data->global_cols;
+	char *snapshot_rows = checkpointer_rows(data->checkpointer);
+	char *snapshot_cols = checkpointer_cols(data->checkpointer);
+	char *snapshot_corners = checkpointer_corners(data->checkpointer);
+
+	for(int c = first; c < data->col_blocks; c += stride){
+		long r = wave - c;
+		if(r < 0){
+			// Not started: every buffer still holds row 0
+			if(restore){
+				continue;
+			}
+			r = 0;
+		}
+		if(r >= data->row_blocks){
+			r = data->row_blocks - 1;
+		}
+		size_t from = (c == 0) ? 0 : (size_t)c * data->tile_width + 1;
+		size_t to = (size_t)(c + 1) * data->tile_width;
+		to = (to < data->len2) ? to : data->len2;
+		char *buffer = buffers[r % 3] + from * entry;
+		char *saved = snapshot_rows + from * entry;
+		memcpy(restore ? buffer : saved, restore ? saved : buffer, (to - from + 1) * entry);
+	}
+
+	for(int r = first; r < data->row_blocks; r += stride){
+		size_t from = (r == 0) ? 0 : (size_t)r * data->tile_height + 1;
+		size_t to = (size_t)(r + 1) * data->tile_height;
+		to = (to < data->len1) ? to : data->len1;
+		char *column = cols + from * entry;
+		char *saved = snapshot_cols + from * entry;
+		memcpy(restore ? column : saved, restore ? saved : column, (to - from + 1) * entry);
+
+		long c = wave + 1 - r;
+		if(r >= 1 && c >= 1 && c < data->col_blocks){
+			char *corner = buffers[(r - 1) % 3] + (size_t)c * data->tile_width * entry;
+			saved = snapshot_corners + (size_t)r * entry;
+			memcpy(restore ? corner : saved, restore ? saved : corner, entry);
+		}
+	}
+}
+
+/*
+* Folds one of the run's strings into the checkpoint fingerprint, read
+* through its segment map in chunks when it has one.
+*/
+static uint64_t fingerprint_string(uint64_t hash, const char *str, const SegmentMap *map, size_t len){
+	if(map == NULL){
+		return checkpoint_fingerprint(hash, str, len);
+	}
+	char chunk[4096];
+	for(size_t from = 0; from < len; from += sizeof(chunk)){
+		size_t count = (len - from < sizeof(chunk)) ? len - from : sizeof(chunk);
+		segment_map_copy(map, from, count, chunk);
+		hash = checkpoint_fingerprint(hash, chunk, count);
+	}
+	return hash;
+}
+
+static int is_checkpoint_wave(const ThreadArguments *data, int wave){
+	return data->checkpointer != NULL && data->checkpoint_every > 0
+		&& (wave + 1) % data->checkpoint_every == 0
+		&& wave + 1 < data->row_blocks + data->col_blocks - 1;
+}
+
+/*
+* Barrier schedule. Walks all the diagonal waves, processes the tiles of
+* each wave assigned to this thread, and meets the other workers at a
+* barrier before moving on to the next wave.
+*/
+static void wave_worker(void *args, int thread_id, void *scratch){
+	/*
+	* In this program, args is guaranteed to originally be of
+	* type ThreadArguments. So, casting is safe.
+	*/
+	ThreadArguments *data = (ThreadArguments*)args;
+	int rows = data->row_blocks;
+	int cols = data->col_blocks;
+	int num_waves = rows + cols - 1;
+	double busy = 0;
+	PerfThread perf;
+	perf_thread_begin(&perf, thread_id);
+
+	for(int wave = data->first_wave; wave < num_waves; wave++){
+		// Calculate diagonal bounds
+		int row_min = (wave < cols) ? 0 : (wave - cols + 1);
+		int row_max = (wave < rows) ? wave : (rows - 1);
+
+		/*
+		* Iterate through every tile in this wave
+		*/
+		int tile_number = 0;
+		for(int r = row_min; r <= row_max; r++){
+			if(!tile_in_band(data, r, wave - r)){
+				continue;
+			}
+
+			/*
+			* Only process this tile at (r, wave - r) if it is
+			* "assigned" to this thread.
+			* Ensures nearly equal spreading of work (eliminating
+			* performance bottlenecks in which one thread has more
+			* work than the others). Pinned workers own whole tile
+			* columns instead, which spreads a wave just as evenly
+			* since its tiles sit in consecutive columns.
+			*/
+			int owner = data->pinned ? (wave - r) : tile_number;
+			if(owner % data->num_threads == thread_id){
+				double start = current_time_ms();
+				uint64_t traced = trace_now();
+				perf_tile_begin(&perf);
+				run_tile(data, r, wave - r, scratch);
+				perf_tile_end(&perf);
+				trace_record(thread_id, TRACE_TILE, traced, r, wave - r);
+				busy += current_time_ms() - start;
+			}
+			tile_number++;
+		}
+
+		/*
+		* Whether to checkpoint after this wave is settled before the
+		* barrier, so every worker sees the same answer after it.
+		*/
+		int checkpoint = is_checkpoint_wave(data, wave);
+		if(checkpoint && thread_id == 0){
+			atomic_store(&data->take_checkpoint[wave % 2], checkpointer_ready(data->checkpointer));
+		}
+
+		/*
+		* Ensure synchronization. This wave should be finished before
+		* moving to the next.
+		*/
+		uint64_t wait = trace_now();
+		worker_pool_barrier(data->pool);
+		trace_record(thread_id, TRACE_BARRIER_WAIT, wait, wave, 0);
+
+		/*
+		* The workers copy the snapshot together and wait for each other
+		* once more before touching the buffers again; the writer thread
+		* takes it from there.
+		*/
+		if(checkpoint && atomic_load(&data->take_checkpoint[wave % 2])){
+			copy_frontier(data, wave, thread_id, data->num_threads, 0);
+			worker_pool_barrier(data->pool);
+			if(thread_id == 0){
+				checkpointer_submit(data->checkpointer, wave);
+			}
+		}
+
+		/*
+		* Only an abort from this wave or earlier counts; one raised by a
+		* faster worker already in the next wave is picked up after the
+		* next barrier, so all workers leave after the same wave.
+		*/
+		int aborted = atomic_load(&data->aborted);
+		if(aborted != 0 && aborted - 1 <= wave){
+			break;
+		}
+	}
+	perf_thread_end(&perf);
+	data->busy_ms[thread_id] = busy;
+	data->steals[thread_id] = 0;
+}
+
+/*
+* Deque a newly ready tile in column c goes to: its column owner's in
+* pinned mode, the releasing worker's own otherwise.
+*/
+static TileDeque *column_deque(ThreadArguments *data, int c, TileDeque *own){
+	return data->pinned ? &data->deques[c % data->num_threads] : own;
+}
+
+/*
+* Pushes the next tile of row r if it is ready: its left neighbor is done,
+* and so is the one above it (or, if that one is right of the band, the
+* last tile of the row above, whose bottom-right cell is the corner). Two
+* workers finishing its two dependencies at once may both see it ready, so
+* the release is claimed on row_next.
+*/
+static void release_next(ThreadArguments *data, int r, TileDeque *own){
+	if(r >= data->row_blocks){
+		return;
+	}
+	int c = atomic_load(&data->row_next[r]);
+	if(c >= data->row_end[r] || atomic_load(&data->row_done[r]) < c){
+		return;
+	}
+	if(r > 0){
+		int above = (c + 1 < data->row_end[r - 1]) ? c + 1 : data->row_end[r - 1];
+		if(atomic_load(&data->row_done[r - 1]) < above){
+			return;
+		}
+	}
+	if(atomic_compare_exchange_strong(&data->row_next[r], &c, c + 1)){
+		deque_push(column_deque(data, c, own), (long)r * data->col_blocks + c);
+		worker_pool_notify(data->pool);
+	}
+}
+
+/*
+* Dataflow schedule. Runs ready tiles from this worker's deque, steals from
+* the other workers when it runs dry, and releases the tiles below and to
+* the right of every tile it finishes.
+*/
+static void dataflow_worker(void *args, int thread_id, void *scratch){
+	ThreadArguments *data = (ThreadArguments*)args;
+	int n = data->col_blocks;
+	long num_threads = data->num_threads;
+	TileDeque *own = &data->deques[thread_id];
+	double busy = 0;
+	long steals = 0;
+	PerfThread perf;
+	perf_thread_begin(&perf, thread_id);
+
+	/*
+	* Start of the current stretch without a ready tile, for the trace
+	*/
+	int idle = 0;
+	uint64_t idle_start = 0;
+
+	for(;;){
+		unsigned int ticket = worker_pool_work_ticket(data->pool);
+		long tile = deque_pop(own);
+		int stolen = 0;
+		for(int pass = 0; tile < 0 && pass < 2; pass++){
+			/*
+			* Pinned workers steal from their own node first.
+			*/
+			for(long k = 1; tile < 0 && k < num_threads; k++){
+				long victim = (thread_id + k) % num_threads;
+				if(data->thread_nodes != NULL
+					&& (data->thread_nodes[victim] == data->thread_nodes[thread_id]) != (pass == 0)){
+					continue;
+				}
+				tile = deque_steal(&data->deques[victim]);
+				if(tile >= 0){
+					steals++;
+					stolen = 1;
+				}
+			}
+			if(data->thread_nodes == NULL){
+				break;
+			}
+		}
+
+		if(atomic_load(&data->aborted)){
+			break;
+		}
+		if(tile < 0){
+			if(atomic_load(&data->tiles_done) == data->total_tiles){
+				break;
+			}
+			if(!idle){
+				idle = 1;
+				idle_start = trace_now();
+			}
+			// Nothing ready anywhere yet; wait until a tile is released
+			worker_pool_wait(data->pool, ticket);
+			continue;
+		}
+		if(idle){
+			trace_record(thread_id, TRACE_IDLE, idle_start, stolen, 0);
+			idle = 0;
+		}
+
+		int r = tile / n;
+		int c = tile % n;
+		double start = current_time_ms();
+		uint64_t traced = trace_now();
+		perf_tile_begin(&perf);
+		run_tile(data, r, c, scratch);
+		perf_tile_end(&perf);
+		trace_record(thread_id, TRACE_TILE, traced, r, c);
+		busy += current_time_ms() - start;
+		if(atomic_fetch_add(&data->tiles_done, 1) + 1 == data->total_tiles
+			|| atomic_load(&data->aborted)){
+			// Wake the idle workers so they see the run is over
+			worker_pool_notify(data->pool);
+		}
+
+		/*
+		* Release the dependents. The right neighbor is pushed last so
+		* this worker picks it up next and stays on the same tile row.
+		* Pinned workers hand every tile to the owner of its column
+		* instead.
+		*/
+		atomic_store(&data->row_done[r], c + 1);
+		release_next(data, r + 1, own);
+		release_next(data, r, own);
+	}
+	if(idle){
+		trace_record(thread_id, TRACE_IDLE, idle_start, 0, 0);
+	}
+	perf_thread_end(&perf);
+	data->busy_ms[thread_id] = busy;
+	data->steals[thread_id] = steals;
+}
+
+/*
+* Allocates the per-row progress counters, deques and corner slots the
+* dataflow schedule needs and seeds worker 0 with tile (0, 0).
+* Returns -1 if memory could not be allocated.
+*/
+static int setup_dataflow(ThreadArguments *args){
+	int rows = args->row_blocks;
+	int cols = args->col_blocks;
+	long num_threads = args->num_threads;
+
+	args->row_done = ed_context_alloc_or_malloc(args->context, rows * sizeof(atomic_int));
+	args->row_next = ed_context_alloc_or_malloc(args->context, rows * sizeof(atomic_int));
+	args->row_end = ed_context_alloc_or_malloc(args->context, rows * sizeof(int));
+	args->deques = ed_context_alloc_zeroed_or_calloc(args->context, num_threads, sizeof(TileDeque));
+	args->corners = ed_context_alloc_zeroed_or_calloc(args->context, rows, sizeof(long));
+	if(args->row_done == NULL || args->row_next == NULL || args->row_end == NULL
+		|| args->deques == NULL || args->corners == NULL){
+		return -1;
+	}
+
+	/*
+	* The tiles of a row that are in the band are contiguous.
+	*/
+	for(int r = 0; r < rows; r++){
+		int first = 0;
+		while(first < cols && !tile_in_band(args, r, first)){
+			first++;
+		}
+		int end = first;
+		while(end < cols && tile_in_band(args, r, end)){
+			end++;
+		}
+		atomic_init(&args->row_done[r], first);
+		atomic_init(&args->row_next[r], first);
+		args->row_end[r] = end;
+	}
+	for(long t = 0; t < num_threads; t++){
+		pthread_mutex_init(&args->deques[t].lock, NULL);
+		args->deques[t].capacity = rows;
+		args->deques[t].tiles = ed_context_alloc_or_malloc(args->context, rows * sizeof(long));
+		if(args->deques[t].tiles == NULL){
+			return -1;
+		}
+	}
+	atomic_init(&args->tiles_done, 0);
+	atomic_store(&args->row_next[0], 1);
+	deque_push(&args->deques[0], 0);
+	return 0;
+}
+
+/*
+* Counts the tiles that will run and, in bounded mode, allocates the
+* per-tile-row early exit bookkeeping.
+* Returns -1 if memory could not be allocated.
+*/
+static int setup_band(ThreadArguments *args){
+	int rows = args->row_blocks;
+	args->total_tiles = 0;
+	if(args->bounded){
+		args->row_min = ed_context_alloc_or_malloc(args->context, rows * sizeof(atomic_int));
+		args->row_remaining = ed_context_alloc_or_malloc(args->context, rows * sizeof(atomic_int));
+		if(args->row_min == NULL || args->row_remaining == NULL){
+			return -1;
+		}
+	}
+	for(int r = 0; r < rows; r++){
+		int in_band = 0;
+		for(int c = 0; c < args->col_blocks; c++){
+			in_band += tile_in_band(args, r, c);
+		}
+		if(args->bounded){
+			atomic_init(&args->row_min[r], args->max_distance + 1);
+			atomic_init(&args->row_remaining[r], in_band);
+		}
+		args->total_tiles += in_band;
+	}
+	atomic_init(&args->aborted, 0);
+	return 0;
+}
+
+static void cleanup_dataflow(ThreadArguments *args){
+	if(args->deques != NULL){
+		for(long t = 0; t < args->num_threads; t++){
+			pthread_mutex_destroy(&args->deques[t].lock);
+			ed_context_free_if_heap(args->context, args->deques[t].tiles);
+		}
+	}
+	ed_context_free_if_heap(args->context, args->row_done);
+	ed_context_free_if_heap(args->context, args->row_next);
+	ed_context_free_if_heap(args->context, args->row_end);
+	ed_context_free_if_heap(args->context, args->deques);
+	ed_context_free_if_heap(args->context, args->corners);
+}
+
+/*
+* Pinned mode: picks every worker's CPU and pins the pool to them. Falls
+* back to unpinned runs if the topology cannot be read.
+* Returns -1 if memory could not be allocated.
+*/
+static int setup_affinity(ThreadArguments *args){
+	EdContext *context = args->context;
+	int *cpus = ed_context_alloc_or_malloc(context, args->num_threads * sizeof(int));
+	args->thread_nodes = ed_context_alloc_or_malloc(context, args->num_threads * sizeof(int));
+	if(cpus == NULL || args->thread_nodes == NULL){
+		ed_context_free_if_heap(context, cpus);
+		return -1;
+	}
+
+	/*
+	* A context works the placement out once per thread count.
+	*/
+	int placed;
+	if(context != NULL){
+		const int *cached_cpus, *cached_nodes;
+		placed = ed_context_placement(context, args->num_threads, &cached_cpus, &cached_nodes);
+		if(placed == 0){
+			memcpy(cpus, cached_cpus, args->num_threads * sizeof(int));
+			memcpy(args->thread_nodes, cached_nodes, args->num_threads * sizeof(int));
+		}
+	}
+	else{
+		placed = cpu_topology_place(args->num_threads, cpus, args->thread_nodes);
+	}
+	if(placed < 0){
+		ed_context_free_if_heap(context, cpus);
+		ed_context_free_if_heap(context, args->thread_nodes);
+		args->thread_nodes = NULL;
+		return 0;
+	}
+	worker_pool_set_affinity(args->pool, cpus);
+	args->pinned = 1;
+	ed_context_free_if_heap(context, cpus);
+	return 0;
+}
+
+/*
+* Boundary arrays of the given size in bytes. In pinned mode they come straight from
+* mmap(), so none of their pages has been touched when the workers write
+* their segments (malloc() may return memory this thread already touched).
+* A context's arena is also mapped untouched, and its pages stay where
+* the first call's workers put them.
+*/
+static void *alloc_bounds(EdContext *context, size_t bytes, int pinned){
+	if(context != NULL){
+		return ed_context_alloc(context, bytes);
+	}
+	if(!pinned){
+		return malloc(bytes);
+	}
+	void *bounds = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	return (bounds == MAP_FAILED) ? NULL : bounds;
+}
+
+static void free_bounds(EdContext *context, void *bounds, size_t bytes, int pinned){
+	if(bounds == NULL || context != NULL){
+		return;
+	}
+	if(pinned){
+		munmap(bounds, bytes);
+	}
+	else{
+		free(bounds);
+	}
+}
+
+/*
+* Tile shape for a len1 x len2 matrix. Tiles are block_size x block_size
+* unless that leaves fewer than TILES_PER_THREAD tiles per thread along
+* one side: at most min(rows, cols) tiles can run at once, so for a
+* tall-skinny matrix the short side is cut into narrower tiles (never
+* below MIN_TILE_SIZE) to keep every worker busy.
+*/
+static int choose_tile_size(size_t len, size_t other_len, int block_size, long num_threads){
+	if(num_threads <= 1 || len >= other_len){
+		return block_size;
+	}
+	size_t wanted = (len + TILES_PER_THREAD * num_threads - 1) / (TILES_PER_THREAD * num_threads);
+	if(wanted < MIN_TILE_SIZE){
+		wanted = MIN_TILE_SIZE;
+	}
+	return (wanted < (size_t)block_size) ? (int)wanted : block_size;
+}
+
+long wavefront_edit_distance(const char *str1, const char *str2, size_t len,
+	long num_threads, int block_size, TileKernel kernel, size_t scratch_size,
+	const WavefrontOptions *options){
+	return wavefront_edit_distance_rect(str1, len, str2, len, num_threads,
+		block_size, kernel, scratch_size, options);
+}
+
+long wavefront_edit_distance_rect(const char *str1, size_t len1, const char *str2,
+	size_t len2, long num_threads, int block_size, TileKernel kernel,
+	size_t scratch_size, const WavefrontOptions *options){
+
+	WavefrontSchedule schedule = (options != NULL) ? options->schedule : WAVEFRONT_SCHEDULE_DATAFLOW;
+	int bounded = (options != NULL) && options->bounded;
+	int max_distance = (bounded && options->max_distance > 0) ? options->max_distance : 0;
+	if(max_distance > BOUNDED_MAX_DISTANCE){
+		max_distance = BOUNDED_MAX_DISTANCE;
+	}
+	int limit = max_distance + 1;
+	const char *checkpoint_path = (!bounded && options != NULL) ? options->checkpoint_path : NULL;
+	if(checkpoint_path != NULL){
+		schedule = WAVEFRONT_SCHEDULE_BARRIER;
+	}
+
+	/*
+	* Near-identical pairs only need the matrix between their first and
+	* last difference. The last row and segment maps refer to the whole
+	* strings, so those runs keep them.
+	*/
+	if(options == NULL || (options->last_row == NULL && options->segments1 == NULL
+		&& options->segments2 == NULL)){
+		strip_common_affixes(&str1, &len1, &str2, &len2, NULL, NULL);
+	}
+
+	/*
+	* An empty side leaves only insertions or deletions. In bounded mode the
+	* length difference alone can already rule the pair out, and then the
+	* last cell is not even inside the band.
+	*/
+	size_t length_difference = (len1 > len2) ? (len1 - len2) : (len2 - len1);
+	if(bounded && length_difference > (size_t)max_distance){
+		return limit;
+	}
+	if(len1 < 1 || len2 < 1){
+		if(!bounded && options != NULL && options->last_row != NULL){
+			for(size_t j = 0; j <= len2; j++){
+				options->last_row[j] = len1 + j;
+			}
+		}
+		if(options != NULL && options->stats != NULL){
+			memset(options->stats, 0, sizeof(WavefrontStats));
+		}
+		return (long)length_difference;
+	}
+
+	/*
+	* Allocate the global boundaries arrays (holds the numbers future
+	* process_tile calls will need).
+	* The barrier schedule uses triple buffering to guarantee disjoint
+	* memory access; the dataflow schedule only needs one row buffer.
+	*/
+	int pinned = (options != NULL && options->affinity == WAVEFRONT_AFFINITY_PINNED);
+	EdContext *context = (options != NULL) ? options->context : NULL;
+	if(context != NULL){
+		ed_context_reset(context);
+	}
+	uint64_t alloc_start = trace_now();
+	int wide = !bounded && boundary_is_wide(len1, len2);
+	size_t row_bytes = (len2 + 1) * boundary_entry_size(wide);
+	size_t col_bytes = (len1 + 1) * boundary_entry_size(wide);
+	int num_row_buffers = (schedule == WAVEFRONT_SCHEDULE_BARRIER) ? 3 : 1;
+	void *row_bounds[3] = {NULL, NULL, NULL};
+	for(int i = 0; i < num_row_buffers; i++){
+		row_bounds[i] = alloc_bounds(context, row_bytes, pinned);
+	}
+	void *col_bounds = alloc_bounds(context, col_bytes, pinned);
+	int alloc_failed = (col_bounds == NULL);
+	for(int i = 0; i < num_row_buffers; i++){
+		alloc_failed |= (row_bounds[i] == NULL);
+	}
+	if(alloc_failed){
+		for(int i = 0; i < 3; i++){
+			free_bounds(context, row_bounds[i], row_bytes, pinned);
+		}
+		free_bounds(context, col_bounds, col_bytes, pinned);
+		return -1;
+	}
+	trace_record(0, TRACE_ALLOC, alloc_start, (long)(num_row_buffers * row_bytes + col_bytes), 0);
+
+	/*
+	* Start the workers once for the whole call instead of creating and
+	* joining them for every wave (or once for all calls, with a context).
+	*/
+	WorkerPool *pool = (context != NULL) ? ed_context_pool(context, num_threads)
+		: worker_pool_create(num_threads);
+	if(pool == NULL){
+		for(int i = 0; i < 3; i++){
+			free_bounds(context, row_bounds[i], row_bytes, pinned);
+		}
+		free_bounds(context, col_bounds, col_bytes, pinned);
+		return -1;
+	}
+
+	ThreadArguments args = {0};
+	args.pool = pool;
+	args.context = context;
+	args.num_threads = worker_pool_size(pool);
+	int tile_height = block_size;
+	int tile_width = block_size;
+	if(options != NULL && options->tile_height > 0 && options->tile_height < block_size){
+		tile_height = options->tile_height;
+	}
+	if(options != NULL && options->tile_width > 0 && options->tile_width < block_size){
+		tile_width = options->tile_width;
+	}
+	args.tile_height = choose_tile_size(len1, len2, tile_height, args.num_threads);
+	args.tile_width = choose_tile_size(len2, len1, tile_width, args.num_threads);
+
+	/*
+	* A resumed run keeps the tiles of the run it continues, whatever the
+	* tuned shape is by now.
+	*/
+	int status = 0;
+	if(checkpoint_path != NULL && options->resume){
+		CheckpointHeader header;
+		int found = checkpoint_read_header(checkpoint_path, &header);
+		if(found > 0 && header.tile_height <= (uint32_t)block_size && header.tile_width <= (uint32_t)block_size
+			&& header.tile_height > 0 && header.tile_width > 0){
+			args.tile_height = header.tile_height;
+			args.tile_width = header.tile_width;
+		}
+		else if(found != 0){
+			printf("The checkpoint %s does not fit this engine.\n", checkpoint_path);
+			status = -1;
+		}
+	}
+	args.row_blocks = (len1 + args.tile_height - 1) / args.tile_height;
+	args.col_blocks = (len2 + args.tile_width - 1) / args.tile_width;
+	args.schedule = schedule;
+	args.bounded = bounded;
+	args.max_distance = max_distance;
+	args.wide = wide;
+	for(int k = 0; k < 3; k++){
+		args.global_rows[k] = wide ? NULL : row_bounds[k];
+		args.wide_rows[k] = wide ? row_bounds[k] : NULL;
+	}
+	args.global_cols = wide ? NULL : col_bounds;
+	args.wide_cols = wide ? col_bounds : NULL;
+	args.len1 = len1;
+	args.len2 = len2;
+	args.str1 = str1;
+	args.str2 = str2;
+	args.process_tile = kernel;
+	if(options != NULL){
+		args.segments1 = options->segments1;
+		args.segments2 = options->segments2;
+	}
+	args.gather_offset = (scratch_size + GATHER_PADDING - 1) / GATHER_PADDING * GATHER_PADDING;
+	if(args.segments1 != NULL || args.segments2 != NULL){
+		scratch_size = args.gather_offset + args.tile_height + args.tile_width + 2 * GATHER_PADDING;
+	}
+	args.wide_offset = (scratch_size + GATHER_PADDING - 1) / GATHER_PADDING * GATHER_PADDING;
+	if(wide){
+		scratch_size = args.wide_offset + (args.tile_height + args.tile_width + 2) * sizeof(int);
+	}
+	args.busy_ms = ed_context_alloc_zeroed_or_calloc(context, args.num_threads, sizeof(double));
+	args.steals = ed_context_alloc_zeroed_or_calloc(context, args.num_threads, sizeof(long));
+
+	if(args.busy_ms == NULL || args.steals == NULL){
+		status = -1;
+	}
+	if(status == 0 && pinned){
+		status = setup_affinity(&args);
+	}
+	if(!args.pinned){
+		// A context's pool may still be pinned from an earlier call
+		worker_pool_set_affinity(pool, NULL);
+	}
+	if(status == 0){
+		status = setup_band(&args);
+	}
+	if(status == 0 && schedule == WAVEFRONT_SCHEDULE_DATAFLOW){
+		status = setup_dataflow(&args);
+	}
+	if(status == 0 && checkpoint_path != NULL){
+		uint64_t fingerprint = fingerprint_string(CHECKPOINT_FINGERPRINT_SEED, str1, args.segments1, len1);
+		fingerprint = fingerprint_string(fingerprint, str2, args.segments2, len2);
+		args.checkpointer = checkpointer_create(checkpoint_path, len1, len2, args.tile_height,
+			args.tile_width, boundary_entry_size(wide), fingerprint);
+		args.checkpoint_every = options->checkpoint_every;
+		status = (args.checkpointer != NULL) ? 0 : -1;
+	}
+
+	/*
+	* Pinned workers write the initial boundaries themselves (which also
+	* allocates their scratch where they run); otherwise this thread does.
+	*/
+	if(status == 0 && args.pinned){
+		status = worker_pool_run(pool, touch_worker, &args, scratch_size);
+	}
+	else if(status == 0){
+		init_row_bounds(&args, 0, len2);
+		init_col_bounds(&args, 0, len1);
+	}
+	if(status == 0 && checkpoint_path != NULL && options->resume){
+		long wave;
+		int loaded = checkpointer_load(args.checkpointer, &wave);
+		if(loaded > 0 && wave >= 0 && wave < args.row_blocks + args.col_blocks - 1){
+			copy_frontier(&args, wave, 0, 1, 1);
+			args.first_wave = wave + 1;
+		}
+		else if(loaded != 0){
+			status = -1;
+		}
+	}
+
+	double start = current_time_ms();
+	if(status == 0){
+		WorkerTask task = (schedule == WAVEFRONT_SCHEDULE_BARRIER) ? wave_worker : dataflow_worker;
+		status = worker_pool_run(pool, task, &args, scratch_size);
+		if(status != 0){
+			printf("Unable to allocate memory for a thread's buffer in wavefront_edit_distance().");
+		}
+	}
+	double end = current_time_ms();
+	if(context == NULL){
+		worker_pool_destroy(pool);
+	}
+
+	/*
+	* A completed run has nothing left to resume.
+	*/
+	long checkpoints = checkpointer_destroy(args.checkpointer);
+	if(status == 0 && checkpoint_path != NULL){
+		remove(checkpoint_path);
+	}
+
+	if(status == 0 && options != NULL && options->stats != NULL){
+		WavefrontStats *stats = options->stats;
+		stats->wall_ms = end - start;
+		stats->busy_ms = 0;
+		stats->steals = 0;
+		for(long t = 0; t < args.num_threads; t++){
+			stats->busy_ms += args.busy_ms[t];
+			stats->steals += args.steals[t];
+		}
+		stats->num_threads = args.num_threads;
+		stats->tiles = args.total_tiles;
+		stats->checkpoints = checkpoints;
+		stats->utilization = (stats->wall_ms > 0)
+		? stats->busy_ms / (stats->wall_ms * args.num_threads) : 0;
+	}
+
+	// Cleanup
+	int last_row = (schedule == WAVEFRONT_SCHEDULE_BARRIER) ? (args.row_blocks - 1) % 3 : 0;
+	long result = (status == 0) ? boundary_load(row_bounds[last_row], wide, len2) : -1;
+	if(status == 0 && bounded && (atomic_load(&args.aborted) || result > args.max_distance)){
+		result = limit;
+	}
+	if(status == 0 && !bounded && options != NULL && options->last_row != NULL){
+		// Kernels write bottom[1..width], so column 0 still holds row 0
+		for(size_t j = 1; j <= len2; j++){
+			options->last_row[j] = boundary_load(row_bounds[last_row], wide, j);
+		}
+		options->last_row[0] = len1;
+	}
+
+	cleanup_dataflow(&args);
+	ed_context_free_if_heap(context, args.row_min);
+	ed_context_free_if_heap(context, args.row_remaining);
+	ed_context_free_if_heap(context, args.busy_ms);
+	ed_context_free_if_heap(context, args.steals);
+	ed_context_free_if_heap(context, args.thread_nodes);
+	for(int i = 0; i < 3; i++){
+		free_bounds(context, row_bounds[i], row_bytes, pinned);
+	}
+	free_bounds(context, col_bounds, col_bytes, pinned);
+	return result;
+}
@@ -0,0 +1,383 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "src/worker_pool.h"
+#include "src/trace.h"
+#include "src/cpu_topology.h"
+
+/*
+* Number of times a thread polls the barrier before going to sleep on the
+* condition variable. Tiles in the same wave finish within a few
+* microseconds of each other, so most waits end while still spinning.
+* Pools with more threads than online processors never spin, since the
+* spinning thread would only steal time from the ones it is waiting on.
+*/
+#define BARRIER_SPIN_LIMIT 2048
+
+/*
+* Alignment of the per-worker scratch buffers (one cache line, also enough
+* for aligned AVX2/AVX-512 loads).
+*/
+#define SCRATCH_ALIGNMENT 64
+
+typedef struct {
+	WorkerPool *pool;
+	int thread_id;
+	pthread_t thread;
+	void *scratch;
+	size_t scratch_size;
+
+	/*
+	* CPU the worker should run on (-1: anywhere), the one it is pinned
+	* to right now, and the one its scratch was first touched on.
+	*/
+	int cpu;
+	int pinned_cpu;
+	int scratch_cpu;
+} WorkerSlot;
+
+struct WorkerPool {
+	long num_threads;
+	int spin_limit;
+	WorkerSlot *slots;
+	CpuMask allowed;	// affinity of the creating thread, restored on unpin
+
+	/*
+	* Job hand-off between worker_pool_run() and the sleeping workers.
+	* Protected by lock.
+	*/
+	pthread_mutex_t lock;
+	pthread_cond_t job_ready;
+	pthread_cond_t job_done;
+	unsigned long job_generation;
+	long workers_active;
+	int shutting_down;
+	WorkerTask task;
+	void *task_args;
+	size_t task_scratch_size;
+	atomic_int scratch_failed;
+
+	/*
+	* Sense-reversing barrier: the last thread to arrive resets the count
+	* and bumps the generation everyone else is waiting on.
+	*/
+	atomic_long barrier_count;
+	atomic_uint barrier_generation;
+	pthread_mutex_t barrier_lock;
+	pthread_cond_t barrier_cond;
+
+	/*
+	* Work notifications (see worker_pool_wait()): notify bumps the
+	* generation and only takes the lock when someone is asleep.
+	*/
+	atomic_uint work_generation;
+	atomic_int work_sleepers;
+	pthread_mutex_t work_lock;
+	pthread_cond_t work_cond;
+};
+
+static inline void cpu_relax(void){
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#endif
+}
+
+/*
+* Polls generation for up to spin_limit rounds, then sleeps on cond until
+* it differs from seen. sleepers, if not NULL, counts the threads asleep.
+*/
+static void wait_for_generation(WorkerPool *pool, atomic_uint *generation, unsigned int seen,
+	pthread_mutex_t *lock, pthread_cond_t *cond, atomic_int *sleepers){
+	for(int spin = 0; spin < pool->spin_limit; spin++){
+		if(atomic_load_explicit(generation, memory_order_acquire) != seen){
+			return;
+		}
+		cpu_relax();
+	}
+
+	pthread_mutex_lock(lock);
+	if(sleepers != NULL){
+		atomic_fetch_add(sleepers, 1);
+	}
+	while(atomic_load(generation) == seen){
+		pthread_cond_wait(cond, lock);
+	}
+	if(sleepers != NULL){
+		atomic_fetch_sub(sleepers, 1);
+	}
+	pthread_mutex_unlock(lock);
+}
+
+void worker_pool_barrier(WorkerPool *pool){
+	if(pool->num_threads == 1){
+		return;
+	}
+
+	unsigned int generation = atomic_load_explicit(&pool->barrier_generation, memory_order_acquire);
+	long arrived = atomic_fetch_add_explicit(&pool->barrier_count, 1, memory_order_acq_rel) + 1;
+
+	if(arrived == pool->num_threads){
+		/*
+		* Last one in. Reset the count before publishing the new generation
+		* so a thread that races ahead into the next barrier sees zero.
+		*/
+		atomic_store_explicit(&pool->barrier_count, 0, memory_order_relaxed);
+		pthread_mutex_lock(&pool->barrier_lock);
+		atomic_store_explicit(&pool->barrier_generation, generation + 1, memory_order_release);
+		pthread_cond_broadcast(&pool->barrier_cond);
+		pthread_mutex_unlock(&pool->barrier_lock);
+		return;
+	}
+
+	wait_for_generation(pool, &pool->barrier_generation, generation,
+		&pool->barrier_lock, &pool->barrier_cond, NULL);
+}
+
+unsigned int worker_pool_work_ticket(WorkerPool *pool){
+	return atomic_load(&pool->work_generation);
+}
+
+void worker_pool_wait(WorkerPool *pool, unsigned int ticket){
+	wait_for_generation(pool, &pool->work_generation, ticket,
+		&pool->work_lock, &pool->work_cond, &pool->work_sleepers);
+}
+
+/*
+* A waiter increments work_sleepers before it checks the generation and
+* this bumps the generation before it checks work_sleepers, so (both being
+* sequentially consistent) at least one of them sees the other.
+*/
+void worker_pool_notify(WorkerPool *pool){
+	atomic_fetch_add(&pool->work_generation, 1);
+	if(atomic_load(&pool->work_sleepers) > 0){
+		pthread_mutex_lock(&pool->work_lock);
+		pthread_cond_broadcast(&pool->work_cond);
+		pthread_mutex_unlock(&pool->work_lock);
+	}
+}
+
+/*
+* Moves the calling worker to the CPU it was assigned, or back to the
+* pool's original affinity if it was unpinned.
+*/
+static void apply_affinity(WorkerPool *pool, WorkerSlot *slot){
+	if(slot->cpu == slot->pinned_cpu){
+		return;
+	}
+	if(slot->cpu >= 0){
+		slot->pinned_cpu = (cpu_pin_current(slot->cpu) == 0) ? slot->cpu : -1;
+	}
+	else{
+		cpu_mask_set(&pool->allowed);
+		slot->pinned_cpu = -1;
+	}
+}
+
+/*
+* Pins the worker if needed, grows its scratch buffer if needed, then runs
+* the current task. The allocation happens on the worker's own (pinned)
+* thread and is zeroed there, so the pages are first-touched on the node
+* where they will be used. A pinned worker whose scratch was touched
+* elsewhere gets a new one.
+*/
+static void run_slot(WorkerPool *pool, WorkerSlot *slot){
+	apply_affinity(pool, slot);
+	size_t needed = pool->task_scratch_size;
+	if(slot->pinned_cpu >= 0 && slot->scratch_cpu != slot->pinned_cpu){
+		if(slot->scratch_size > needed){
+			needed = slot->scratch_size;
+		}
+		free(slot->scratch);
+		slot->scratch = NULL;
+		slot->scratch_size = 0;
+	}
+	if(slot->scratch_size < needed){
+		uint64_t alloc_start = trace_now();
+		free(slot->scratch);
+		slot->scratch = NULL;
+		slot->scratch_size = 0;
+
+		size_t rounded = (needed + SCRATCH_ALIGNMENT - 1) / SCRATCH_ALIGNMENT * SCRATCH_ALIGNMENT;
+		if(posix_memalign(&slot->scratch, SCRATCH_ALIGNMENT, rounded) == 0){
+			memset(slot->scratch, 0, rounded);
+			slot->scratch_size = rounded;
+			slot->scratch_cpu = slot->pinned_cpu;
+			trace_record(slot->thread_id, TRACE_ALLOC, alloc_start, (long)rounded, 0);
+		}
+		else{
+			slot->scratch = NULL;
+			atomic_store(&pool->scratch_failed, 1);
+		}
+	}
+
+	/*
+	* Every worker has to reach this point before anyone can tell whether
+	* the run is allowed to go ahead.
+	*/
+	worker_pool_barrier(pool);
+	if(atomic_load(&pool->scratch_failed)){
+		return;
+	}
+	pool->task(pool->task_args, slot->thread_id, slot->scratch);
+}
+
+/*
+* The start_routine function for pthread_create(). Sleeps until a new job
+* is published, runs it, and reports back.
+*/
+static void *pool_worker(void *args){
+	WorkerSlot *slot = (WorkerSlot*)args;
+	WorkerPool *pool = slot->pool;
+	unsigned long seen_generation = 0;
+
+	for(;;){
+		pthread_mutex_lock(&pool->lock);
+		while(pool->job_generation == seen_generation && !pool->shutting_down){
+			pthread_cond_wait(&pool->job_ready, &pool->lock);
+		}
+		if(pool->shutting_down){
+			pthread_mutex_unlock(&pool->lock);
+			return NULL;
+		}
+		seen_generation = pool->job_generation;
+		pthread_mutex_unlock(&pool->lock);
+
+		run_slot(pool, slot);
+
+		pthread_mutex_lock(&pool->lock);
+		pool->workers_active--;
+		if(pool->workers_active == 0){
+			pthread_cond_signal(&pool->job_done);
+		}
+		pthread_mutex_unlock(&pool->lock);
+	}
+}
+
+WorkerPool *worker_pool_create(long num_threads){
+	if(num_threads < 1){
+		num_threads = 1;
+	}
+
+	WorkerPool *pool = calloc(1, sizeof(WorkerPool));
+	WorkerSlot *slots = calloc(num_threads, sizeof(WorkerSlot));
+	if(pool == NULL || slots == NULL){
+		printf("Failed to allocate memory for the worker pool.");
+		free(pool);
+		free(slots);
+		return NULL;
+	}
+
+	pool->num_threads = num_threads;
+	pool->slots = slots;
+	long num_processors = sysconf(_SC_NPROCESSORS_ONLN);
+	pool->spin_limit = (num_processors >= num_threads) ? BARRIER_SPIN_LIMIT : 0;
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->job_ready, NULL);
+	pthread_cond_init(&pool->job_done, NULL);
+	pthread_mutex_init(&pool->barrier_lock, NULL);
+	pthread_cond_init(&pool->barrier_cond, NULL);
+	pthread_mutex_init(&pool->work_lock, NULL);
+	pthread_cond_init(&pool->work_cond, NULL);
+	atomic_init(&pool->scratch_failed, 0);
+	atomic_init(&pool->barrier_count, 0);
+	atomic_init(&pool->barrier_generation, 0);
+	atomic_init(&pool->work_generation, 0);
+	atomic_init(&pool->work_sleepers, 0);
+
+	cpu_mask_get(&pool->allowed);
+	for(long t = 0; t < num_threads; t++){
+		slots[t].pool = pool;
+		slots[t].thread_id = t;
+		slots[t].cpu = -1;
+		slots[t].pinned_cpu = -1;
+		slots[t].scratch_cpu = -1;
+	}
+
+	/*
+	* Worker 0 is whichever thread calls worker_pool_run(), so only
+	* num_threads - 1 threads are started here.
+	*/
+	for(long t = 1; t < num_threads; t++){
+		if(pthread_create(&slots[t].thread, NULL, pool_worker, &slots[t]) != 0){
+			printf("Failed to start worker thread %ld.", t);
+			pool->num_threads = t;
+			worker_pool_destroy(pool);
+			return NULL;
+		}
+	}
+	return pool;
+}
+
+int worker_pool_run(WorkerPool *pool, WorkerTask task, void *task_args, size_t scratch_size){
+	pthread_mutex_lock(&pool->lock);
+	pool->task = task;
+	pool->task_args = task_args;
+	pool->task_scratch_size = scratch_size;
+	atomic_store(&pool->scratch_failed, 0);
+	pool->workers_active = pool->num_threads - 1;
+	pool->job_generation++;
+	pthread_cond_broadcast(&pool->job_ready);
+	pthread_mutex_unlock(&pool->lock);
+
+	/*
+	* Worker 0 is the caller's thread, so its own affinity is put back
+	* once the run is over.
+	*/
+	CpuMask caller_mask;
+	int restore = (pool->slots[0].cpu >= 0 && cpu_mask_get(&caller_mask) == 0);
+	run_slot(pool, &pool->slots[0]);
+
+	pthread_mutex_lock(&pool->lock);
+	while(pool->workers_active > 0){
+		pthread_cond_wait(&pool->job_done, &pool->lock);
+	}
+	pthread_mutex_unlock(&pool->lock);
+	if(restore){
+		cpu_mask_set(&caller_mask);
+		pool->slots[0].pinned_cpu = -1;
+	}
+
+	return atomic_load(&pool->scratch_failed) ? -1 : 0;
+}
+
+void worker_pool_set_affinity(WorkerPool *pool, const int *cpus){
+	for(long t = 0; t < pool->num_threads; t++){
+		pool->slots[t].cpu = (cpus != NULL) ? cpus[t] : -1;
+	}
+}
+
+long worker_pool_size(const WorkerPool *pool){
+	return pool->num_threads;
+}
+
+void worker_pool_destroy(WorkerPool *pool){
+	if(pool == NULL){
+		return;
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	pool->shutting_down = 1;
+	pthread_cond_broadcast(&pool->job_ready);
+	pthread_mutex_unlock(&pool->lock);
+
+	for(long t = 1; t < pool->num_threads; t++){
+		pthread_join(pool->slots[t].thread, NULL);
+	}
+	for(long t = 0; t < pool->num_threads; t++){
+		free(pool->slots[t].scratch);
+	}
+
+	pthread_mutex_destroy(&pool->lock);
+	pthread_cond_destroy(&pool->job_ready);
+	pthread_cond_destroy(&pool->job_done);
+	pthread_mutex_destroy(&pool->barrier_lock);
+	pthread_cond_destroy(&pool->barrier_cond);
+	pthread_mutex_destroy(&pool->work_lock);
+	pthread_cond_destroy(&pool->work_cond);
+	free(pool->slots);
+	free(pool);
+}